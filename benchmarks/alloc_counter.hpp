@@ -0,0 +1,48 @@
+#pragma once
+// Global allocation counter for benchmarks
+// Replaces the global operator new/delete, so include this header from
+// exactly one translation unit of a benchmark executable.
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace bench {
+    inline std::atomic<size_t> allocation_count{0};
+
+    // Count heap allocations made while running fn
+    template <typename Fn>
+    size_t count_allocations(Fn&& fn) {
+        size_t before = allocation_count.load(std::memory_order_relaxed);
+        fn();
+        return allocation_count.load(std::memory_order_relaxed) - before;
+    }
+}
+
+void* operator new(std::size_t size) {
+    bench::allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
@@ -0,0 +1,133 @@
+// Start-up and steady-state cost of a compiled template artifact: parsing the
+// template text and compiling it versus mapping an artifact file, and
+// rendering and applying through CompiledTemplate versus TemplateArtifact
+#include <permuto/permuto.hpp>
+#include "bench_common.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+    const int TOOL_COUNT = 300;
+    const size_t STARTUP_ITERATIONS = 200;
+    const size_t RENDER_ITERATIONS = 2000;
+
+    // Agent request template with a large catalogue of tool definitions
+    nlohmann::json build_template() {
+        nlohmann::json template_json = R"({
+            "model": "${/model}",
+            "max_tokens": 1024,
+            "system": "You are a support assistant for ${/store/name}.",
+            "messages": "${/history}",
+            "metadata": {"user_id": "${/user/id}", "tier": "${/user/tier}"}
+        })"_json;
+        for (int i = 0; i < TOOL_COUNT; ++i) {
+            std::string name = "tool_" + std::to_string(i);
+            template_json["tools"].push_back({
+                {"name", name},
+                {"description", "Runs " + name + " on behalf of ${/user/name} in ${/store/region}"},
+                {"input_schema", {
+                    {"type", "object"},
+                    {"properties", {
+                        {"id", {{"type", "string"}, {"description", "Identifier passed to " + name}}},
+                        {"limit", {{"type", "integer"}, {"default", 10 + i % 5}}}
+                    }},
+                    {"required", {"id"}}
+                }},
+                {"enabled", i % 3 != 0},
+                {"owner", "${/user/id}"}
+            });
+        }
+        return template_json;
+    }
+
+    nlohmann::json build_context() {
+        return R"({
+            "model": "claude-3-sonnet-20240229",
+            "store": {"name": "Example Store", "region": "eu-west"},
+            "user": {"name": "Alice", "id": 123, "tier": "premium"},
+            "history": [{"role": "user", "content": "Where is my order?"}]
+        })"_json;
+    }
+}
+
+int main() {
+    permuto::Options opts;
+    opts.enable_interpolation = true;
+
+    nlohmann::json template_json = build_template();
+    nlohmann::json context = build_context();
+    std::string template_text = template_json.dump();
+    std::string artifact_bytes = permuto::TemplateArtifact::serialize(template_json, opts);
+
+    std::string path = (std::filesystem::temp_directory_path() / "permuto_bench_artifact.ptc").string();
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(artifact_bytes.data(), static_cast<std::streamsize>(artifact_bytes.size()));
+    }
+
+    std::string output;
+    permuto::StringSink sink(output);
+
+    // Everything a fresh process does before its first response
+    auto parse_and_compile = [&]() {
+        output.clear();
+        permuto::CompiledTemplate compiled(nlohmann::json::parse(template_text), opts);
+        compiled.render(context, sink);
+        bench::sink = bench::sink + output.size();
+    };
+    auto view_artifact = [&]() {
+        output.clear();
+        permuto::TemplateArtifact::view(artifact_bytes).render(context, sink);
+        bench::sink = bench::sink + output.size();
+    };
+    auto open_artifact = [&]() {
+        output.clear();
+        permuto::TemplateArtifact::open(path).render(context, sink);
+        bench::sink = bench::sink + output.size();
+    };
+
+    double compile_ns = bench::measure_ns(STARTUP_ITERATIONS, parse_and_compile);
+    double view_ns = bench::measure_ns(STARTUP_ITERATIONS, view_artifact);
+    double open_ns = bench::measure_ns(STARTUP_ITERATIONS, open_artifact);
+
+    bench::print_header("Load and first render (" + std::to_string(template_text.size()) + " bytes of JSON, " +
+                        std::to_string(artifact_bytes.size()) + " bytes of artifact)");
+    bench::print_row("parse + CompiledTemplate", compile_ns, compile_ns);
+    bench::print_row("TemplateArtifact::view()", view_ns, compile_ns);
+    bench::print_row("TemplateArtifact::open()", open_ns, compile_ns);
+
+    // Loaded once, rendered per request
+    permuto::CompiledTemplate compiled(template_json, opts);
+    permuto::TemplateArtifact artifact = permuto::TemplateArtifact::open(path);
+
+    double compiled_ns = bench::measure_ns(RENDER_ITERATIONS, [&]() {
+        output.clear();
+        compiled.render(context, sink);
+        bench::sink = bench::sink + output.size();
+    });
+    double artifact_ns = bench::measure_ns(RENDER_ITERATIONS, [&]() {
+        output.clear();
+        artifact.render(context, sink);
+        bench::sink = bench::sink + output.size();
+    });
+
+    bench::print_header("Render, template loaded");
+    bench::print_row("CompiledTemplate::render()", compiled_ns, compiled_ns);
+    bench::print_row("TemplateArtifact::render()", artifact_ns, compiled_ns);
+
+    double compiled_apply_ns = bench::measure_ns(RENDER_ITERATIONS, [&]() {
+        bench::sink = bench::sink + compiled.apply(context).size();
+    });
+    double artifact_apply_ns = bench::measure_ns(RENDER_ITERATIONS, [&]() {
+        bench::sink = bench::sink + artifact.apply(context).size();
+    });
+
+    bench::print_header("Apply, template loaded");
+    bench::print_row("CompiledTemplate::apply()", compiled_apply_ns, compiled_apply_ns);
+    bench::print_row("TemplateArtifact::apply()", artifact_apply_ns, compiled_apply_ns);
+
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,82 @@
+// apply_batch scaling from one thread to one per hardware thread
+#include <permuto/permuto.hpp>
+#include "bench_common.hpp"
+#include <thread>
+
+namespace {
+    const int CONTEXT_COUNT = 4000;
+    const size_t ITERATIONS = 5;
+
+    nlohmann::json build_template() {
+        nlohmann::json messages = nlohmann::json::array();
+        messages.push_back({{"role", "system"}, {"content", "You are a support assistant for ${/store/name}."}});
+        for (int i = 0; i < 10; ++i) {
+            messages.push_back({{"role", "user"}, {"content", "${/history/" + std::to_string(i) + "}"}});
+        }
+        return {
+            {"model", "${/model}"},
+            {"user", "${/user}"},
+            {"messages", messages},
+            {"greeting", "Hello ${/user/name}, your order ${/order/id} ships ${/order/eta}."}
+        };
+    }
+
+    nlohmann::json build_context(int id) {
+        nlohmann::json context;
+        context["model"] = "gpt-4";
+        context["store"]["name"] = "Example Store";
+        context["user"] = {{"name", "User " + std::to_string(id)}, {"id", id}, {"tier", "basic"}};
+        context["order"] = {{"id", "ORD-" + std::to_string(100000 + id)}, {"eta", "tomorrow"}};
+        for (int i = 0; i < 10; ++i) {
+            context["history"].push_back("Message " + std::to_string(i) + " from user " + std::to_string(id));
+        }
+        return context;
+    }
+}
+
+int main() {
+    permuto::Options opts;
+    opts.enable_interpolation = true;
+    nlohmann::json template_json = build_template();
+
+    std::vector<nlohmann::json> contexts;
+    for (int id = 0; id < CONTEXT_COUNT; ++id) {
+        contexts.push_back(build_context(id));
+    }
+
+    permuto::CompiledTemplate compiled(template_json, opts);
+    // Baselines keep every result alive, like a batch does
+    double serial_ns = bench::measure_ns(ITERATIONS, [&]() {
+        std::vector<nlohmann::json> results;
+        results.reserve(contexts.size());
+        for (const auto& context : contexts) {
+            results.push_back(permuto::apply(template_json, context, opts));
+        }
+        bench::sink = bench::sink + results.size();
+    });
+    double compiled_ns = bench::measure_ns(ITERATIONS, [&]() {
+        std::vector<nlohmann::json> results;
+        results.reserve(contexts.size());
+        for (const auto& context : contexts) {
+            results.push_back(compiled.apply(context));
+        }
+        bench::sink = bench::sink + results.size();
+    });
+
+    size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    bench::print_header(std::to_string(CONTEXT_COUNT) + " contexts, " +
+                        std::to_string(max_threads) + " hardware threads");
+    bench::print_row("apply() loop", serial_ns, serial_ns);
+    bench::print_row("CompiledTemplate::apply() loop", compiled_ns, serial_ns);
+
+    for (size_t threads = 1; threads <= std::max<size_t>(max_threads, 4); threads *= 2) {
+        permuto::BatchOptions batch_opts;
+        batch_opts.threads = threads;
+        double ns = bench::measure_ns(ITERATIONS, [&]() {
+            bench::sink = bench::sink + permuto::apply_batch(compiled, contexts, batch_opts).size();
+        });
+        bench::print_row("apply_batch, " + std::to_string(threads) + " threads", ns, serial_ns);
+    }
+
+    return 0;
+}
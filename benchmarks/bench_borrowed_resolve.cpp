@@ -0,0 +1,96 @@
+// Counts heap allocations for placeholders that substitute large context subtrees
+#include <permuto/permuto.hpp>
+#include "alloc_counter.hpp"
+#include "bench_common.hpp"
+
+namespace {
+    const int MESSAGE_COUNT = 200;
+    const int PREFERENCE_COUNT = 50;
+    const size_t ITERATIONS = 2000;
+
+    nlohmann::json build_context() {
+        nlohmann::json context;
+        for (int i = 0; i < MESSAGE_COUNT; ++i) {
+            context["messages"].push_back({
+                {"role", i % 2 == 0 ? "user" : "assistant"},
+                {"content", "Chat history message number " + std::to_string(i) +
+                            " with enough text to need a heap allocation"}
+            });
+        }
+        for (int i = 0; i < PREFERENCE_COUNT; ++i) {
+            context["preferences"]["option_" + std::to_string(i)] = "setting value " + std::to_string(i);
+        }
+        context["model"] = "gpt-4";
+        return context;
+    }
+
+    void report(const std::string& name, size_t allocations, size_t baseline, double ns) {
+        std::cout << std::left << std::setw(36) << name
+                  << std::right << std::setw(14) << allocations
+                  << std::setw(13) << std::fixed << std::setprecision(2)
+                  << static_cast<double>(allocations) / static_cast<double>(baseline) << "x"
+                  << std::setw(14) << std::setprecision(1) << ns << "\n";
+    }
+}
+
+int main() {
+    nlohmann::json context = build_context();
+    nlohmann::json template_json = R"({
+        "model": "${/model}",
+        "messages": "${/messages}",
+        "settings": "${/preferences}"
+    })"_json;
+
+    // The unavoidable cost: one deep copy of each substituted subtree
+    size_t single_copy = bench::count_allocations([&]() {
+        nlohmann::json messages = context["messages"];
+        nlohmann::json preferences = context["preferences"];
+        nlohmann::json model = context["model"];
+        bench::sink = bench::sink + messages.size() + preferences.size() + model.size();
+    });
+
+    std::cout << "\nLarge-subtree substitution (" << MESSAGE_COUNT << " messages, "
+              << PREFERENCE_COUNT << " preferences)\n";
+    std::cout << std::left << std::setw(36) << "case"
+              << std::right << std::setw(14) << "allocs/op"
+              << std::setw(14) << "vs 1 copy"
+              << std::setw(14) << "ns/op" << "\n";
+
+    double copy_ns = bench::measure_ns(ITERATIONS, [&]() {
+        nlohmann::json messages = context["messages"];
+        nlohmann::json preferences = context["preferences"];
+        bench::sink = bench::sink + messages.size() + preferences.size();
+    });
+    report("single deep copy (lower bound)", single_copy, single_copy, copy_ns);
+
+    size_t apply_allocs = bench::count_allocations([&]() {
+        bench::sink = bench::sink + permuto::apply(template_json, context).size();
+    });
+    double apply_ns = bench::measure_ns(ITERATIONS, [&]() {
+        bench::sink = bench::sink + permuto::apply(template_json, context).size();
+    });
+    report("permuto::apply", apply_allocs, single_copy, apply_ns);
+
+    permuto::CompiledTemplate compiled(template_json);
+    size_t compiled_allocs = bench::count_allocations([&]() {
+        bench::sink = bench::sink + compiled.apply(context).size();
+    });
+    double compiled_ns = bench::measure_ns(ITERATIONS, [&]() {
+        bench::sink = bench::sink + compiled.apply(context).size();
+    });
+    report("CompiledTemplate::apply", compiled_allocs, single_copy, compiled_ns);
+
+    // Consuming overload: the per-request context is handed over and moved;
+    // its time includes building the per-request context copy
+    nlohmann::json owned = context;
+    size_t rvalue_allocs = bench::count_allocations([&]() {
+        bench::sink = bench::sink + permuto::apply(template_json, std::move(owned)).size();
+    });
+    double rvalue_ns = bench::measure_ns(ITERATIONS, [&]() {
+        nlohmann::json per_request = context;
+        bench::sink = bench::sink + permuto::apply(template_json, std::move(per_request)).size();
+    });
+    report("apply(rvalue context) + ctx build", rvalue_allocs, single_copy, rvalue_ns);
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace bench {
+    namespace {
+        const size_t WARMUP_DIVISOR = 10;
+        const int NAME_WIDTH = 36;
+        const int VALUE_WIDTH = 14;
+    }
+
+    // Keeps results observable so the optimizer cannot drop benchmarked work
+    inline volatile size_t sink = 0;
+
+    // Run fn repeatedly and return the mean wall time per call in nanoseconds
+    template <typename Fn>
+    double measure_ns(size_t iterations, Fn&& fn) {
+        for (size_t i = 0; i < iterations / WARMUP_DIVISOR; ++i) {
+            fn();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            fn();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        auto total = std::chrono::duration<double, std::nano>(end - start).count();
+        return total / static_cast<double>(iterations);
+    }
+
+    inline void print_header(const std::string& title) {
+        std::cout << "\n" << title << "\n";
+        std::cout << std::left << std::setw(NAME_WIDTH) << "case"
+                  << std::right << std::setw(VALUE_WIDTH) << "ns/op"
+                  << std::setw(VALUE_WIDTH) << "speedup" << "\n";
+    }
+
+    // Print one result row; speedup is relative to baseline_ns
+    inline void print_row(const std::string& name, double ns, double baseline_ns) {
+        std::cout << std::left << std::setw(NAME_WIDTH) << name
+                  << std::right << std::setw(VALUE_WIDTH) << std::fixed << std::setprecision(1) << ns
+                  << std::setw(VALUE_WIDTH - 1) << std::setprecision(2) << (baseline_ns / ns) << "x\n";
+    }
+}
@@ -0,0 +1,75 @@
+// Compares permuto::apply() against a precompiled CompiledTemplate
+#include <permuto/permuto.hpp>
+#include "bench_common.hpp"
+
+namespace {
+    const int FIELD_COUNT = 100;
+    const size_t ITERATIONS = 20000;
+    const int MESSAGE_COUNT = 20;
+
+    // Same shape as the PerformanceBaseline integration test
+    void build_baseline(nlohmann::json& template_json, nlohmann::json& context) {
+        template_json = nlohmann::json::object();
+        context = nlohmann::json::object();
+        for (int i = 0; i < FIELD_COUNT; ++i) {
+            std::string key = "field_" + std::to_string(i);
+            template_json[key] = "${/data/" + key + "}";
+            context["data"][key] = "value_" + std::to_string(i);
+        }
+    }
+
+    // Literal-heavy LLM payload with a handful of placeholders
+    void build_llm_payload(nlohmann::json& template_json, nlohmann::json& context) {
+        template_json = {
+            {"model", "${/config/model}"},
+            {"temperature", "${/config/temperature}"},
+            {"max_tokens", "${/config/max_tokens}"},
+            {"messages", nlohmann::json::array()}
+        };
+        for (int i = 0; i < MESSAGE_COUNT; ++i) {
+            template_json["messages"].push_back({
+                {"role", i % 2 == 0 ? "user" : "assistant"},
+                {"content", "Static few-shot example message number " + std::to_string(i)}
+            });
+        }
+        template_json["messages"].push_back({{"role", "user"}, {"content", "${/prompt}"}});
+
+        context = {
+            {"config", {{"model", "gpt-4"}, {"temperature", 0.7}, {"max_tokens", 1000}}},
+            {"prompt", "Explain quantum computing"}
+        };
+    }
+
+    void run_case(const std::string& title, const nlohmann::json& template_json,
+                  const nlohmann::json& context, const permuto::Options& options) {
+        bench::print_header(title);
+
+        double apply_ns = bench::measure_ns(ITERATIONS, [&]() {
+            bench::sink = bench::sink + permuto::apply(template_json, context, options).size();
+        });
+        bench::print_row("permuto::apply", apply_ns, apply_ns);
+
+        permuto::CompiledTemplate compiled(template_json, options);
+        double compiled_ns = bench::measure_ns(ITERATIONS, [&]() {
+            bench::sink = bench::sink + compiled.apply(context).size();
+        });
+        bench::print_row("CompiledTemplate::apply", compiled_ns, apply_ns);
+    }
+}
+
+int main() {
+    nlohmann::json template_json;
+    nlohmann::json context;
+    permuto::Options options;
+
+    build_baseline(template_json, context);
+    run_case("PerformanceBaseline (100 exact placeholders)", template_json, context, options);
+
+    build_llm_payload(template_json, context);
+    run_case("LLM payload (literal-heavy)", template_json, context, options);
+
+    options.enable_interpolation = true;
+    run_case("LLM payload with interpolation enabled", template_json, context, options);
+
+    return 0;
+}
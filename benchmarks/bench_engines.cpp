@@ -0,0 +1,51 @@
+// Recursive vs iterative engine at increasing template depth
+#include <permuto/permuto.hpp>
+#include "bench_common.hpp"
+
+namespace {
+    const size_t DEPTHS[] = {10, 100, 10000};
+    const size_t NODES_PER_TEMPLATE = 60000;
+    const size_t ITERATIONS = 10;
+
+    // Chains of alternating objects and arrays, about NODES_PER_TEMPLATE nodes in total
+    nlohmann::json build_template(size_t depth) {
+        nlohmann::json chains = nlohmann::json::array();
+        size_t chain_count = std::max<size_t>(1, NODES_PER_TEMPLATE / (2 * depth));
+        for (size_t c = 0; c < chain_count; ++c) {
+            nlohmann::json node = "${/user/name}";
+            for (size_t d = 1; d < depth; ++d) {
+                if (d % 2 == 0) {
+                    node = {{"child", std::move(node)}, {"id", "${/user/id}"}};
+                } else {
+                    node = nlohmann::json::array({std::move(node), "literal"});
+                }
+            }
+            chains.push_back(std::move(node));
+        }
+        return chains;
+    }
+}
+
+int main() {
+    nlohmann::json context = R"({"user": {"id": 7, "name": "Alice"}})"_json;
+
+    for (size_t depth : DEPTHS) {
+        nlohmann::json template_json = build_template(depth);
+
+        permuto::Options recursive;
+        recursive.max_recursion_depth = depth + 2;
+        permuto::Options iterative = recursive;
+        iterative.engine = permuto::ProcessingEngine::Iterative;
+
+        bench::print_header("depth " + std::to_string(depth));
+        double recursive_ns = bench::measure_ns(ITERATIONS, [&]() {
+            bench::sink = bench::sink + permuto::apply(template_json, context, recursive).size();
+        });
+        bench::print_row("recursive", recursive_ns, recursive_ns);
+        bench::print_row("iterative", bench::measure_ns(ITERATIONS, [&]() {
+            bench::sink = bench::sink + permuto::apply(template_json, context, iterative).size();
+        }), recursive_ns);
+    }
+
+    return 0;
+}
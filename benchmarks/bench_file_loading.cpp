@@ -0,0 +1,90 @@
+// CLI file loading: ifstream >> json against parsing a memory-mapped file,
+// and the read() fallback used for pipes
+#include <nlohmann/json.hpp>
+#include "../cli/file_loader.hpp"
+#include "bench_common.hpp"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    const size_t ITERATIONS = 3;
+    const std::vector<int> RECORD_COUNTS = {5000, 80000, 320000};
+
+    // Chat-history style context, about 650 bytes per record
+    std::string build_document(int records) {
+        nlohmann::json messages = nlohmann::json::array();
+        for (int i = 0; i < records; ++i) {
+            messages.push_back({
+                {"id", i},
+                {"role", i % 2 == 0 ? "user" : "assistant"},
+                {"content", "Message " + std::to_string(i) + ": " + std::string(400, 'x')},
+                {"tokens", {{"prompt", i * 3}, {"completion", i * 7}}},
+                {"score", i * 0.25},
+                {"tags", {"history", "batch", "archived"}}
+            });
+        }
+        return nlohmann::json{{"model", "claude-3-sonnet-20240229"}, {"messages", messages}}.dump(2);
+    }
+
+    void write_file(const std::string& path, const std::string& text) {
+        std::ofstream file(path, std::ios::binary);
+        file << text;
+    }
+
+    nlohmann::json load_with_ifstream(const std::string& path) {
+        std::ifstream file(path);
+        nlohmann::json json;
+        file >> json;
+        return json;
+    }
+
+    // Feed text through a FIFO so the loader takes its non-mappable path
+    nlohmann::json load_through_fifo(const std::string& fifo_path, const std::string& text) {
+        std::thread writer([&] {
+            std::FILE* fifo = std::fopen(fifo_path.c_str(), "wb");
+            std::fwrite(text.data(), 1, text.size(), fifo);
+            std::fclose(fifo);
+        });
+        auto json = permuto::cli::load_json_file(fifo_path);
+        writer.join();
+        return json;
+    }
+}
+
+int main() {
+    std::string directory = "/tmp/permuto_bench_" + std::to_string(::getpid());
+    ::mkdir(directory.c_str(), 0700);
+    std::string file_path = directory + "/context.json";
+    std::string fifo_path = directory + "/context.fifo";
+    ::mkfifo(fifo_path.c_str(), 0600);
+
+    for (int records : RECORD_COUNTS) {
+        std::string text = build_document(records);
+        write_file(file_path, text);
+
+        double ifstream_ns = bench::measure_ns(ITERATIONS, [&]() {
+            bench::sink = bench::sink + load_with_ifstream(file_path).size();
+        });
+        double mapped_ns = bench::measure_ns(ITERATIONS, [&]() {
+            bench::sink = bench::sink + permuto::cli::load_json_file(file_path).size();
+        });
+        double fifo_ns = bench::measure_ns(ITERATIONS, [&]() {
+            bench::sink = bench::sink + load_through_fifo(fifo_path, text).size();
+        });
+
+        bench::print_header("Load " + std::to_string(text.size() / (1024 * 1024)) + " MB context file");
+        bench::print_row("ifstream >> json", ifstream_ns, ifstream_ns);
+        bench::print_row("mmap + pointer-range parse", mapped_ns, ifstream_ns);
+        bench::print_row("pipe: read() + parse", fifo_ns, ifstream_ns);
+    }
+
+    std::remove(fifo_path.c_str());
+    std::remove(file_path.c_str());
+    ::rmdir(directory.c_str());
+    return 0;
+}
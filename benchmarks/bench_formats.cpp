@@ -0,0 +1,139 @@
+// Applying templates and contexts per encoding: decoding, applying and
+// re-encoding through nlohmann's converters versus decode() and encode() into
+// a reused sink, and render_stream() reading the encoded template directly
+#include <permuto/permuto.hpp>
+#include "bench_common.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+    const int HISTORY_LENGTH = 200;
+    const size_t ITERATIONS = 500;
+    const double NS_PER_SECOND = 1e9;
+    const double BYTES_PER_MB = 1024.0 * 1024.0;
+
+    struct FormatCase {
+        const char* name;
+        permuto::Format format;
+        std::vector<std::uint8_t> (*to_bytes)(const nlohmann::json&);
+        nlohmann::json (*from_bytes)(const std::string&);
+    };
+
+    std::vector<std::uint8_t> to_json_bytes(const nlohmann::json& value) {
+        std::string text = value.dump();
+        return std::vector<std::uint8_t>(text.begin(), text.end());
+    }
+
+    const FormatCase FORMATS[] = {
+        {"JSON", permuto::Format::Json, to_json_bytes,
+         [](const std::string& data) { return nlohmann::json::parse(data); }},
+        {"CBOR", permuto::Format::Cbor,
+         [](const nlohmann::json& value) { return nlohmann::json::to_cbor(value); },
+         [](const std::string& data) { return nlohmann::json::from_cbor(data); }},
+        {"MessagePack", permuto::Format::MessagePack,
+         [](const nlohmann::json& value) { return nlohmann::json::to_msgpack(value); },
+         [](const std::string& data) { return nlohmann::json::from_msgpack(data); }},
+        {"BSON", permuto::Format::Bson,
+         [](const nlohmann::json& value) { return nlohmann::json::to_bson(value); },
+         [](const std::string& data) { return nlohmann::json::from_bson(data); }},
+        {"UBJSON", permuto::Format::Ubjson,
+         [](const nlohmann::json& value) { return nlohmann::json::to_ubjson(value); },
+         [](const std::string& data) { return nlohmann::json::from_ubjson(data); }},
+    };
+
+    // Chat completion request with tool definitions and a conversation history
+    nlohmann::json build_template() {
+        return R"({
+            "model": "${/model}",
+            "max_tokens": 1024,
+            "temperature": 0.7,
+            "system": "You are a support assistant for ${/store/name}.",
+            "messages": "${/history}",
+            "metadata": {"user_id": "${/user/id}", "tier": "${/user/tier}", "session": "${/session/id}"},
+            "tools": [
+                {"name": "lookup_order", "description": "Find an order by id",
+                 "input_schema": {"type": "object", "properties": {"order_id": {"type": "string"}}}},
+                {"name": "refund", "description": "Refund an order for ${/user/name}",
+                 "input_schema": {"type": "object", "properties": {"amount": {"type": "number"}}}}
+            ]
+        })"_json;
+    }
+
+    nlohmann::json build_context() {
+        nlohmann::json context;
+        context["model"] = "claude-3-sonnet-20240229";
+        context["store"]["name"] = "Example Store";
+        context["user"] = {{"name", "Alice"}, {"id", 123}, {"tier", "premium"}};
+        context["session"]["id"] = "sess-8842";
+        for (int i = 0; i < HISTORY_LENGTH; ++i) {
+            context["history"].push_back({
+                {"role", i % 2 == 0 ? "user" : "assistant"},
+                {"content", "Message " + std::to_string(i) + " asks about order " +
+                            std::to_string(10000 + i) + " and its delivery date."},
+                {"tokens", 12 + i % 7}
+            });
+        }
+        return context;
+    }
+
+    std::string as_string(const std::vector<std::uint8_t>& bytes) {
+        return std::string(bytes.begin(), bytes.end());
+    }
+
+    double megabytes_per_second(size_t bytes, double ns) {
+        return static_cast<double>(bytes) / BYTES_PER_MB / (ns / NS_PER_SECOND);
+    }
+}
+
+int main() {
+    permuto::Options opts;
+    opts.enable_interpolation = true;
+
+    nlohmann::json template_json = build_template();
+    nlohmann::json context = build_context();
+
+    for (const auto& format_case : FORMATS) {
+        std::string template_bytes = as_string(format_case.to_bytes(template_json));
+        std::string context_bytes = as_string(format_case.to_bytes(context));
+        size_t input_bytes = template_bytes.size() + context_bytes.size();
+        nlohmann::json decoded_context = format_case.from_bytes(context_bytes);
+
+        std::string output;
+        permuto::StringSink sink(output);
+
+        // What a service does today: decode both, apply, re-encode to a new buffer
+        auto decode_apply_encode = [&]() {
+            auto result = permuto::apply(format_case.from_bytes(template_bytes),
+                                         format_case.from_bytes(context_bytes), opts);
+            bench::sink = bench::sink + format_case.to_bytes(result).size();
+        };
+        // Same steps through decode() and encode() into a reused buffer
+        auto decode_apply_sink = [&]() {
+            output.clear();
+            auto result = permuto::apply(permuto::decode(template_bytes, format_case.format),
+                                         permuto::decode(context_bytes, format_case.format), opts);
+            permuto::encode(result, format_case.format, sink);
+            bench::sink = bench::sink + output.size();
+        };
+        // Context decoded once per request, template streamed from its encoding
+        auto stream_template = [&]() {
+            output.clear();
+            permuto::render_stream(template_bytes, format_case.format, decoded_context, opts, sink);
+            bench::sink = bench::sink + output.size();
+        };
+
+        double baseline_ns = bench::measure_ns(ITERATIONS, decode_apply_encode);
+        double encode_ns = bench::measure_ns(ITERATIONS, decode_apply_sink);
+        double stream_ns = bench::measure_ns(ITERATIONS, stream_template);
+
+        bench::print_header(std::string(format_case.name) + " (" + std::to_string(input_bytes) +
+                            " bytes in)");
+        bench::print_row("from_*() + apply() + to_*()", baseline_ns, baseline_ns);
+        bench::print_row("decode() + apply() + encode()", encode_ns, baseline_ns);
+        bench::print_row("render_stream(), context reused", stream_ns, baseline_ns);
+        std::cout << "  throughput, MB/s of input: " << std::setprecision(1)
+                  << megabytes_per_second(input_bytes, baseline_ns) << " / "
+                  << megabytes_per_second(input_bytes, encode_ns) << "\n";
+    }
+    return 0;
+}
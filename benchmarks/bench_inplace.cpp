@@ -0,0 +1,64 @@
+// Compares rebuilding the output tree with in-place substitution on literal-heavy templates
+#include <permuto/permuto.hpp>
+#include "bench_common.hpp"
+
+namespace {
+    const int SECTION_COUNT = 40;
+    const int FIELDS_PER_SECTION = 20;
+    const int OPTIONAL_EVERY = 10;
+    const size_t ITERATIONS = 2000;
+
+    // About 95% literal values, with a few required and optional placeholders
+    nlohmann::json build_template() {
+        nlohmann::json template_json;
+        for (int s = 0; s < SECTION_COUNT; ++s) {
+            nlohmann::json section;
+            for (int f = 0; f < FIELDS_PER_SECTION; ++f) {
+                section["field_" + std::to_string(f)] = "static configuration text " + std::to_string(f);
+            }
+            section["tags"] = {"alpha", "beta", "gamma", 1, 2, 3, true};
+            section["owner"] = "${/owner}";
+            if (s % OPTIONAL_EVERY == 0) {
+                section["optional"] = "${/optional/" + std::to_string(s) + "}";
+            }
+            template_json["section_" + std::to_string(s)] = section;
+        }
+        return template_json;
+    }
+
+    void run_case(const std::string& title, const nlohmann::json& template_json,
+                  const nlohmann::json& context, const permuto::Options& options) {
+        bench::print_header(title);
+
+        double apply_ns = bench::measure_ns(ITERATIONS, [&]() {
+            bench::sink = bench::sink + permuto::apply(template_json, context, options).size();
+        });
+        bench::print_row("apply (rebuild tree)", apply_ns, apply_ns);
+
+        double inplace_ns = bench::measure_ns(ITERATIONS, [&]() {
+            nlohmann::json doc = template_json;
+            permuto::apply_inplace(doc, context, options);
+            bench::sink = bench::sink + doc.size();
+        });
+        bench::print_row("copy + apply_inplace", inplace_ns, apply_ns);
+
+        double copy_ns = bench::measure_ns(ITERATIONS, [&]() {
+            nlohmann::json doc = template_json;
+            bench::sink = bench::sink + doc.size();
+        });
+        bench::print_row("apply_inplace alone (est.)", inplace_ns - copy_ns, apply_ns);
+    }
+}
+
+int main() {
+    nlohmann::json template_json = build_template();
+    nlohmann::json context = {{"owner", "platform-team"}};
+
+    permuto::Options options;
+    run_case("Literal-heavy template, Ignore mode", template_json, context, options);
+
+    options.missing_key_behavior = permuto::MissingKeyBehavior::Remove;
+    run_case("Literal-heavy template, Remove mode", template_json, context, options);
+
+    return 0;
+}
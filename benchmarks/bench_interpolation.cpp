@@ -0,0 +1,70 @@
+// Heap allocations and time for interpolation-heavy prompt templates
+#include <permuto/permuto.hpp>
+#include "alloc_counter.hpp"
+#include "bench_common.hpp"
+
+namespace {
+    const int MESSAGE_COUNT = 50;
+    const size_t ITERATIONS = 2000;
+
+    nlohmann::json build_context() {
+        return R"({
+            "user": {"name": "Alexandra Montgomery-Smith", "tier": "premium"},
+            "order": {"id": "ORD-2024-0000012345", "eta": "on Thursday afternoon"},
+            "store": {"name": "The Long Named Example Store"}
+        })"_json;
+    }
+
+    // Chat transcript where every message interpolates several string values
+    nlohmann::json build_template() {
+        nlohmann::json messages = nlohmann::json::array();
+        for (int i = 0; i < MESSAGE_COUNT; ++i) {
+            messages.push_back({
+                {"role", i % 2 == 0 ? "user" : "assistant"},
+                {"content", "Message " + std::to_string(i) + ": dear ${/user/name} (${/user/tier}), "
+                            "order ${/order/id} from ${/store/name} arrives ${/order/eta}."}
+            });
+        }
+        return {{"messages", messages}};
+    }
+
+    void report(const std::string& name, size_t allocations, double ns) {
+        std::cout << std::left << std::setw(36) << name
+                  << std::right << std::setw(14) << allocations
+                  << std::setw(14) << std::fixed << std::setprecision(1) << ns << "\n";
+    }
+}
+
+int main() {
+    nlohmann::json context = build_context();
+    nlohmann::json template_json = build_template();
+
+    permuto::Options opts;
+    opts.enable_interpolation = true;
+    permuto::CompiledTemplate compiled(template_json, opts);
+
+    // Warm the pointer table so only per-apply allocations are counted
+    bench::sink = bench::sink + permuto::apply(template_json, context, opts).size();
+
+    std::cout << "\n" << MESSAGE_COUNT << " messages, 5 placeholders each\n";
+    std::cout << std::left << std::setw(36) << "case"
+              << std::right << std::setw(14) << "allocs/op" << std::setw(14) << "ns/op" << "\n";
+
+    size_t apply_allocs = bench::count_allocations([&]() {
+        bench::sink = bench::sink + permuto::apply(template_json, context, opts).size();
+    });
+    double apply_ns = bench::measure_ns(ITERATIONS, [&]() {
+        bench::sink = bench::sink + permuto::apply(template_json, context, opts).size();
+    });
+    report("apply", apply_allocs, apply_ns);
+
+    size_t compiled_allocs = bench::count_allocations([&]() {
+        bench::sink = bench::sink + compiled.apply(context).size();
+    });
+    double compiled_ns = bench::measure_ns(ITERATIONS, [&]() {
+        bench::sink = bench::sink + compiled.apply(context).size();
+    });
+    report("CompiledTemplate::apply", compiled_allocs, compiled_ns);
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+// Marker search on multi-kilobyte prompt text, per implementation
+#include "../src/marker_search.hpp"
+#include "../src/placeholder_parser.hpp"
+#include "bench_common.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace {
+    using FindMarkerFn = size_t (*)(std::string_view, size_t, std::string_view);
+
+    const size_t SIZES[] = {4 * 1024, 32 * 1024, 256 * 1024};
+    const size_t BYTES_PER_CASE = 16 * 1024 * 1024;
+    const size_t MIN_ITERATIONS = 3;
+
+    const char* const PROSE =
+        "You are a helpful assistant. Answer the user's question about the topic "
+        "in a concise and friendly way, citing sources where possible. Use {braces} "
+        "and $dollars only where the domain requires them. ";
+
+    std::string repeat_to(const std::string& unit, size_t size) {
+        std::string text;
+        text.reserve(size + unit.size());
+        while (text.size() < size) {
+            text += unit;
+        }
+        text.resize(size);
+        return text;
+    }
+
+    // Count every occurrence, like a full scan of a template string does
+    size_t count_markers(FindMarkerFn fn, std::string_view text, std::string_view marker) {
+        size_t count = 0;
+        for (size_t pos = fn(text, 0, marker); pos != std::string_view::npos;
+             pos = fn(text, pos + marker.size(), marker)) {
+            ++count;
+        }
+        return count;
+    }
+
+    void run_case(const std::string& name, const std::string& text, const std::string& marker,
+                  const std::vector<std::pair<std::string, FindMarkerFn>>& implementations) {
+        size_t iterations = std::max(MIN_ITERATIONS, BYTES_PER_CASE / text.size());
+        for (const auto& [impl_name, fn] : implementations) {
+            double ns = bench::measure_ns(iterations, [&]() {
+                bench::sink = bench::sink + count_markers(fn, text, marker);
+            });
+            std::cout << std::left << std::setw(44) << (name + " " + std::to_string(text.size() / 1024) + " KiB")
+                      << std::setw(10) << impl_name
+                      << std::right << std::setw(14) << std::fixed << std::setprecision(1) << ns
+                      << std::setw(12) << std::setprecision(2)
+                      << static_cast<double>(text.size()) / ns << "\n";
+        }
+    }
+}
+
+int main() {
+    std::vector<std::pair<std::string, FindMarkerFn>> implementations;
+    implementations.emplace_back("scalar", permuto::find_marker_scalar);
+#if PERMUTO_HAS_X86_SIMD
+    implementations.emplace_back("sse2", permuto::find_marker_sse2);
+    if (permuto::cpu_supports_avx2()) {
+        implementations.emplace_back("avx2", permuto::find_marker_avx2);
+    }
+#endif
+
+    std::cout << "\n" << std::left << std::setw(44) << "case" << std::setw(10) << "impl"
+              << std::right << std::setw(14) << "ns/op" << std::setw(12) << "GB/s" << "\n";
+
+    for (size_t size : SIZES) {
+        std::string prose = repeat_to(PROSE, size);
+        std::string placeholders = repeat_to(std::string(PROSE) + "See ${/context/section} and ${/context/notes}. ", size);
+
+        // Long system prompts: markers absent, or one every few hundred bytes
+        run_case("prose, no marker '${'", prose, "${", implementations);
+        run_case("prose, no marker '{{'", prose, "{{", implementations);
+        run_case("prose, no marker '<<placeholder:'", prose, "<<placeholder:", implementations);
+        run_case("prose with '${' placeholders", placeholders, "${", implementations);
+        run_case("prose with '}' end markers", placeholders, "}", implementations);
+    }
+
+    // End to end: find_placeholders on the same text, using the dispatched search
+    permuto::PlaceholderParser parser;
+    std::cout << "\n" << std::left << std::setw(44) << "find_placeholders"
+              << std::right << std::setw(14) << "ns/op" << std::setw(12) << "GB/s" << "\n";
+    for (size_t size : SIZES) {
+        std::string placeholders = repeat_to(std::string(PROSE) + "See ${/context/section} and ${/context/notes}. ", size);
+        size_t iterations = std::max(MIN_ITERATIONS, BYTES_PER_CASE / size);
+        double ns = bench::measure_ns(iterations, [&]() {
+            bench::sink = bench::sink + parser.find_placeholders(placeholders).size();
+        });
+        std::cout << std::left << std::setw(44) << ("prose with placeholders " + std::to_string(size / 1024) + " KiB")
+                  << std::right << std::setw(14) << std::fixed << std::setprecision(1) << ns
+                  << std::setw(12) << std::setprecision(2) << static_cast<double>(size) / ns << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+// One multi-marker scan versus one PlaceholderParser scan per marker set
+#include "../src/multi_marker_parser.hpp"
+#include "../src/placeholder_parser.hpp"
+#include "bench_common.hpp"
+#include <vector>
+
+namespace {
+    const size_t TEXT_SIZE = 256 * 1024;
+    const size_t ITERATIONS = 200;
+    const char* const START_MARKERS[] = {"${", "#{", "@{", "%{", "&{", "!{", "^{", "~{"};
+
+    // Prose with a placeholder of a rotating marker set every few sentences
+    std::string build_text(size_t sets, size_t sentences_between) {
+        const std::string sentence = "The quick brown fox jumps over the lazy dog near the river bank. ";
+        std::string text;
+        size_t count = 0;
+        while (text.size() < TEXT_SIZE) {
+            for (size_t i = 0; i < sentences_between; ++i) {
+                text += sentence;
+            }
+            text += START_MARKERS[count % sets];
+            text += "/items/" + std::to_string(count) + "/name} ";
+            ++count;
+        }
+        return text;
+    }
+
+    void run(size_t sets, size_t sentences_between) {
+        std::string text = build_text(sets, sentences_between);
+        std::vector<permuto::MarkerPair> pairs;
+        std::vector<permuto::PlaceholderParser> parsers;
+        for (size_t i = 0; i < sets; ++i) {
+            pairs.push_back({START_MARKERS[i], "}"});
+            parsers.emplace_back(START_MARKERS[i], "}");
+        }
+        permuto::MultiMarkerParser multi(pairs);
+
+        size_t per_set_count = 0;
+        double per_set_ns = bench::measure_ns(ITERATIONS, [&]() {
+            size_t count = 0;
+            for (const auto& parser : parsers) {
+                parser.for_each_placeholder(text, [&](std::string_view, size_t, size_t) { ++count; });
+            }
+            per_set_count = count;
+            bench::sink = bench::sink + count;
+        });
+
+        size_t multi_count = 0;
+        double multi_ns = bench::measure_ns(ITERATIONS, [&]() {
+            size_t count = 0;
+            multi.for_each_placeholder(text, [&](size_t, std::string_view, size_t, size_t) { ++count; });
+            multi_count = count;
+            bench::sink = bench::sink + count;
+        });
+
+        if (per_set_count != multi_count) {
+            std::cerr << "placeholder counts differ\n";
+        }
+
+        bench::print_header(std::to_string(sets) + " marker sets, " + std::to_string(text.size() / 1024) +
+                            " KiB, " + std::to_string(multi_count) + " placeholders");
+        bench::print_row("PlaceholderParser per set", per_set_ns, per_set_ns);
+        bench::print_row("MultiMarkerParser", multi_ns, per_set_ns);
+    }
+}
+
+int main() {
+    // Dense: a placeholder every two sentences; sparse: every hundred
+    for (size_t sentences_between : {2, 100}) {
+        for (size_t sets : {2, 4, 8}) {
+            run(sets, sentences_between);
+        }
+    }
+    return 0;
+}
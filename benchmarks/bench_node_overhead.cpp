@@ -0,0 +1,72 @@
+// Per-node processing cost on deep and wide templates without placeholders
+#include <permuto/permuto.hpp>
+#include "bench_common.hpp"
+
+namespace {
+    const int WIDE_COUNT = 100000;
+    const int DEEP_CHAINS = 1000;
+    const int DEEP_DEPTH = 50;
+    const size_t ITERATIONS = 20;
+
+    // One array of mixed literal scalars and small objects
+    nlohmann::json build_wide(size_t& nodes) {
+        nlohmann::json wide = nlohmann::json::array();
+        for (int i = 0; i < WIDE_COUNT; ++i) {
+            if (i % 4 == 0) {
+                wide.push_back({{"n", i}});
+                nodes += 2;
+            } else {
+                wide.push_back(i % 2 == 0 ? nlohmann::json(i) : nlohmann::json("text"));
+                nodes += 1;
+            }
+        }
+        return wide;
+    }
+
+    // Many nested object chains
+    nlohmann::json build_deep(size_t& nodes) {
+        nlohmann::json deep = nlohmann::json::array();
+        for (int c = 0; c < DEEP_CHAINS; ++c) {
+            nlohmann::json chain = "leaf";
+            for (int d = 0; d < DEEP_DEPTH; ++d) {
+                chain = {{"child", std::move(chain)}};
+            }
+            deep.push_back(std::move(chain));
+            nodes += DEEP_DEPTH + 1;
+        }
+        return deep;
+    }
+
+    void run(const std::string& name, const nlohmann::json& template_json, size_t nodes,
+             const permuto::Options& opts) {
+        nlohmann::json context = nlohmann::json::object();
+        double ns = bench::measure_ns(ITERATIONS, [&]() {
+            bench::sink = bench::sink + permuto::apply(template_json, context, opts).size();
+        });
+        std::cout << std::left << std::setw(36) << name
+                  << std::right << std::setw(14) << std::fixed << std::setprecision(1) << ns / 1000.0
+                  << std::setw(14) << std::setprecision(2) << ns / static_cast<double>(nodes) << "\n";
+    }
+}
+
+int main() {
+    size_t wide_nodes = 0;
+    size_t deep_nodes = 0;
+    nlohmann::json wide = build_wide(wide_nodes);
+    nlohmann::json deep = build_deep(deep_nodes);
+
+    permuto::Options opts;
+    opts.max_recursion_depth = DEEP_DEPTH + 8;
+
+    std::cout << "\n" << std::left << std::setw(36) << "case"
+              << std::right << std::setw(14) << "us/op" << std::setw(14) << "ns/node" << "\n";
+    run("wide (" + std::to_string(wide_nodes) + " nodes)", wide, wide_nodes, opts);
+    run("deep (" + std::to_string(deep_nodes) + " nodes)", deep, deep_nodes, opts);
+
+    permuto::Options interp = opts;
+    interp.enable_interpolation = true;
+    run("wide, interpolation on", wide, wide_nodes, interp);
+    run("deep, interpolation on", deep, deep_nodes, interp);
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+// Parallel processing of a 100k-element array template
+#include <permuto/permuto.hpp>
+#include "bench_common.hpp"
+#include <thread>
+
+namespace {
+    const int ELEMENT_COUNT = 100000;
+    const size_t PARALLEL_THRESHOLD = 1024;
+    const size_t ITERATIONS = 3;
+
+    // Bulk embedding request: one input per document
+    nlohmann::json build_template() {
+        nlohmann::json inputs = nlohmann::json::array();
+        for (int i = 0; i < ELEMENT_COUNT; ++i) {
+            inputs.push_back({
+                {"id", "doc-" + std::to_string(i)},
+                {"text", "${/documents/" + std::to_string(i % 1000) + "}"},
+                {"metadata", "${/metadata}"},
+                {"prefix", "Embed for ${/user/name} using ${/model}"}
+            });
+        }
+        return {{"model", "${/model}"}, {"input", inputs}};
+    }
+
+    nlohmann::json build_context() {
+        nlohmann::json context;
+        context["model"] = "text-embedding-3";
+        context["user"]["name"] = "batch-job";
+        context["metadata"] = {{"source", "crawler"}, {"lang", "en"}};
+        for (int i = 0; i < 1000; ++i) {
+            context["documents"].push_back("Document body " + std::to_string(i) + " with some text to embed");
+        }
+        return context;
+    }
+}
+
+int main() {
+    nlohmann::json template_json = build_template();
+    nlohmann::json context = build_context();
+
+    permuto::Options serial;
+    serial.enable_interpolation = true;
+
+    double serial_ns = bench::measure_ns(ITERATIONS, [&]() {
+        bench::sink = bench::sink + permuto::apply(template_json, context, serial).size();
+    });
+
+    size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    bench::print_header(std::to_string(ELEMENT_COUNT) + " elements, " +
+                        std::to_string(max_threads) + " hardware threads");
+    bench::print_row("serial", serial_ns, serial_ns);
+
+    for (size_t threads = 1; threads <= std::max<size_t>(max_threads, 4); threads *= 2) {
+        permuto::Options parallel = serial;
+        parallel.parallel_threshold = PARALLEL_THRESHOLD;
+        parallel.parallel_threads = threads;
+        double ns = bench::measure_ns(ITERATIONS, [&]() {
+            bench::sink = bench::sink + permuto::apply(template_json, context, parallel).size();
+        });
+        bench::print_row("parallel, " + std::to_string(threads) + " threads", ns, serial_ns);
+    }
+
+    return 0;
+}
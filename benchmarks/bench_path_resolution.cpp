@@ -0,0 +1,70 @@
+// Cost of resolving placeholders through TemplateProcessor's cycle tracking
+#include <permuto/permuto.hpp>
+#include "alloc_counter.hpp"
+#include "bench_common.hpp"
+
+namespace {
+    const int FIELD_COUNT = 500;
+    const size_t ITERATIONS = 2000;
+
+    // Paths long enough that copying them cannot use a small-string buffer
+    std::string field_path(int i) {
+        return "/customers/account_" + std::to_string(i % 50) + "/profile/display_name";
+    }
+
+    nlohmann::json build_context() {
+        nlohmann::json customers = nlohmann::json::object();
+        for (int i = 0; i < 50; ++i) {
+            customers["account_" + std::to_string(i)] = {{"profile", {{"display_name", "Customer " + std::to_string(i)}}}};
+        }
+        return {{"customers", customers}};
+    }
+
+    nlohmann::json build_exact_template() {
+        nlohmann::json fields = nlohmann::json::array();
+        for (int i = 0; i < FIELD_COUNT; ++i) {
+            fields.push_back("${" + field_path(i) + "}");
+        }
+        return fields;
+    }
+
+    nlohmann::json build_interpolated_template() {
+        nlohmann::json fields = nlohmann::json::array();
+        for (int i = 0; i < FIELD_COUNT; ++i) {
+            fields.push_back("Hello ${" + field_path(i) + "} and ${" + field_path(i + 1) + "}");
+        }
+        return fields;
+    }
+
+    void run(const std::string& name, const nlohmann::json& template_json,
+             const nlohmann::json& context, const permuto::Options& opts, size_t placeholders) {
+        // Warm the pointer table so only per-apply allocations are counted
+        bench::sink = bench::sink + permuto::apply(template_json, context, opts).size();
+
+        size_t allocations = bench::count_allocations([&]() {
+            bench::sink = bench::sink + permuto::apply(template_json, context, opts).size();
+        });
+        double ns = bench::measure_ns(ITERATIONS, [&]() {
+            bench::sink = bench::sink + permuto::apply(template_json, context, opts).size();
+        });
+        std::cout << std::left << std::setw(36) << name
+                  << std::right << std::setw(14) << allocations
+                  << std::setw(14) << std::fixed << std::setprecision(1) << ns / 1000.0
+                  << std::setw(14) << std::setprecision(1) << ns / static_cast<double>(placeholders) << "\n";
+    }
+}
+
+int main() {
+    nlohmann::json context = build_context();
+
+    permuto::Options opts;
+    opts.enable_interpolation = true;
+
+    std::cout << "\n" << std::left << std::setw(36) << "case"
+              << std::right << std::setw(14) << "allocs/op" << std::setw(14) << "us/op"
+              << std::setw(14) << "ns/lookup" << "\n";
+    run("exact placeholders", build_exact_template(), context, opts, FIELD_COUNT);
+    run("interpolated, 2 per string", build_interpolated_template(), context, opts, FIELD_COUNT * 2);
+
+    return 0;
+}
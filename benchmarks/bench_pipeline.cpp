@@ -0,0 +1,109 @@
+// Pipeline versus the chained apply() calls of examples/multi_stage_example.cpp
+#include <permuto/permuto.hpp>
+#include "bench_common.hpp"
+
+namespace {
+    const int HISTORY_LENGTH = 2000;
+    const size_t ITERATIONS = 2000;
+    const size_t LARGE_ITERATIONS = 200;
+
+    nlohmann::json main_template() {
+        return R"({
+            "model": "#{/model_name}",
+            "messages": [{"role": "user", "content": "#{/prompt}"}],
+            "temperature": "#{/temp}",
+            "max_tokens": 1000,
+            "stream": false
+        })"_json;
+    }
+
+    // Stage 1 also carries a long history, of which stage 2 uses one message
+    nlohmann::json history_context() {
+        nlohmann::json history = nlohmann::json::array();
+        for (int i = 0; i < HISTORY_LENGTH; ++i) {
+            history.push_back({{"role", i % 2 == 0 ? "user" : "assistant"},
+                               {"content", "Message number " + std::to_string(i) + " of the conversation so far"}});
+        }
+        return {{"the_model", "claude-3-sonnet-20240229"}, {"history", history}};
+    }
+}
+
+int main() {
+    permuto::Options error_options;
+    error_options.missing_key_behavior = permuto::MissingKeyBehavior::Error;
+    permuto::Options ignore_options;
+    ignore_options.start_marker = "#{";
+    permuto::Options remove_options = ignore_options;
+    remove_options.missing_key_behavior = permuto::MissingKeyBehavior::Remove;
+
+    // The example's steps: resolve the model, then fill the main template
+    // from three contexts in turn
+    nlohmann::json model_template = R"({"model_name": "${/the_model}"})"_json;
+    nlohmann::json model_context = R"({"the_model": "claude-3-sonnet-20240229"})"_json;
+    nlohmann::json prompt_context = R"({"prompt": "What are the key benefits of declarative programming?"})"_json;
+    nlohmann::json main = main_template();
+
+    auto example_steps = [&]() {
+        nlohmann::json resolved_model = permuto::apply(model_template, model_context, error_options);
+        nlohmann::json step1 = permuto::apply(main, resolved_model, ignore_options);
+        nlohmann::json step2 = permuto::apply(step1, prompt_context, ignore_options);
+        return permuto::apply(step2, nlohmann::json::object(), remove_options);
+    };
+
+    // The same payload as two pipeline stages over one context
+    nlohmann::json context = model_context;
+    context["prompt"] = prompt_context["prompt"];
+    permuto::Pipeline pipeline({
+        {R"({"model_name": "${/the_model}", "prompt": "${/prompt}"})"_json, error_options},
+        {main, remove_options}
+    });
+
+    if (pipeline.apply(context) != example_steps()) {
+        std::cerr << "results differ\n";
+        return 1;
+    }
+
+    bench::print_header("multi_stage_example payload");
+    double example_ns = bench::measure_ns(ITERATIONS, [&]() {
+        bench::sink = bench::sink + example_steps().size();
+    });
+    bench::print_row("chained apply (example steps)", example_ns, example_ns);
+
+    double pipeline_ns = bench::measure_ns(ITERATIONS, [&]() {
+        bench::sink = bench::sink + pipeline.apply(context).size();
+    });
+    bench::print_row("Pipeline", pipeline_ns, example_ns);
+
+    // Intermediate stage with a large subtree the final stage barely uses
+    nlohmann::json large_context = history_context();
+    permuto::PipelineStage first{R"({"model_name": "${/the_model}", "history": "${/history}"})"_json, error_options};
+    permuto::PipelineStage second{R"({
+        "model": "#{/model_name}",
+        "messages": ["#{/history/1999}"],
+        "temperature": "#{/temp}"
+    })"_json, remove_options};
+    permuto::Pipeline large_pipeline({first, second});
+
+    auto chained = [&]() {
+        nlohmann::json intermediate = permuto::apply(first.template_json, large_context, first.options);
+        return permuto::apply(second.template_json, intermediate, second.options);
+    };
+
+    if (large_pipeline.apply(large_context) != chained()) {
+        std::cerr << "results differ\n";
+        return 1;
+    }
+
+    bench::print_header(std::to_string(HISTORY_LENGTH) + "-message intermediate history");
+    double chained_ns = bench::measure_ns(LARGE_ITERATIONS, [&]() {
+        bench::sink = bench::sink + chained().size();
+    });
+    bench::print_row("chained apply", chained_ns, chained_ns);
+
+    double large_ns = bench::measure_ns(LARGE_ITERATIONS, [&]() {
+        bench::sink = bench::sink + large_pipeline.apply(large_context).size();
+    });
+    bench::print_row("Pipeline", large_ns, chained_ns);
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+// Placeholder scanning on adversarial and ordinary prompt text
+#include "../src/placeholder_parser.hpp"
+#include "bench_common.hpp"
+#include <algorithm>
+
+namespace {
+    const size_t SIZES[] = {1024, 8 * 1024, 64 * 1024};
+    const size_t BYTES_PER_CASE = 4 * 1024 * 1024;
+    const size_t MIN_ITERATIONS = 3;
+
+    std::string repeat_to(const std::string& unit, size_t size) {
+        std::string text;
+        text.reserve(size + unit.size());
+        while (text.size() < size) {
+            text += unit;
+        }
+        text.resize(size);
+        return text;
+    }
+
+    void run_case(const std::string& name, const std::string& unit, const permuto::PlaceholderParser& parser) {
+        for (size_t size : SIZES) {
+            std::string text = repeat_to(unit, size);
+            size_t iterations = std::max(MIN_ITERATIONS, BYTES_PER_CASE / size);
+            double ns = bench::measure_ns(iterations, [&]() {
+                bench::sink = bench::sink + parser.find_placeholders(text).size();
+            });
+            std::cout << std::left << std::setw(36) << (name + " " + std::to_string(size / 1024) + " KiB")
+                      << std::right << std::setw(14) << std::fixed << std::setprecision(1) << ns
+                      << std::setw(14) << std::setprecision(3) << ns / static_cast<double>(size) << "\n";
+        }
+    }
+}
+
+int main() {
+    permuto::PlaceholderParser parser;
+
+    std::cout << "\n" << std::left << std::setw(36) << "case"
+              << std::right << std::setw(14) << "ns/op" << std::setw(14) << "ns/byte" << "\n";
+
+    // Start markers that never close: quadratic for a restart-based scanner
+    run_case("unclosed '${'", "${", parser);
+    run_case("unclosed '${/a'", "${/a ", parser);
+    run_case("dense '$' noise", "$a$b$c$ ", parser);
+
+    // Ordinary prompt text with a placeholder every few hundred bytes
+    run_case("prompt text", "You are a helpful assistant. Answer the question about ${/topic} "
+                            "in a concise and friendly way, citing sources where possible. ", parser);
+
+    return 0;
+}
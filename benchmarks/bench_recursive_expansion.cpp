@@ -0,0 +1,80 @@
+// One recursive-expansion pass versus re-applying until placeholders settle
+#include <permuto/permuto.hpp>
+#include "bench_common.hpp"
+
+namespace {
+    const int SECTION_COUNT = 200;
+    const int CHAIN_LENGTH = 4;
+    const size_t ITERATIONS = 200;
+
+    // Each section's value refers to the next link of a short chain
+    nlohmann::json build_context() {
+        nlohmann::json context = {{"user", {{"name", "Alice"}, {"tier", "premium"}}}};
+        for (int level = 0; level < CHAIN_LENGTH; ++level) {
+            nlohmann::json link = nlohmann::json::object();
+            link["label"] = level + 1 < CHAIN_LENGTH
+                ? "${/level" + std::to_string(level + 1) + "/label}"
+                : "Dear ${/user/name} (${/user/tier})";
+            link["settings"] = {{"level", level}, {"owner", "${/user/name}"}};
+            context["level" + std::to_string(level)] = link;
+        }
+        return context;
+    }
+
+    nlohmann::json build_template() {
+        nlohmann::json sections = nlohmann::json::array();
+        for (int i = 0; i < SECTION_COUNT; ++i) {
+            sections.push_back({
+                {"title", "Section " + std::to_string(i) + ": ${/level0/label}"},
+                {"settings", "${/level" + std::to_string(i % CHAIN_LENGTH) + "/settings}"}
+            });
+        }
+        return {{"sections", sections}};
+    }
+
+    // Multi-stage style: apply again until the result stops changing
+    nlohmann::json apply_until_settled(const nlohmann::json& template_json,
+                                       const nlohmann::json& context,
+                                       const permuto::Options& opts) {
+        nlohmann::json result = permuto::apply(template_json, context, opts);
+        for (nlohmann::json previous; result != previous;) {
+            previous = result;
+            result = permuto::apply(previous, context, opts);
+        }
+        return result;
+    }
+}
+
+int main() {
+    nlohmann::json context = build_context();
+    nlohmann::json template_json = build_template();
+
+    permuto::Options opts;
+    opts.enable_interpolation = true;
+    permuto::Options recursive = opts;
+    recursive.recursive_expansion = true;
+    permuto::CompiledTemplate compiled(template_json, recursive);
+
+    if (apply_until_settled(template_json, context, opts) != permuto::apply(template_json, context, recursive)) {
+        std::cerr << "results differ\n";
+        return 1;
+    }
+
+    bench::print_header(std::to_string(SECTION_COUNT) + " sections, chains of " + std::to_string(CHAIN_LENGTH));
+    double repeated_ns = bench::measure_ns(ITERATIONS, [&]() {
+        bench::sink = bench::sink + apply_until_settled(template_json, context, opts).size();
+    });
+    bench::print_row("repeated apply", repeated_ns, repeated_ns);
+
+    double recursive_ns = bench::measure_ns(ITERATIONS, [&]() {
+        bench::sink = bench::sink + permuto::apply(template_json, context, recursive).size();
+    });
+    bench::print_row("recursive_expansion", recursive_ns, repeated_ns);
+
+    double compiled_ns = bench::measure_ns(ITERATIONS, [&]() {
+        bench::sink = bench::sink + compiled.apply(context).size();
+    });
+    bench::print_row("compiled, recursive_expansion", compiled_ns, repeated_ns);
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+// Remove-mode template with hundreds of optional fields, most of them absent
+#include <permuto/permuto.hpp>
+#include "bench_common.hpp"
+
+namespace {
+    const int OPTIONAL_FIELD_COUNT = 400;
+    const int PRESENT_EVERY = 4;
+    const int HISTORY_LENGTH = 50;
+    const size_t ITERATIONS = 2000;
+}
+
+int main() {
+    nlohmann::json template_json;
+    nlohmann::json context;
+
+    for (int i = 0; i < OPTIONAL_FIELD_COUNT; ++i) {
+        std::string key = "param_" + std::to_string(i);
+        template_json["parameters"][key] = "${/config/" + key + "}";
+        template_json["flags"].push_back("${/flags/" + key + "}");
+        if (i % PRESENT_EVERY == 0) {
+            context["config"][key] = i;
+            context["flags"][key] = "flag_" + key;
+        }
+    }
+
+    // A present placeholder that pulls in a larger subtree
+    template_json["messages"] = "${/history}";
+    for (int i = 0; i < HISTORY_LENGTH; ++i) {
+        context["history"].push_back({{"role", "user"}, {"content", "message " + std::to_string(i)}});
+    }
+
+    permuto::Options options;
+    options.missing_key_behavior = permuto::MissingKeyBehavior::Remove;
+
+    bench::print_header("Remove mode, " + std::to_string(OPTIONAL_FIELD_COUNT * 2) +
+                        " optional sites (1 in " + std::to_string(PRESENT_EVERY) + " present)");
+
+    double apply_ns = bench::measure_ns(ITERATIONS, [&]() {
+        bench::sink = bench::sink + permuto::apply(template_json, context, options).size();
+    });
+    bench::print_row("permuto::apply", apply_ns, apply_ns);
+
+    double inplace_ns = bench::measure_ns(ITERATIONS, [&]() {
+        nlohmann::json doc = template_json;
+        permuto::apply_inplace(doc, context, options);
+        bench::sink = bench::sink + doc.size();
+    });
+    bench::print_row("copy + apply_inplace", inplace_ns, apply_ns);
+
+    permuto::CompiledTemplate compiled(template_json, options);
+    double compiled_ns = bench::measure_ns(ITERATIONS, [&]() {
+        bench::sink = bench::sink + compiled.apply(context).size();
+    });
+    bench::print_row("CompiledTemplate::apply", compiled_ns, apply_ns);
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+// render() writing JSON text directly versus apply() followed by dump()
+#include <permuto/permuto.hpp>
+#include "alloc_counter.hpp"
+#include "bench_common.hpp"
+#include <string>
+
+namespace {
+    const int HISTORY_LENGTH = 2000;
+    const size_t ITERATIONS = 200;
+    const int INDENT = 2;
+
+    // Request body built from a long chat history, as the CLI would print it
+    nlohmann::json build_template() {
+        return R"({
+            "model": "${/model}",
+            "max_tokens": 1024,
+            "system": "You are a support assistant for ${/store/name}.",
+            "messages": "${/history}",
+            "metadata": {"user": "${/user}", "session": "${/session/id}"},
+            "tools": [{"name": "lookup_order", "description": "Find an order by id", "input": {"type": "object"}}]
+        })"_json;
+    }
+
+    nlohmann::json build_context() {
+        nlohmann::json context;
+        context["model"] = "claude-3-sonnet-20240229";
+        context["store"]["name"] = "Example Store";
+        context["user"] = {{"name", "Alice"}, {"id", 123}, {"tier", "premium"}, {"score", 0.875}};
+        context["session"]["id"] = "sess-8842";
+        for (int i = 0; i < HISTORY_LENGTH; ++i) {
+            context["history"].push_back({
+                {"role", i % 2 == 0 ? "user" : "assistant"},
+                {"content", "Message " + std::to_string(i) + " says \"hello\" and asks about order " +
+                            std::to_string(10000 + i) + "."}
+            });
+        }
+        return context;
+    }
+}
+
+int main() {
+    permuto::Options opts;
+    opts.enable_interpolation = true;
+
+    nlohmann::json template_json = build_template();
+    nlohmann::json context = build_context();
+    permuto::CompiledTemplate compiled(template_json, opts);
+
+    std::string output;
+    permuto::StringSink sink(output);
+
+    auto apply_dump = [&]() {
+        bench::sink = bench::sink + permuto::apply(template_json, context, opts).dump(INDENT).size();
+    };
+    auto render_fresh = [&]() {
+        std::string text;
+        permuto::StringSink fresh_sink(text);
+        permuto::render(template_json, context, opts, fresh_sink, INDENT);
+        bench::sink = bench::sink + text.size();
+    };
+    auto compiled_dump = [&]() {
+        bench::sink = bench::sink + compiled.apply(context).dump(INDENT).size();
+    };
+    auto compiled_render = [&]() {
+        output.clear();
+        compiled.render(context, sink, INDENT);
+        bench::sink = bench::sink + output.size();
+    };
+
+    double apply_ns = bench::measure_ns(ITERATIONS, apply_dump);
+    double render_ns = bench::measure_ns(ITERATIONS, render_fresh);
+    double compiled_ns = bench::measure_ns(ITERATIONS, compiled_dump);
+    double compiled_render_ns = bench::measure_ns(ITERATIONS, compiled_render);
+
+    bench::print_header("Serialize a " + std::to_string(HISTORY_LENGTH) + "-message request (indent 2)");
+    bench::print_row("apply() + dump()", apply_ns, apply_ns);
+    bench::print_row("render() to new string", render_ns, apply_ns);
+    bench::print_row("compiled apply() + dump()", compiled_ns, apply_ns);
+    bench::print_row("compiled render() reused string", compiled_render_ns, apply_ns);
+
+    std::cout << "\nallocations per call\n";
+    std::cout << "  apply() + dump():                " << bench::count_allocations(apply_dump) << "\n";
+    std::cout << "  render() to new string:          " << bench::count_allocations(render_fresh) << "\n";
+    std::cout << "  compiled apply() + dump():       " << bench::count_allocations(compiled_dump) << "\n";
+    std::cout << "  compiled render() reused string: " << bench::count_allocations(compiled_render) << "\n";
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Streaming a large template from disk with render_stream() versus parsing
+// it into a document first; each case runs in its own process so that its
+// peak resident memory can be reported
+#include <permuto/permuto.hpp>
+#include "bench_common.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+    const int REQUEST_COUNT = 100000;
+
+    // Batch-API style file: one request per line item, all sharing a context
+    void write_template(const std::string& path) {
+        std::ofstream file(path);
+        file << "{\"requests\": [";
+        for (int i = 0; i < REQUEST_COUNT; ++i) {
+            if (i > 0) {
+                file << ",";
+            }
+            file << "{\"custom_id\": \"request-" << i << "\", \"params\": {"
+                 << "\"max_tokens\": 1024, \"model\": \"${/model}\", \"messages\": ["
+                 << "{\"content\": \"${/system}\", \"role\": \"system\"},"
+                 << "{\"content\": \"Summarize document " << i << " for ${/user/name}.\", \"role\": \"user\"}"
+                 << "]}}";
+        }
+        file << "]}";
+    }
+
+    nlohmann::json build_context() {
+        return {
+            {"model", "claude-3-sonnet-20240229"},
+            {"system", "You are a concise summarizer."},
+            {"user", {{"name", "Alice"}, {"id", 123}}}
+        };
+    }
+
+    // Run fn in a child process; returns wall time in ns and peak RSS in KB
+    template <typename Fn>
+    std::pair<double, long> run_isolated(Fn&& fn) {
+        auto start = std::chrono::steady_clock::now();
+        pid_t pid = ::fork();
+        if (pid == 0) {
+            fn();
+            std::_Exit(0);
+        }
+        int status = 0;
+        struct rusage usage {};
+        ::wait4(pid, &status, 0, &usage);
+        auto end = std::chrono::steady_clock::now();
+        return {std::chrono::duration<double, std::nano>(end - start).count(), usage.ru_maxrss};
+    }
+}
+
+int main() {
+    std::string template_path = "/tmp/permuto_bench_stream_" + std::to_string(::getpid()) + ".json";
+    write_template(template_path);
+    nlohmann::json context = build_context();
+    permuto::Options opts;
+    opts.enable_interpolation = true;
+
+    auto parse_apply_dump = [&]() {
+        std::ifstream input(template_path);
+        auto template_json = nlohmann::json::parse(input);
+        std::ofstream output("/dev/null");
+        output << permuto::apply(template_json, context, opts).dump(2);
+    };
+    auto parse_render = [&]() {
+        std::ifstream input(template_path);
+        auto template_json = nlohmann::json::parse(input);
+        std::ofstream output("/dev/null");
+        permuto::StreamSink sink(output);
+        permuto::render(template_json, context, opts, sink, 2);
+    };
+    auto stream = [&]() {
+        std::ifstream input(template_path);
+        std::ofstream output("/dev/null");
+        permuto::StreamSink sink(output);
+        permuto::render_stream(input, context, opts, sink, 2);
+    };
+
+    // Baseline process: start-up and the context only
+    long idle_kb = run_isolated([]() {}).second;
+    auto [dump_ns, dump_kb] = run_isolated(parse_apply_dump);
+    auto [render_ns, render_kb] = run_isolated(parse_render);
+    auto [stream_ns, stream_kb] = run_isolated(stream);
+
+    bench::print_header("Apply a " + std::to_string(REQUEST_COUNT) + "-request template file");
+    bench::print_row("parse + apply() + dump()", dump_ns, dump_ns);
+    bench::print_row("parse + render()", render_ns, dump_ns);
+    bench::print_row("render_stream()", stream_ns, dump_ns);
+
+    std::cout << "\npeak RSS (KB; empty child " << idle_kb << ")\n";
+    std::cout << "  parse + apply() + dump(): " << dump_kb << "\n";
+    std::cout << "  parse + render():         " << render_kb << "\n";
+    std::cout << "  render_stream():          " << stream_kb << "\n";
+
+    std::remove(template_path.c_str());
+    return 0;
+}
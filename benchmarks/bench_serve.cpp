@@ -0,0 +1,158 @@
+// Latency of one request: spawning the permuto binary per request versus a
+// server started with --serve, over a new or a kept-open connection
+#include <permuto/permuto.hpp>
+#include "bench_common.hpp"
+#include "../cli/serve.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace {
+    const int HISTORY_LENGTH = 50;
+    const size_t SPAWN_ITERATIONS = 50;
+    const size_t SOCKET_ITERATIONS = 2000;
+    const double PERCENTILE_99 = 0.99;
+    const size_t SERVER_JOBS = 2;  // One is held by the kept connection
+
+    nlohmann::json build_template() {
+        return R"({
+            "model": "${/model}",
+            "max_tokens": 1024,
+            "system": "You are a support assistant for ${/store/name}.",
+            "messages": "${/history}",
+            "metadata": {"user_id": "${/user/id}", "session": "${/session/id}"},
+            "tools": [{"name": "lookup_order", "description": "Find an order by id", "input": {"type": "object"}}]
+        })"_json;
+    }
+
+    nlohmann::json build_context() {
+        nlohmann::json context;
+        context["model"] = "claude-3-sonnet-20240229";
+        context["store"]["name"] = "Example Store";
+        context["user"] = {{"name", "Alice"}, {"id", 123}};
+        context["session"]["id"] = "sess-8842";
+        for (int i = 0; i < HISTORY_LENGTH; ++i) {
+            context["history"].push_back({
+                {"role", i % 2 == 0 ? "user" : "assistant"},
+                {"content", "Message " + std::to_string(i) + " asks about order " + std::to_string(10000 + i) + "."}
+            });
+        }
+        return context;
+    }
+
+    // Mean and 99th percentile of fn's wall time in nanoseconds
+    template <typename Fn>
+    std::pair<double, double> measure_latency(size_t iterations, Fn&& fn) {
+        std::vector<double> samples;
+        samples.reserve(iterations);
+        fn();
+        for (size_t i = 0; i < iterations; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto end = std::chrono::steady_clock::now();
+            samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        }
+        std::sort(samples.begin(), samples.end());
+        double total = 0;
+        for (double sample : samples) {
+            total += sample;
+        }
+        size_t p99 = std::min(samples.size() - 1, static_cast<size_t>(samples.size() * PERCENTILE_99));
+        return {total / static_cast<double>(samples.size()), samples[p99]};
+    }
+
+    void print_p99(const std::string& name, double p99_ns) {
+        std::cout << "  " << name << " p99: " << std::fixed << std::setprecision(1) << p99_ns / 1000.0 << " us\n";
+    }
+}
+
+int main(int, char* argv[]) {
+    std::string prefix = "/tmp/permuto_bench_serve_" + std::to_string(::getpid());
+    std::string template_path = prefix + "_template.json";
+    std::string context_path = prefix + "_context.json";
+    std::string socket_path = prefix + ".sock";
+    std::ofstream(template_path) << build_template().dump(2);
+    std::string context_text = build_context().dump();
+    std::ofstream(context_path) << context_text;
+
+    permuto::cli::ServeRequest request;
+    request.template_path = template_path;
+    request.indent = 2;
+
+    // The permuto binary is built next to this benchmark
+    std::string program(argv[0]);
+    program = program.substr(0, program.find_last_of('/') + 1) + "permuto";
+    bool have_program = ::access(program.c_str(), X_OK) == 0;
+    auto spawn = [&]() {
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+        std::vector<char*> arguments = {program.data(), template_path.data(), context_path.data(), nullptr};
+        pid_t pid = 0;
+        if (posix_spawn(&pid, program.c_str(), &actions, nullptr, arguments.data(), environ) == 0) {
+            int status = 0;
+            ::waitpid(pid, &status, 0);
+        }
+        posix_spawn_file_actions_destroy(&actions);
+    };
+
+    permuto::cli::Server server(socket_path, permuto::cli::ServeSettings{SERVER_JOBS});
+    std::thread serving([&]() { server.run(); });
+
+    auto new_connection = [&]() {
+        permuto::cli::Client client(socket_path);
+        bench::sink = bench::sink + client.apply(request, context_text).size();
+    };
+    permuto::cli::Client kept_client(socket_path);
+    auto kept_connection = [&]() {
+        bench::sink = bench::sink + kept_client.apply(request, context_text).size();
+    };
+    permuto::CompiledTemplate compiled(build_template());
+    std::string output;
+    permuto::StringSink sink(output);
+    auto in_process = [&]() {
+        output.clear();
+        compiled.render(nlohmann::json::parse(context_text), sink, 2);
+        bench::sink = bench::sink + output.size();
+    };
+
+    std::pair<double, double> spawn_ns{0, 0};
+    if (have_program) {
+        spawn_ns = measure_latency(SPAWN_ITERATIONS, spawn);
+    }
+    auto connect_ns = measure_latency(SOCKET_ITERATIONS, new_connection);
+    auto kept_ns = measure_latency(SOCKET_ITERATIONS, kept_connection);
+    auto in_process_ns = measure_latency(SOCKET_ITERATIONS, in_process);
+    double baseline_ns = have_program ? spawn_ns.first : connect_ns.first;
+
+    bench::print_header("One request, " + std::to_string(context_text.size()) + "-byte context (mean)");
+    if (have_program) {
+        bench::print_row("spawn permuto per request", spawn_ns.first, baseline_ns);
+    }
+    bench::print_row("--serve, new connection", connect_ns.first, baseline_ns);
+    bench::print_row("--serve, kept connection", kept_ns.first, baseline_ns);
+    bench::print_row("in process (parse + render)", in_process_ns.first, baseline_ns);
+
+    std::cout << "\n";
+    if (have_program) {
+        print_p99("spawn permuto per request", spawn_ns.second);
+    }
+    print_p99("--serve, new connection  ", connect_ns.second);
+    print_p99("--serve, kept connection ", kept_ns.second);
+
+    server.stop();
+    serving.join();
+    std::remove(template_path.c_str());
+    std::remove(context_path.c_str());
+    return 0;
+}
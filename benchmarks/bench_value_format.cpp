@@ -0,0 +1,69 @@
+// Interpolating numbers and repeated objects into prompt strings
+#include <permuto/permuto.hpp>
+#include "bench_common.hpp"
+
+namespace {
+    const int STRING_COUNT = 200;
+    const size_t ITERATIONS = 500;
+
+    nlohmann::json build_context() {
+        nlohmann::json context = R"({
+            "sampling": {"temperature": 0.7, "top_p": 0.95, "penalty": 1.0},
+            "limits": {"max_tokens": 4096, "seed": 18446744073709551615}
+        })"_json;
+        for (int i = 0; i < 40; ++i) {
+            context["profile"]["field_" + std::to_string(i)] = "value " + std::to_string(i);
+        }
+        return context;
+    }
+
+    nlohmann::json numbers_template() {
+        nlohmann::json lines = nlohmann::json::array();
+        for (int i = 0; i < STRING_COUNT; ++i) {
+            lines.push_back("t=${/sampling/temperature} p=${/sampling/top_p} r=${/sampling/penalty} "
+                            "max=${/limits/max_tokens} seed=${/limits/seed}");
+        }
+        return lines;
+    }
+
+    nlohmann::json objects_template() {
+        nlohmann::json lines = nlohmann::json::array();
+        for (int i = 0; i < STRING_COUNT; ++i) {
+            lines.push_back("Profile " + std::to_string(i) + ": ${/profile}");
+        }
+        return lines;
+    }
+}
+
+int main() {
+    nlohmann::json context = build_context();
+    permuto::Options opts;
+    opts.enable_interpolation = true;
+
+    bench::print_header(std::to_string(STRING_COUNT) + " interpolated strings");
+
+    nlohmann::json numbers = numbers_template();
+    permuto::CompiledTemplate compiled_numbers(numbers, opts);
+    double numbers_ns = bench::measure_ns(ITERATIONS, [&]() {
+        bench::sink = bench::sink + permuto::apply(numbers, context, opts).size();
+    });
+    bench::print_row("apply, 5 numbers each", numbers_ns, numbers_ns);
+    bench::print_row("compiled, 5 numbers each", bench::measure_ns(ITERATIONS, [&]() {
+        bench::sink = bench::sink + compiled_numbers.apply(context).size();
+    }), numbers_ns);
+
+    nlohmann::json objects = objects_template();
+    permuto::CompiledTemplate compiled_objects(objects, opts);
+    double objects_ns = bench::measure_ns(ITERATIONS, [&]() {
+        bench::sink = bench::sink + permuto::apply(objects, context, opts).size();
+    });
+    bench::print_row("apply, same object each", objects_ns, objects_ns);
+    bench::print_row("compiled, same object each", bench::measure_ns(ITERATIONS, [&]() {
+        bench::sink = bench::sink + compiled_objects.apply(context).size();
+    }), objects_ns);
+
+    // A sample line, to check the formatting itself
+    std::cout << "\n" << permuto::apply(numbers, context, opts)[0].get<std::string>() << "\n";
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace permuto::cli {
+    // FIFO that blocks producers while full and consumers while empty
+    // Closing it releases both: pushes are refused and pops drain what is left.
+    template <typename T>
+    class BoundedQueue {
+    public:
+        explicit BoundedQueue(size_t capacity) : capacity_(std::max<size_t>(1, capacity)) {}
+        
+        // Blocks while full; false, dropping item, once closed
+        bool push(T item) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_full_.wait(lock, [&] { return items_.size() < capacity_ || closed_; });
+            if (closed_) {
+                return false;
+            }
+            items_.push_back(std::move(item));
+            not_empty_.notify_one();
+            return true;
+        }
+        
+        // Never blocks; false, leaving item with the caller, if full or closed
+        bool try_push(T& item) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closed_ || items_.size() >= capacity_) {
+                return false;
+            }
+            items_.push_back(std::move(item));
+            not_empty_.notify_one();
+            return true;
+        }
+        
+        // Blocks until an item is available; false once closed and drained
+        bool pop(T& item) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(lock, [&] { return !items_.empty() || closed_; });
+            return take_front(item);
+        }
+        
+        // Never blocks; false if nothing is queued right now
+        bool try_pop(T& item) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return take_front(item);
+        }
+        
+        // No more pushes will follow, or none are wanted any more
+        void close() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+            not_empty_.notify_all();
+            not_full_.notify_all();
+        }
+    
+    private:
+        bool take_front(T& item) {
+            if (items_.empty()) {
+                return false;
+            }
+            item = std::move(items_.front());
+            items_.pop_front();
+            not_full_.notify_one();
+            return true;
+        }
+        
+        const size_t capacity_;
+        std::deque<T> items_;
+        bool closed_ = false;
+        std::mutex mutex_;
+        std::condition_variable not_full_;
+        std::condition_variable not_empty_;
+    };
+}
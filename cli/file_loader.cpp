@@ -0,0 +1,137 @@
+#include "file_loader.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <iostream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace permuto::cli {
+#if defined(_WIN32)
+    FileContents::FileContents(const std::string& filename) {
+        if (filename == STDIN_FILE_NAME) {
+            buffer_.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+        } else {
+            std::ifstream file(filename, std::ios::binary);
+            if (!file.is_open()) {
+                throw std::runtime_error("Cannot open file: " + filename);
+            }
+            buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        data_ = buffer_;
+    }
+    
+    FileContents::~FileContents() = default;
+#else
+    namespace {
+        const size_t READ_CHUNK_SIZE = 1 << 16;
+        
+        std::runtime_error file_error(const std::string& what, const std::string& filename) {
+            return std::runtime_error(what + ": " + filename + " (" + std::strerror(errno) + ")");
+        }
+        
+        // Read everything up to end of file into buffer
+        void read_all(int fd, const std::string& filename, std::string& buffer) {
+            size_t used = 0;
+            for (;;) {
+                if (buffer.size() - used < READ_CHUNK_SIZE) {
+                    buffer.resize(std::max(buffer.size() * 2, used + READ_CHUNK_SIZE));
+                }
+                ssize_t count = ::read(fd, &buffer[used], buffer.size() - used);
+                if (count == 0) {
+                    break;
+                }
+                if (count < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw file_error("Cannot read file", filename);
+                }
+                used += static_cast<size_t>(count);
+            }
+            buffer.resize(used);
+        }
+    }
+    
+    FileContents::FileContents(const std::string& filename) {
+        if (filename == STDIN_FILE_NAME) {
+            read_all(STDIN_FILENO, filename, buffer_);
+            data_ = buffer_;
+            return;
+        }
+        
+        int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw file_error("Cannot open file", filename);
+        }
+        
+        struct stat info {};
+        if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            size_t size = static_cast<size_t>(info.st_size);
+            void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                // The parser reads front to back exactly once
+                ::madvise(mapping, size, MADV_SEQUENTIAL);
+                mapping_ = mapping;
+                mapping_size_ = size;
+                data_ = std::string_view(static_cast<const char*>(mapping), size);
+                ::close(fd);
+                return;
+            }
+        }
+        
+        // Not a regular file, empty as far as stat knows (as /proc files
+        // are), or not mappable
+        try {
+            read_all(fd, filename, buffer_);
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+        data_ = buffer_;
+    }
+    
+    FileContents::~FileContents() {
+        if (mapping_ != nullptr) {
+            ::munmap(mapping_, mapping_size_);
+        }
+    }
+#endif
+    
+    bool is_regular_file(const std::string& filename) {
+        std::error_code error;
+        return filename != STDIN_FILE_NAME && std::filesystem::is_regular_file(filename, error);
+    }
+    
+    nlohmann::json load_json_file(const std::string& filename, permuto::Format format) {
+        FileContents contents(filename);
+        return permuto::decode(contents.data(), format);
+    }
+    
+    void replace_file(const std::string& filename, std::string_view data) {
+        const std::string temporary = filename + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file.write(data.data(), static_cast<std::streamsize>(data.size())) || !file.flush()) {
+                throw std::runtime_error("Cannot write file: " + temporary);
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, filename, error);
+        if (error) {
+            std::filesystem::remove(temporary, error);
+            throw std::runtime_error("Cannot write file: " + filename);
+        }
+    }
+}
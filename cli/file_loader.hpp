@@ -0,0 +1,45 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include <permuto/permuto.hpp>
+#include <string>
+#include <string_view>
+
+namespace permuto::cli {
+    // Name that stands for standard input instead of a file
+    inline const std::string STDIN_FILE_NAME = "-";
+    
+    // Read-only contents of a file as one contiguous buffer
+    // Regular files are memory-mapped, so nothing is copied; pipes, character
+    // devices, standard input and files that cannot be mapped are read into
+    // an owned buffer instead. Throws std::runtime_error if the file cannot
+    // be opened or read.
+    class FileContents {
+    public:
+        explicit FileContents(const std::string& filename);
+        ~FileContents();
+        
+        FileContents(const FileContents&) = delete;
+        FileContents& operator=(const FileContents&) = delete;
+        
+        std::string_view data() const { return data_; }
+        bool is_mapped() const { return mapping_ != nullptr; }
+    
+    private:
+        void* mapping_ = nullptr;
+        size_t mapping_size_ = 0;
+        std::string buffer_;
+        std::string_view data_;
+    };
+    
+    // True if filename names a regular file, which FileContents maps
+    // instead of reading into memory
+    bool is_regular_file(const std::string& filename);
+    
+    // Parse a file straight from its contents; filename may be "-"
+    nlohmann::json load_json_file(const std::string& filename,
+                                  permuto::Format format = permuto::Format::Json);
+    
+    // Replace a file with data through a rename, so that processes that
+    // have the old file mapped keep seeing it unchanged
+    void replace_file(const std::string& filename, std::string_view data);
+}
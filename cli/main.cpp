@@ -1,6 +1,15 @@
-#include <iostream>
+#include <atomic>
+#include <csignal>
+#include <filesystem>
 #include <fstream>
+#include <iostream>
+#include <optional>
 #include <permuto/permuto.hpp>
+#include "file_loader.hpp"
+#include "ndjson_stream.hpp"
+#if defined(PERMUTO_CLI_SERVE)
+#include "serve.hpp"
+#endif
 
 namespace {
     // Command line option constants
@@ -13,16 +22,42 @@ namespace {
     const std::string START_MARKER_OPTION = "--start=";
     const std::string END_MARKER_OPTION = "--end=";
     const std::string MAX_DEPTH_OPTION = "--max-depth=";
+    const std::string NDJSON_OPTION = "--ndjson";
+    const std::string JOBS_OPTION = "--jobs=";
+    const std::string STREAM_OPTION = "--stream";
+    const std::string IN_FORMAT_OPTION = "--in-format=";
+    const std::string OUT_FORMAT_OPTION = "--out-format=";
+#if defined(PERMUTO_CLI_SERVE)
+    const std::string SERVE_OPTION = "--serve=";
+    const std::string CONNECT_OPTION = "--connect=";
+#endif
+    const std::string OUTPUT_OPTION = "-o";
+    
+    // Commands, given as the first argument
+    const std::string COMPILE_COMMAND = "compile";
+    
+    // Templates with this extension are compiled artifacts
+    const std::string ARTIFACT_EXTENSION = ".ptc";
     
     // Missing key behavior values
     const std::string IGNORE_VALUE = "ignore";
     const std::string ERROR_VALUE = "error";
     const std::string REMOVE_VALUE = "remove";
     
+    // Format values
+    const std::string JSON_VALUE = "json";
+    const std::string CBOR_VALUE = "cbor";
+    const std::string MSGPACK_VALUE = "msgpack";
+    const std::string BSON_VALUE = "bson";
+    const std::string UBJSON_VALUE = "ubjson";
+    const char FORMAT_LIST_SEPARATOR = ',';
+    
     // Program constants
     const int MIN_ARGC = 2;
     const int FIRST_ARG_INDEX = 1;
     const size_t REQUIRED_FILE_COUNT = 2;
+    const size_t NDJSON_FILE_COUNT = 1;
+    const size_t COMPILE_FILE_COUNT = 1;
     const size_t FIRST_FILE_INDEX = 0;
     const size_t SECOND_FILE_INDEX = 1;
     const int JSON_INDENT = 2;
@@ -31,11 +66,78 @@ namespace {
     // Exit codes
     const int EXIT_SUCCESS_CODE = 0;
     const int EXIT_ERROR_CODE = 1;
+    
+#if defined(PERMUTO_CLI_SERVE)
+    // Server stopped by SIGINT and SIGTERM
+    std::atomic<permuto::cli::Server*> running_server{nullptr};
+    
+    void stop_running_server(int) {
+        permuto::cli::Server* server = running_server.load();
+        if (server) {
+            server->stop();
+        }
+    }
+    
+    // Routes SIGINT and SIGTERM to a server for as long as it is in scope,
+    // including when run() throws
+    class StopOnSignal {
+    public:
+        explicit StopOnSignal(permuto::cli::Server& server) {
+            running_server.store(&server);
+            std::signal(SIGINT, stop_running_server);
+            std::signal(SIGTERM, stop_running_server);
+        }
+        
+        ~StopOnSignal() {
+            // Handlers are restored first, so none runs once the server is gone
+            std::signal(SIGINT, SIG_DFL);
+            std::signal(SIGTERM, SIG_DFL);
+            running_server.store(nullptr);
+        }
+        
+        StopOnSignal(const StopOnSignal&) = delete;
+        StopOnSignal& operator=(const StopOnSignal&) = delete;
+    };
+#endif
+    
+    std::optional<permuto::Format> parse_format(const std::string& name) {
+        if (name == JSON_VALUE) {
+            return permuto::Format::Json;
+        } else if (name == CBOR_VALUE) {
+            return permuto::Format::Cbor;
+        } else if (name == MSGPACK_VALUE) {
+            return permuto::Format::MessagePack;
+        } else if (name == BSON_VALUE) {
+            return permuto::Format::Bson;
+        } else if (name == UBJSON_VALUE) {
+            return permuto::Format::Ubjson;
+        }
+        return std::nullopt;
+    }
+    
+    bool is_artifact_file(const std::string& filename) {
+        return filename.size() > ARTIFACT_EXTENSION.size() &&
+               filename.compare(filename.size() - ARTIFACT_EXTENSION.size(),
+                                ARTIFACT_EXTENSION.size(), ARTIFACT_EXTENSION) == 0;
+    }
 }
 
 void print_usage(const char* program_name) {
     std::cout << "Usage: " << program_name << " [OPTIONS] <template.json> <context.json>\n";
     std::cout << "       " << program_name << " --reverse [OPTIONS] <template.json> <result.json>\n";
+    std::cout << "       " << program_name << " --ndjson [OPTIONS] <template.json> < input.ndjson\n";
+#if defined(PERMUTO_CLI_SERVE)
+    std::cout << "       " << program_name << " --serve=SOCKET [--jobs=N]\n";
+    std::cout << "       " << program_name << " --connect=SOCKET [OPTIONS] <template.json> <context.json>\n";
+#endif
+    std::cout << "       " << program_name << " compile [OPTIONS] <template.json> -o <template.ptc>\n";
+    std::cout << "\nA file name of - reads that file from standard input.\n";
+    std::cout << "A template ending in .ptc is compiled; it is applied with the options it\n";
+#if defined(PERMUTO_CLI_SERVE)
+    std::cout << "was compiled with and cannot be used with --reverse, --stream or --connect.\n";
+#else
+    std::cout << "was compiled with and cannot be used with --reverse or --stream.\n";
+#endif
     std::cout << "\nOptions:\n";
     std::cout << "  --help                Show this help message\n";
     std::cout << "  --version             Show version information\n";
@@ -46,6 +148,24 @@ void print_usage(const char* program_name) {
     std::cout << "  --start=MARKER        Set start marker (default: ${)\n";
     std::cout << "  --end=MARKER          Set end marker (default: })\n";
     std::cout << "  --max-depth=N         Set max recursion depth (default: 64)\n";
+    std::cout << "  --ndjson              Read one JSON document per line from stdin and write\n";
+    std::cout << "                        one compact result per line, in input order. Lines\n";
+    std::cout << "                        that fail are written as null and reported on stderr\n";
+    std::cout << "  --jobs=N              Worker threads for --ndjson (default: one per CPU)\n";
+    std::cout << "  --stream              Read the template as a stream instead of loading it,\n";
+    std::cout << "                        for templates larger than memory. Keys keep their\n";
+    std::cout << "                        template order\n";
+    std::cout << "  --in-format=FMT[,FMT] Format of the input files: json (default), cbor,\n";
+    std::cout << "                        msgpack, bson or ubjson. A comma-separated list\n";
+    std::cout << "                        gives one format per file, in order\n";
+    std::cout << "  --out-format=FMT      Format of the output (default: json, pretty printed)\n";
+#if defined(PERMUTO_CLI_SERVE)
+    std::cout << "  --serve=SOCKET        Answer requests on a Unix domain socket, keeping\n";
+    std::cout << "                        compiled templates cached, until interrupted.\n";
+    std::cout << "                        --jobs=N sets the worker threads\n";
+    std::cout << "  --connect=SOCKET      Send the request to a server started with --serve\n";
+#endif
+    std::cout << "  -o FILE               Output file of compile\n";
 }
 
 void print_version() {
@@ -53,17 +173,6 @@ void print_version() {
     std::cout << "JSON template processing tool\n";
 }
 
-nlohmann::json load_json_file(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        throw std::runtime_error("Cannot open file: " + filename);
-    }
-    
-    nlohmann::json json;
-    file >> json;
-    return json;
-}
-
 int main(int argc, char* argv[]) {
     try {
         if (argc < MIN_ARGC) {
@@ -74,9 +183,26 @@ int main(int argc, char* argv[]) {
         // Parse command line arguments
         permuto::Options options;
         bool reverse_mode = false;
+        bool ndjson_mode = false;
+        bool stream_mode = false;
+        bool compile_mode = false;
+        std::string output_file;
+        std::vector<permuto::Format> input_formats = {permuto::Format::Json};
+        permuto::Format output_format = permuto::Format::Json;
+#if defined(PERMUTO_CLI_SERVE)
+        std::string serve_socket;
+        std::string connect_socket;
+#endif
+        permuto::cli::NdjsonSettings ndjson_settings;
         std::vector<std::string> files;
         
-        for (int i = FIRST_ARG_INDEX; i < argc; ++i) {
+        int first_option = FIRST_ARG_INDEX;
+        if (argv[FIRST_ARG_INDEX] == COMPILE_COMMAND) {
+            compile_mode = true;
+            ++first_option;
+        }
+        
+        for (int i = first_option; i < argc; ++i) {
             std::string arg = argv[i];
             
             if (arg == HELP_OPTION) {
@@ -114,7 +240,55 @@ int main(int argc, char* argv[]) {
                     std::cerr << "Invalid max depth value: " << arg.substr(MAX_DEPTH_OPTION.length()) << std::endl;
                     return EXIT_ERROR_CODE;
                 }
-            } else if (arg[0] != OPTION_PREFIX) {
+            } else if (arg == NDJSON_OPTION) {
+                ndjson_mode = true;
+            } else if (arg == STREAM_OPTION) {
+                stream_mode = true;
+            } else if (arg.substr(0, IN_FORMAT_OPTION.length()) == IN_FORMAT_OPTION) {
+                input_formats.clear();
+                std::string list = arg.substr(IN_FORMAT_OPTION.length());
+                size_t start = 0;
+                while (true) {
+                    size_t end = list.find(FORMAT_LIST_SEPARATOR, start);
+                    std::string name = list.substr(start, end == std::string::npos ? std::string::npos : end - start);
+                    auto format = parse_format(name);
+                    if (!format) {
+                        std::cerr << "Invalid input format: " << name << std::endl;
+                        return EXIT_ERROR_CODE;
+                    }
+                    input_formats.push_back(*format);
+                    if (end == std::string::npos) {
+                        break;
+                    }
+                    start = end + 1;
+                }
+            } else if (arg.substr(0, OUT_FORMAT_OPTION.length()) == OUT_FORMAT_OPTION) {
+                auto format = parse_format(arg.substr(OUT_FORMAT_OPTION.length()));
+                if (!format) {
+                    std::cerr << "Invalid output format: " << arg.substr(OUT_FORMAT_OPTION.length()) << std::endl;
+                    return EXIT_ERROR_CODE;
+                }
+                output_format = *format;
+#if defined(PERMUTO_CLI_SERVE)
+            } else if (arg.substr(0, SERVE_OPTION.length()) == SERVE_OPTION) {
+                serve_socket = arg.substr(SERVE_OPTION.length());
+            } else if (arg.substr(0, CONNECT_OPTION.length()) == CONNECT_OPTION) {
+                connect_socket = arg.substr(CONNECT_OPTION.length());
+#endif
+            } else if (arg.substr(0, JOBS_OPTION.length()) == JOBS_OPTION) {
+                try {
+                    ndjson_settings.jobs = std::stoull(arg.substr(JOBS_OPTION.length()));
+                } catch (const std::exception&) {
+                    std::cerr << "Invalid jobs value: " << arg.substr(JOBS_OPTION.length()) << std::endl;
+                    return EXIT_ERROR_CODE;
+                }
+            } else if (arg == OUTPUT_OPTION) {
+                if (i + 1 == argc) {
+                    std::cerr << "Missing file name after " << OUTPUT_OPTION << std::endl;
+                    return EXIT_ERROR_CODE;
+                }
+                output_file = argv[++i];
+            } else if (arg[0] != OPTION_PREFIX || arg == permuto::cli::STDIN_FILE_NAME) {
                 files.push_back(arg);
             } else {
                 std::cerr << "Unknown option: " << arg << std::endl;
@@ -122,6 +296,129 @@ int main(int argc, char* argv[]) {
             }
         }
         
+#if defined(PERMUTO_CLI_SERVE)
+        if (!serve_socket.empty()) {
+            if (!files.empty() || !connect_socket.empty() || reverse_mode || ndjson_mode || stream_mode ||
+                compile_mode) {
+                std::cerr << "Error: " << SERVE_OPTION << " takes no files; requests carry the template and options\n";
+                return EXIT_ERROR_CODE;
+            }
+            permuto::cli::Server server(serve_socket, permuto::cli::ServeSettings{ndjson_settings.jobs});
+            StopOnSignal stop_on_signal(server);
+#if defined(SIGPIPE)
+            std::signal(SIGPIPE, SIG_IGN);
+#endif
+            std::cerr << "Serving on " << serve_socket << std::endl;
+            server.run();
+            return EXIT_SUCCESS_CODE;
+        }
+        if (!connect_socket.empty() && (reverse_mode || ndjson_mode || stream_mode || compile_mode ||
+                                        output_format != permuto::Format::Json)) {
+            std::cerr << "Error: " << CONNECT_OPTION << " only applies templates and writes JSON text\n";
+            return EXIT_ERROR_CODE;
+        }
+#endif
+        if (compile_mode && (reverse_mode || ndjson_mode || stream_mode ||
+                             output_format != permuto::Format::Json)) {
+            std::cerr << "Error: " << COMPILE_COMMAND << " takes only template options\n";
+            return EXIT_ERROR_CODE;
+        }
+        
+        if (stream_mode && (reverse_mode || ndjson_mode)) {
+            std::cerr << "Error: " << STREAM_OPTION << " cannot be combined with "
+                      << (reverse_mode ? REVERSE_OPTION : NDJSON_OPTION) << "\n";
+            return EXIT_ERROR_CODE;
+        }
+        
+        if ((ndjson_mode || stream_mode) && output_format != permuto::Format::Json) {
+            std::cerr << "Error: " << (ndjson_mode ? NDJSON_OPTION : STREAM_OPTION)
+                      << " writes JSON text; " << OUT_FORMAT_OPTION << " is not supported\n";
+            return EXIT_ERROR_CODE;
+        }
+        if (input_formats.size() != 1 && input_formats.size() != files.size()) {
+            std::cerr << "Error: " << IN_FORMAT_OPTION << " lists " << input_formats.size()
+                      << " formats for " << files.size() << " files\n";
+            return EXIT_ERROR_CODE;
+        }
+        // A single format applies to every file
+        auto input_format = [&input_formats](size_t file_index) {
+            return input_formats[input_formats.size() == 1 ? 0 : file_index];
+        };
+        
+        if (compile_mode) {
+            if (files.size() != COMPILE_FILE_COUNT || output_file.empty()) {
+                std::cerr << "Error: " << COMPILE_COMMAND << " takes one template and "
+                          << OUTPUT_OPTION << " FILE\n";
+                print_usage(argv[0]);
+                return EXIT_ERROR_CODE;
+            }
+            options.validate();
+            auto template_json = permuto::cli::load_json_file(files[FIRST_FILE_INDEX],
+                                                              input_format(FIRST_FILE_INDEX));
+            permuto::cli::replace_file(output_file, permuto::TemplateArtifact::serialize(template_json, options));
+            return EXIT_SUCCESS_CODE;
+        }
+        
+        // Compiled templates carry their own options and are only applied
+        const bool artifact_template = !files.empty() && is_artifact_file(files[FIRST_FILE_INDEX]);
+        if (artifact_template && (reverse_mode || stream_mode)) {
+            std::cerr << "Error: " << ARTIFACT_EXTENSION << " templates cannot be used with "
+                      << (reverse_mode ? REVERSE_OPTION : STREAM_OPTION) << "\n";
+            return EXIT_ERROR_CODE;
+        }
+#if defined(PERMUTO_CLI_SERVE)
+        if (artifact_template && !connect_socket.empty()) {
+            std::cerr << "Error: " << ARTIFACT_EXTENSION << " templates cannot be used with "
+                      << CONNECT_OPTION << "\n";
+            return EXIT_ERROR_CODE;
+        }
+#endif
+        
+        if (ndjson_mode) {
+            if (files.size() != NDJSON_FILE_COUNT) {
+                std::cerr << "Error: Exactly " << NDJSON_FILE_COUNT << " file required with " << NDJSON_OPTION << "\n";
+                print_usage(argv[0]);
+                return EXIT_ERROR_CODE;
+            }
+            if (files[FIRST_FILE_INDEX] == permuto::cli::STDIN_FILE_NAME) {
+                std::cerr << "Error: The template cannot be read from stdin with " << NDJSON_OPTION << "\n";
+                return EXIT_ERROR_CODE;
+            }
+            
+            options.validate();
+            
+            // Compile once; every worker applies the same template
+            permuto::cli::RecordTransform transform;
+            if (artifact_template) {
+                auto artifact = permuto::TemplateArtifact::open(files[FIRST_FILE_INDEX]);
+                transform = [artifact](const nlohmann::json& context, std::string& out) {
+                    permuto::StringSink sink(out);
+                    artifact.render(context, sink);
+                };
+            } else if (reverse_mode) {
+                // Only the template can be binary; every line is JSON text
+                auto template_json = permuto::cli::load_json_file(files[FIRST_FILE_INDEX],
+                                                                  input_format(FIRST_FILE_INDEX));
+                auto reverse_template = permuto::create_reverse_template(template_json, options);
+                transform = [reverse_template](const nlohmann::json& result, std::string& out) {
+                    out += permuto::apply_reverse(reverse_template, result).dump();
+                };
+            } else {
+                auto template_json = permuto::cli::load_json_file(files[FIRST_FILE_INDEX],
+                                                                  input_format(FIRST_FILE_INDEX));
+                auto compiled = permuto::CompiledTemplate(template_json, options);
+                transform = [compiled](const nlohmann::json& context, std::string& out) {
+                    permuto::StringSink sink(out);
+                    compiled.render(context, sink);
+                };
+            }
+            
+            std::ios::sync_with_stdio(false);
+            std::cin.tie(nullptr);
+            auto summary = permuto::cli::run_ndjson(std::cin, std::cout, std::cerr, transform, ndjson_settings);
+            return summary.failures == 0 ? EXIT_SUCCESS_CODE : EXIT_ERROR_CODE;
+        }
+        
         if (files.size() != REQUIRED_FILE_COUNT) {
             std::cerr << "Error: Exactly " << REQUIRED_FILE_COUNT << " files required\n";
             print_usage(argv[0]);
@@ -131,24 +428,104 @@ int main(int argc, char* argv[]) {
         // Validate options
         options.validate();
         
-        // Load files
-        auto file1 = load_json_file(files[FIRST_FILE_INDEX]);
-        auto file2 = load_json_file(files[SECOND_FILE_INDEX]);
+#if defined(PERMUTO_CLI_SERVE)
+        if (!connect_socket.empty()) {
+            // The server reads and caches the template; the context is sent unparsed
+            const std::string& template_file = files[FIRST_FILE_INDEX];
+            if (template_file == permuto::cli::STDIN_FILE_NAME) {
+                std::cerr << "Error: The template cannot be read from stdin with " << CONNECT_OPTION << "\n";
+                return EXIT_ERROR_CODE;
+            }
+            permuto::cli::ServeRequest request;
+            request.template_path = std::filesystem::absolute(template_file).string();
+            request.template_format = input_format(FIRST_FILE_INDEX);
+            request.context_format = input_format(SECOND_FILE_INDEX);
+            request.indent = JSON_INDENT;
+            request.options = options;
+            permuto::cli::FileContents context(files[SECOND_FILE_INDEX]);
+            permuto::cli::Client client(connect_socket);
+            std::cout << client.apply(request, context.data()) << std::endl;
+            return EXIT_SUCCESS_CODE;
+        }
+#endif
+        
+        if (stream_mode) {
+            // Only the context is loaded; the template is substituted as it is read
+            auto context = permuto::cli::load_json_file(files[SECOND_FILE_INDEX],
+                                                        input_format(SECOND_FILE_INDEX));
+            const std::string& template_file = files[FIRST_FILE_INDEX];
+            permuto::Format template_format = input_format(FIRST_FILE_INDEX);
+            permuto::StreamSink sink(std::cout);
+            if (template_file == permuto::cli::STDIN_FILE_NAME) {
+                permuto::render_stream(std::cin, template_format, context, options, sink, JSON_INDENT);
+            } else if (permuto::cli::is_regular_file(template_file)) {
+                permuto::cli::FileContents contents(template_file);
+                permuto::render_stream(contents.data(), template_format, context, options, sink, JSON_INDENT);
+            } else {
+                std::ifstream input(template_file, std::ios::binary);
+                if (!input.is_open()) {
+                    throw std::runtime_error("Cannot open file: " + template_file);
+                }
+                permuto::render_stream(input, template_format, context, options, sink, JSON_INDENT);
+            }
+            std::cout << std::endl;
+            return EXIT_SUCCESS_CODE;
+        }
         
-        nlohmann::json result;
+        if (artifact_template) {
+            auto artifact = permuto::TemplateArtifact::open(files[FIRST_FILE_INDEX]);
+            auto context = permuto::cli::load_json_file(files[SECOND_FILE_INDEX],
+                                                        input_format(SECOND_FILE_INDEX));
+            // Rendered in full first, so an error leaves no partial output
+            std::string output;
+            permuto::StringSink sink(output);
+            if (output_format != permuto::Format::Json) {
+                permuto::encode(artifact.apply(context), output_format, sink);
+                std::ios::sync_with_stdio(false);
+                std::cout.write(output.data(), static_cast<std::streamsize>(output.size()));
+                std::cout.flush();
+            } else {
+                artifact.render(context, sink, JSON_INDENT);
+                std::cout.write(output.data(), static_cast<std::streamsize>(output.size()));
+                std::cout << std::endl;
+            }
+            return EXIT_SUCCESS_CODE;
+        }
         
-        if (reverse_mode) {
+        // Load files
+        auto file1 = permuto::cli::load_json_file(files[FIRST_FILE_INDEX], input_format(FIRST_FILE_INDEX));
+        auto file2 = permuto::cli::load_json_file(files[SECOND_FILE_INDEX], input_format(SECOND_FILE_INDEX));
+        
+        if (output_format != permuto::Format::Json) {
+            // Binary output is written as is, without a trailing newline
+            std::string output;
+            permuto::StringSink sink(output);
+            if (reverse_mode) {
+                auto reverse_template = permuto::create_reverse_template(file1, options);
+                permuto::encode(permuto::apply_reverse(reverse_template, file2), output_format, sink);
+            } else {
+                permuto::render(file1, file2, options, sink, output_format);
+            }
+            std::ios::sync_with_stdio(false);
+            std::cout.write(output.data(), static_cast<std::streamsize>(output.size()));
+            std::cout.flush();
+        } else if (reverse_mode) {
             // Reverse operation: template + result -> context
             auto reverse_template = permuto::create_reverse_template(file1, options);
-            result = permuto::apply_reverse(reverse_template, file2);
+            auto result = permuto::apply_reverse(reverse_template, file2);
+            std::cout << result.dump(JSON_INDENT) << std::endl;
         } else {
-            // Forward operation: template + context -> result
-            result = permuto::apply(file1, file2, options);
+            // Forward operation: template + context -> result, pretty printed
+            // as text without building the result document. Written only once
+            // complete, so an error leaves no truncated JSON; --stream is the
+            // mode that writes as it goes.
+            std::string output;
+            permuto::StringSink sink(output);
+            permuto::render(file1, file2, options, sink, JSON_INDENT);
+            std::cout.write(output.data(), static_cast<std::streamsize>(output.size()));
+            std::cout << std::endl;
         }
         
-        // Pretty print result
-        std::cout << result.dump(JSON_INDENT) << std::endl;
-        
         return EXIT_SUCCESS_CODE;
         
     } catch (const std::exception& e) {
@@ -0,0 +1,227 @@
+#include "ndjson_stream.hpp"
+#include "bounded_queue.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <istream>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace permuto::cli {
+    namespace {
+        // Queue slots per worker thread, and records in flight per worker
+        const size_t QUEUE_SLOTS_PER_JOB = 4;
+        const size_t IN_FLIGHT_PER_JOB = 16;
+        const size_t MIN_IN_FLIGHT = 64;
+        const char* const FAILED_RECORD_OUTPUT = "null";
+        
+        struct InputRecord {
+            size_t sequence = 0;     // Position among non-blank lines
+            size_t line_number = 0;  // 1-based line in the input
+            std::string text;
+        };
+        
+        struct OutputRecord {
+            size_t sequence = 0;
+            size_t line_number = 0;
+            bool failed = false;
+            std::string text;  // Compact JSON, or the error message if failed
+        };
+        
+        // Counting limit on records between the reader and the writer
+        class InFlightLimit {
+        public:
+            explicit InFlightLimit(size_t limit) : available_(limit) {}
+            
+            // Blocks until a record may be read; false once cancelled
+            bool acquire() {
+                std::unique_lock<std::mutex> lock(mutex_);
+                released_.wait(lock, [&] { return available_ > 0 || cancelled_; });
+                if (cancelled_) {
+                    return false;
+                }
+                --available_;
+                return true;
+            }
+            
+            void release() {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ++available_;
+                released_.notify_one();
+            }
+            
+            void cancel() {
+                std::lock_guard<std::mutex> lock(mutex_);
+                cancelled_ = true;
+                released_.notify_all();
+            }
+        
+        private:
+            size_t available_;
+            bool cancelled_ = false;
+            std::mutex mutex_;
+            std::condition_variable released_;
+        };
+        
+        // Joins the threads of a run on every way out of run_ndjson
+        // stop is called first, so that no thread stays blocked waiting for a
+        // writer that has gone; after a complete run it has nothing to wake.
+        // A reader blocked on input is only joined once the input ends.
+        class JoinGuard {
+        public:
+            explicit JoinGuard(std::function<void()> stop) : stop_(std::move(stop)) {}
+            
+            ~JoinGuard() {
+                stop_();
+                for (auto& thread : threads) {
+                    thread.join();
+                }
+            }
+            
+            JoinGuard(const JoinGuard&) = delete;
+            JoinGuard& operator=(const JoinGuard&) = delete;
+            
+            std::vector<std::thread> threads;
+        
+        private:
+            std::function<void()> stop_;
+        };
+        
+        bool is_blank(const std::string& line) {
+            return line.find_first_not_of(" \t\r") == std::string::npos;
+        }
+        
+        OutputRecord transform_record(InputRecord& input, const RecordTransform& transform) {
+            OutputRecord output;
+            output.sequence = input.sequence;
+            output.line_number = input.line_number;
+            try {
+                auto record = nlohmann::json::parse(input.text);
+                // The input text is no longer needed; free it before building the result
+                std::string().swap(input.text);
+                transform(record, output.text);
+            } catch (const std::exception& e) {
+                output.failed = true;
+                output.text = e.what();
+            } catch (...) {
+                output.failed = true;
+                output.text = "unknown error";
+            }
+            return output;
+        }
+    }
+    
+    NdjsonSummary run_ndjson(std::istream& in, std::ostream& out, std::ostream& errors,
+                             const RecordTransform& transform,
+                             const NdjsonSettings& settings) {
+        size_t jobs = settings.jobs;
+        if (jobs == 0) {
+            jobs = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+        size_t max_in_flight = settings.max_in_flight;
+        if (max_in_flight == 0) {
+            max_in_flight = std::max(MIN_IN_FLIGHT, jobs * IN_FLIGHT_PER_JOB);
+        }
+        
+        BoundedQueue<InputRecord> input_queue(jobs * QUEUE_SLOTS_PER_JOB);
+        BoundedQueue<OutputRecord> output_queue(jobs * QUEUE_SLOTS_PER_JOB);
+        InFlightLimit in_flight(max_in_flight);
+        
+        std::atomic<size_t> running_workers{0};
+        auto worker = [&] {
+            InputRecord input;
+            while (input_queue.pop(input)) {
+                output_queue.push(transform_record(input, transform));
+            }
+            // The last worker to finish ends the output
+            if (running_workers.fetch_sub(1) == 1) {
+                output_queue.close();
+            }
+        };
+        
+        JoinGuard guard([&] {
+            input_queue.close();
+            output_queue.close();
+            in_flight.cancel();
+        });
+        guard.threads.reserve(jobs + 1);
+        running_workers.store(jobs);
+        for (size_t i = 0; i < jobs; ++i) {
+            try {
+                guard.threads.emplace_back(worker);
+            } catch (const std::system_error&) {
+                // Run with the workers that could be started
+                if (running_workers.fetch_sub(jobs - i) == jobs - i) {
+                    throw;
+                }
+                break;
+            }
+        }
+        
+        auto read_input = [&] {
+            std::string line;
+            size_t line_number = 0;
+            size_t sequence = 0;
+            while (std::getline(in, line)) {
+                ++line_number;
+                if (is_blank(line)) {
+                    continue;
+                }
+                if (!in_flight.acquire() ||
+                    !input_queue.push(InputRecord{sequence++, line_number, std::move(line)})) {
+                    break;
+                }
+                line.clear();
+            }
+            input_queue.close();
+        };
+        
+        guard.threads.emplace_back(read_input);
+        
+        // Results arrive in completion order; each waits in the slot for its
+        // sequence number until every earlier one has been written. The reader
+        // stops while max_in_flight records are unwritten, so the sequence
+        // numbers in flight never wrap around onto an occupied slot.
+        NdjsonSummary summary;
+        std::vector<std::optional<OutputRecord>> pending(max_in_flight);
+        size_t next_sequence = 0;
+        OutputRecord output;
+        for (;;) {
+            if (!output_queue.try_pop(output)) {
+                // Nothing ready: hand what was written so far to the consumer before waiting
+                out.flush();
+                if (!output_queue.pop(output)) {
+                    break;
+                }
+            }
+            
+            size_t slot = output.sequence % max_in_flight;
+            pending[slot] = std::move(output);
+            
+            for (slot = next_sequence % max_in_flight; pending[slot];
+                 slot = next_sequence % max_in_flight) {
+                OutputRecord& ready = *pending[slot];
+                if (ready.failed) {
+                    errors << "line " << ready.line_number << ": " << ready.text << '\n';
+                    out << FAILED_RECORD_OUTPUT << '\n';
+                    ++summary.failures;
+                } else {
+                    out.write(ready.text.data(), static_cast<std::streamsize>(ready.text.size()));
+                    out.put('\n');
+                }
+                pending[slot].reset();
+                ++summary.records;
+                ++next_sequence;
+                in_flight.release();
+            }
+        }
+        out.flush();
+        return summary;
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+
+namespace permuto::cli {
+    // Appends the compact JSON text of the output for one input record to
+    // out, or throws
+    using RecordTransform = std::function<void(const nlohmann::json& record, std::string& out)>;
+    
+    struct NdjsonSettings {
+        size_t jobs = 0;           // Worker threads; 0 means one per hardware thread
+        size_t max_in_flight = 0;  // Records read but not yet written; 0 picks a default from jobs
+    };
+    
+    struct NdjsonSummary {
+        size_t records = 0;   // Non-blank input lines
+        size_t failures = 0;  // Records that could not be parsed or transformed
+    };
+    
+    // Read one JSON document per line from in, transform each and write the
+    // compact result as one line to out, in input order
+    //
+    // A reader thread feeds a bounded queue that jobs worker threads drain;
+    // the calling thread writes results back in order. At most max_in_flight
+    // records are held at any time, so a slow consumer or a slow record stalls
+    // the reader instead of buffering the rest of the input.
+    //
+    // Blank lines are skipped. A record that fails is written as `null`, so
+    // output line N still belongs to input record N, and "line L: message" is
+    // written to errors, where L is the input line number. Processing always
+    // continues with the next record.
+    NdjsonSummary run_ndjson(std::istream& in, std::ostream& out, std::ostream& errors,
+                             const RecordTransform& transform,
+                             const NdjsonSettings& settings = {});
+}
@@ -0,0 +1,522 @@
+#include "serve.hpp"
+#include "bounded_queue.hpp"
+#include "file_loader.hpp"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace permuto::cli {
+    namespace {
+        const size_t FRAME_HEADER_SIZE = 4;
+        const size_t MAX_FRAME_SIZE = size_t(1) << 30;
+        const char STATUS_OK = 0;
+        const char STATUS_ERROR = 1;
+        const int LISTEN_BACKLOG = 64;
+        const size_t QUEUE_SLOTS_PER_JOB = 4;
+        const auto ACCEPT_RETRY_DELAY = std::chrono::milliseconds(10);
+#if defined(MSG_NOSIGNAL)
+        const int SEND_FLAGS = MSG_NOSIGNAL;  // A vanished peer is an error, not SIGPIPE
+#else
+        const int SEND_FLAGS = 0;
+#endif
+        
+        const std::pair<Format, const char*> FORMAT_NAMES[] = {
+            {Format::Json, "json"},
+            {Format::Cbor, "cbor"},
+            {Format::MessagePack, "msgpack"},
+            {Format::Bson, "bson"},
+            {Format::Ubjson, "ubjson"}
+        };
+        
+        const std::pair<MissingKeyBehavior, const char*> MISSING_KEY_NAMES[] = {
+            {MissingKeyBehavior::Ignore, "ignore"},
+            {MissingKeyBehavior::Error, "error"},
+            {MissingKeyBehavior::Remove, "remove"}
+        };
+        
+        template <typename Enum, size_t Size>
+        std::string name_of(Enum value, const std::pair<Enum, const char*> (&names)[Size]) {
+            for (const auto& [known, name] : names) {
+                if (known == value) {
+                    return name;
+                }
+            }
+            throw std::invalid_argument("Unknown enumeration value");
+        }
+        
+        template <typename Enum, size_t Size>
+        Enum value_of(const std::string& name, const std::pair<Enum, const char*> (&names)[Size],
+                      const std::string& field) {
+            for (const auto& [value, known] : names) {
+                if (name == known) {
+                    return value;
+                }
+            }
+            throw std::invalid_argument("Invalid " + field + ": " + name);
+        }
+        
+        nlohmann::json options_header(const Options& options) {
+            return {
+                {"start_marker", options.start_marker},
+                {"end_marker", options.end_marker},
+                {"enable_interpolation", options.enable_interpolation},
+                {"missing_key_behavior", name_of(options.missing_key_behavior, MISSING_KEY_NAMES)},
+                {"max_recursion_depth", options.max_recursion_depth}
+            };
+        }
+        
+        std::string request_header(const ServeRequest& request) {
+            nlohmann::json header = {
+                {"template", request.template_path},
+                {"template_format", name_of(request.template_format, FORMAT_NAMES)},
+                {"context_format", name_of(request.context_format, FORMAT_NAMES)},
+                {"indent", request.indent},
+                {"options", options_header(request.options)}
+            };
+            return header.dump();
+        }
+        
+        // Fields left out of the header keep their defaults
+        ServeRequest parse_request_header(const std::string& text) {
+            auto header = nlohmann::json::parse(text);
+            ServeRequest request;
+            request.template_path = header.at("template").get<std::string>();
+            request.template_format = value_of(header.value("template_format", "json"), FORMAT_NAMES,
+                                               "template_format");
+            request.context_format = value_of(header.value("context_format", "json"), FORMAT_NAMES,
+                                              "context_format");
+            request.indent = header.value("indent", request.indent);
+            
+            Options& options = request.options;
+            const auto& fields = header.value("options", nlohmann::json::object());
+            options.start_marker = fields.value("start_marker", options.start_marker);
+            options.end_marker = fields.value("end_marker", options.end_marker);
+            options.enable_interpolation = fields.value("enable_interpolation", options.enable_interpolation);
+            options.missing_key_behavior = value_of(fields.value("missing_key_behavior", "ignore"),
+                                                    MISSING_KEY_NAMES, "missing_key_behavior");
+            options.max_recursion_depth = fields.value("max_recursion_depth", options.max_recursion_depth);
+            options.validate();
+            return request;
+        }
+        
+        std::string cache_key(const ServeRequest& request) {
+            return request.template_path + '\n' + name_of(request.template_format, FORMAT_NAMES) + '\n' +
+                   options_header(request.options).dump();
+        }
+        
+        std::timespec modification_time(const struct stat& info) {
+#if defined(__APPLE__)
+            return info.st_mtimespec;
+#else
+            return info.st_mtim;
+#endif
+        }
+        
+        bool operator==(const std::timespec& left, const std::timespec& right) {
+            return left.tv_sec == right.tv_sec && left.tv_nsec == right.tv_nsec;
+        }
+        
+        std::runtime_error socket_error(const std::string& what, const std::string& path) {
+            return std::runtime_error(what + ": " + path + " (" + std::strerror(errno) + ")");
+        }
+        
+        int close_on_exec(int fd) {
+            if (fd >= 0) {
+                ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+            }
+            return fd;
+        }
+        
+        sockaddr_un socket_address(const std::string& path) {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if (path.size() >= sizeof(address.sun_path)) {
+                throw std::runtime_error("Socket path too long: " + path);
+            }
+            std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+            return address;
+        }
+        
+        // Connected socket, or -1 with errno set
+        int connect_to(const std::string& path) {
+            sockaddr_un address = socket_address(path);
+            int fd = close_on_exec(::socket(AF_UNIX, SOCK_STREAM, 0));
+            if (fd < 0) {
+                return -1;
+            }
+            if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+                int error = errno;
+                ::close(fd);
+                errno = error;
+                return -1;
+            }
+            return fd;
+        }
+        
+        // Limit how long a read or write on fd may wait for the peer
+        void set_idle_timeout(int fd, std::chrono::milliseconds timeout) {
+            if (timeout.count() <= 0) {
+                return;
+            }
+            auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+            timeval limit{};
+            limit.tv_sec = static_cast<time_t>(seconds.count());
+            limit.tv_usec = static_cast<suseconds_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(timeout - seconds).count());
+            ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &limit, sizeof(limit));
+            ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &limit, sizeof(limit));
+        }
+        
+        // Read length bytes; fewer only if the peer closed the connection
+        size_t read_full(int fd, char* data, size_t length) {
+            size_t done = 0;
+            while (done < length) {
+                ssize_t count = ::recv(fd, data + done, length - done, 0);
+                if (count == 0) {
+                    break;
+                }
+                if (count < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw std::runtime_error(std::string("Cannot read from socket (") + std::strerror(errno) + ")");
+                }
+                done += static_cast<size_t>(count);
+            }
+            return done;
+        }
+        
+        // False if the connection was closed between frames
+        bool read_frame(int fd, std::string& payload) {
+            std::array<unsigned char, FRAME_HEADER_SIZE> header;
+            size_t count = read_full(fd, reinterpret_cast<char*>(header.data()), header.size());
+            if (count == 0) {
+                return false;
+            }
+            size_t length = 0;
+            for (unsigned char byte : header) {
+                length = (length << 8) | byte;
+            }
+            if (count < header.size() || length > MAX_FRAME_SIZE) {
+                throw std::runtime_error("Malformed frame");
+            }
+            payload.resize(length);
+            if (read_full(fd, payload.data(), length) < length) {
+                throw std::runtime_error("Connection closed in the middle of a frame");
+            }
+            return true;
+        }
+        
+        // Write each payload as a frame, all with as few system calls as possible
+        void send_frames(int fd, std::initializer_list<std::string_view> payloads) {
+            const size_t MAX_FRAMES = 2;
+            std::array<std::array<unsigned char, FRAME_HEADER_SIZE>, MAX_FRAMES> headers;
+            std::array<iovec, 2 * MAX_FRAMES> parts;
+            size_t frames = 0;
+            for (std::string_view payload : payloads) {
+                if (payload.size() > MAX_FRAME_SIZE) {
+                    throw std::runtime_error("Frame too large");
+                }
+                auto& header = headers.at(frames);
+                for (size_t i = 0; i < FRAME_HEADER_SIZE; ++i) {
+                    header[i] = static_cast<unsigned char>(payload.size() >> (8 * (FRAME_HEADER_SIZE - 1 - i)));
+                }
+                parts[2 * frames] = {header.data(), header.size()};
+                parts[2 * frames + 1] = {const_cast<char*>(payload.data()), payload.size()};
+                ++frames;
+            }
+            
+            msghdr message{};
+            message.msg_iov = parts.data();
+            message.msg_iovlen = 2 * frames;
+            while (message.msg_iovlen > 0) {
+                ssize_t sent = ::sendmsg(fd, &message, SEND_FLAGS);
+                if (sent < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw std::runtime_error(std::string("Cannot write to socket (") + std::strerror(errno) + ")");
+                }
+                // Skip the parts written completely and the written start of the next
+                size_t left = static_cast<size_t>(sent);
+                while (message.msg_iovlen > 0 && left >= message.msg_iov->iov_len) {
+                    left -= message.msg_iov->iov_len;
+                    ++message.msg_iov;
+                    --message.msg_iovlen;
+                }
+                if (message.msg_iovlen > 0) {
+                    message.msg_iov->iov_base = static_cast<char*>(message.msg_iov->iov_base) + left;
+                    message.msg_iov->iov_len -= left;
+                }
+            }
+        }
+    }
+    
+    TemplateCache::TemplateCache(size_t capacity) : capacity_(std::max<size_t>(1, capacity)) {}
+    
+    std::shared_ptr<const CompiledTemplate> TemplateCache::get(const ServeRequest& request) {
+        struct stat info {};
+        if (::stat(request.template_path.c_str(), &info) != 0) {
+            const int error = errno;
+            erase_path(request.template_path);
+            errno = error;
+            throw socket_error("Cannot open file", request.template_path);
+        }
+        std::string key = cache_key(request);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto found = entries_.find(key);
+            if (found != entries_.end() && found->second.modified == modification_time(info) &&
+                found->second.size == static_cast<long long>(info.st_size)) {
+                found->second.last_used = ++uses_;
+                return found->second.compiled;
+            }
+        }
+        
+        // The file is checked before it is read, so a change while it is read
+        // at worst causes one more compilation on the next request
+        auto compiled = std::make_shared<const CompiledTemplate>(
+            load_json_file(request.template_path, request.template_format), request.options);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (entries_.size() >= capacity_ && entries_.find(key) == entries_.end()) {
+            // A linear scan, but only when a new template is compiled
+            auto oldest = std::min_element(entries_.begin(), entries_.end(),
+                                           [](const auto& left, const auto& right) {
+                                               return left.second.last_used < right.second.last_used;
+                                           });
+            entries_.erase(oldest);
+        }
+        entries_[key] = Entry{modification_time(info), static_cast<long long>(info.st_size), ++uses_, compiled};
+        return compiled;
+    }
+    
+    size_t TemplateCache::size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+    
+    void TemplateCache::erase_path(const std::string& path) {
+        // Keys start with the path, then a newline
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            if (it->first.size() > path.size() && it->first.compare(0, path.size(), path) == 0 &&
+                it->first[path.size()] == '\n') {
+                it = entries_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    
+    Server::Server(std::string socket_path, ServeSettings settings)
+        : socket_path_(std::move(socket_path)), settings_(settings) {
+        sockaddr_un address = socket_address(socket_path_);
+        
+        struct stat info {};
+        if (::lstat(socket_path_.c_str(), &info) == 0) {
+            if (!S_ISSOCK(info.st_mode)) {
+                throw std::runtime_error("Not a socket: " + socket_path_);
+            }
+            int fd = connect_to(socket_path_);
+            if (fd >= 0) {
+                ::close(fd);
+                throw std::runtime_error("Another server is listening on " + socket_path_);
+            }
+            // Left behind by a server that is no longer running
+            ::unlink(socket_path_.c_str());
+        }
+        
+        int wake_fds[2];
+        if (::pipe(wake_fds) != 0) {
+            throw socket_error("Cannot create socket", socket_path_);
+        }
+        wake_read_fd_ = close_on_exec(wake_fds[0]);
+        wake_write_fd_ = close_on_exec(wake_fds[1]);
+        
+        // Permissions are restricted before listen(), so no other user can
+        // ever connect
+        listen_fd_ = close_on_exec(::socket(AF_UNIX, SOCK_STREAM, 0));
+        if (listen_fd_ < 0 ||
+            ::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::chmod(socket_path_.c_str(), S_IRUSR | S_IWUSR) != 0 ||
+            ::listen(listen_fd_, LISTEN_BACKLOG) != 0) {
+            auto error = socket_error("Cannot listen on socket", socket_path_);
+            if (listen_fd_ >= 0) {
+                ::close(listen_fd_);
+            }
+            ::close(wake_read_fd_);
+            ::close(wake_write_fd_);
+            throw error;
+        }
+    }
+    
+    Server::~Server() {
+        ::close(listen_fd_);
+        ::close(wake_read_fd_);
+        ::close(wake_write_fd_);
+        ::unlink(socket_path_.c_str());
+    }
+    
+    void Server::stop() {
+        stopping_.store(true);
+        char byte = 0;
+        while (::write(wake_write_fd_, &byte, 1) < 0 && errno == EINTR) {
+        }
+    }
+    
+    void Server::run() {
+        size_t jobs = settings_.jobs;
+        if (jobs == 0) {
+            jobs = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+        
+        BoundedQueue<int> pending(jobs * QUEUE_SLOTS_PER_JOB);
+        auto worker = [&] {
+            int fd = -1;
+            while (pending.pop(fd)) {
+                {
+                    // Registered under the lock, so a connection is either
+                    // shut down by the stop below or never served
+                    std::lock_guard<std::mutex> lock(connections_mutex_);
+                    if (stopping_.load()) {
+                        ::close(fd);
+                        continue;
+                    }
+                    connections_.insert(fd);
+                }
+                serve_connection(fd);
+                {
+                    std::lock_guard<std::mutex> lock(connections_mutex_);
+                    connections_.erase(fd);
+                }
+                ::close(fd);
+            }
+        };
+        std::vector<std::thread> workers;
+        workers.reserve(jobs);
+        for (size_t i = 0; i < jobs; ++i) {
+            workers.emplace_back(worker);
+        }
+        
+        std::string failure;
+        // Accepted while the queue was full; until it has room only stop()
+        // is waited for, so the loop never blocks on the queue
+        int held = -1;
+        std::array<pollfd, 2> waiting{{{wake_read_fd_, POLLIN, 0}, {listen_fd_, POLLIN, 0}}};
+        while (!stopping_.load()) {
+            if (held >= 0 && pending.try_push(held)) {
+                held = -1;
+            }
+            nfds_t count = held >= 0 ? 1 : waiting.size();
+            int timeout = held >= 0 ? static_cast<int>(ACCEPT_RETRY_DELAY.count()) : -1;
+            if (::poll(waiting.data(), count, timeout) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                failure = socket_error("Cannot wait for connections", socket_path_).what();
+                break;
+            }
+            if (waiting[0].revents != 0) {
+                break;
+            }
+            if (held >= 0) {
+                continue;
+            }
+            int fd = close_on_exec(::accept(listen_fd_, nullptr, nullptr));
+            if (fd >= 0) {
+                set_idle_timeout(fd, settings_.idle_timeout);
+                if (!pending.try_push(fd)) {
+                    held = fd;
+                }
+            } else if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                // Out of descriptors or memory until a connection finishes
+                std::this_thread::sleep_for(ACCEPT_RETRY_DELAY);
+            } else if (errno != EINTR && errno != ECONNABORTED && errno != EAGAIN) {
+                failure = socket_error("Cannot accept connection", socket_path_).what();
+                break;
+            }
+        }
+        
+        // Queued connections are closed unanswered; open ones see end of input
+        // once their current request has been answered
+        stopping_.store(true);
+        if (held >= 0) {
+            ::close(held);
+        }
+        pending.close();
+        {
+            std::lock_guard<std::mutex> lock(connections_mutex_);
+            for (int fd : connections_) {
+                ::shutdown(fd, SHUT_RD);
+            }
+        }
+        for (auto& thread : workers) {
+            thread.join();
+        }
+        if (!failure.empty()) {
+            throw std::runtime_error(failure);
+        }
+    }
+    
+    void Server::serve_connection(int fd) {
+        std::string header;
+        std::string context;
+        std::string response;
+        try {
+            while (read_frame(fd, header) && read_frame(fd, context)) {
+                response.assign(1, STATUS_OK);
+                try {
+                    ServeRequest request = parse_request_header(header);
+                    auto compiled = cache_.get(request);
+                    StringSink sink(response);
+                    compiled->render(decode(context, request.context_format), sink, request.indent);
+                } catch (const std::exception& e) {
+                    response.assign(1, STATUS_ERROR);
+                    response += e.what();
+                }
+                send_frames(fd, {response});
+            }
+        } catch (const std::exception&) {
+            // The client went away or broke the protocol; drop the connection
+        }
+    }
+    
+    Client::Client(const std::string& socket_path) : fd_(connect_to(socket_path)) {
+        if (fd_ < 0) {
+            throw socket_error("Cannot connect to server", socket_path);
+        }
+    }
+    
+    Client::~Client() {
+        ::close(fd_);
+    }
+    
+    std::string Client::apply(const ServeRequest& request, std::string_view context) {
+        header_ = request_header(request);
+        send_frames(fd_, {header_, context});
+        if (!read_frame(fd_, response_) || response_.empty()) {
+            throw std::runtime_error("Server closed the connection");
+        }
+        if (response_[0] != STATUS_OK) {
+            throw std::runtime_error(response_.substr(1));
+        }
+        return response_.substr(1);
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <permuto/permuto.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace permuto::cli {
+    // Protocol between `permuto --serve` and its clients
+    //
+    // Every message is a frame: the payload length as 4 bytes, big-endian,
+    // followed by the payload. A request is two frames: a JSON header
+    //   {"template": "/abs/template.json", "template_format": "json",
+    //    "context_format": "json", "indent": 2,
+    //    "options": {"start_marker": "${", "end_marker": "}",
+    //                "enable_interpolation": false, "missing_key_behavior": "ignore",
+    //                "max_recursion_depth": 64}}
+    // and the context, encoded in context_format. The response is one frame
+    // holding a status byte, then the result as JSON text on success or the
+    // error message on failure. A connection carries any number of requests,
+    // answered one at a time in order.
+    struct ServeRequest {
+        std::string template_path;  // Read by the server; relative to its working directory
+        Format template_format = Format::Json;
+        Format context_format = Format::Json;
+        int indent = -1;            // As for render(); < 0 is compact
+        Options options;
+    };
+    
+    // Compiled templates by path, format and options
+    // Each lookup checks the file's modification time and size, so an edited
+    // template is compiled again on its next use, and a deleted one is
+    // dropped. At most capacity templates are kept; the least recently used
+    // is dropped to make room. Templates are compiled outside the lock;
+    // requests for other templates are never held up.
+    class TemplateCache {
+    public:
+        static constexpr size_t DEFAULT_CAPACITY = 256;
+        
+        explicit TemplateCache(size_t capacity = DEFAULT_CAPACITY);
+        
+        // Throws std::runtime_error if the file cannot be read, and whatever
+        // loading or compiling the template throws
+        std::shared_ptr<const CompiledTemplate> get(const ServeRequest& request);
+        
+        size_t size() const;
+    
+    private:
+        struct Entry {
+            std::timespec modified{};
+            long long size = 0;
+            unsigned long long last_used = 0;
+            std::shared_ptr<const CompiledTemplate> compiled;
+        };
+        
+        void erase_path(const std::string& path);
+        
+        const size_t capacity_;
+        mutable std::mutex mutex_;
+        unsigned long long uses_ = 0;
+        std::unordered_map<std::string, Entry> entries_;
+    };
+    
+    struct ServeSettings {
+        size_t jobs = 0;  // Worker threads; 0 means one per hardware thread
+        
+        // A connection that sends or accepts nothing for this long is closed,
+        // freeing its worker; zero waits forever
+        std::chrono::milliseconds idle_timeout = std::chrono::seconds(60);
+    };
+    
+    // Answers requests on a Unix domain socket with templates from a shared
+    // TemplateCache
+    // Each connection is served by one worker thread until the client closes
+    // it or stays idle for idle_timeout, so at most jobs clients are served
+    // at once; further connections wait to be picked up. While the wait
+    // queue is full no more connections are accepted.
+    class Server {
+    public:
+        // Binds and listens on socket_path, readable and writable by the
+        // current user only. A socket file left behind by a server that is no
+        // longer running is replaced. Throws std::runtime_error if another
+        // server is listening there or the socket cannot be created.
+        Server(std::string socket_path, ServeSettings settings = {});
+        ~Server();  // Removes the socket file
+        
+        Server(const Server&) = delete;
+        Server& operator=(const Server&) = delete;
+        
+        // Serve until stop(); returns once every open connection has finished
+        // its current request
+        void run();
+        
+        // Stop accepting connections; only uses async-signal-safe calls, so it
+        // can be called from a signal handler
+        void stop();
+    
+    private:
+        void serve_connection(int fd);
+        
+        const std::string socket_path_;
+        const ServeSettings settings_;
+        int listen_fd_ = -1;
+        int wake_read_fd_ = -1;   // Becomes readable when stop() is called
+        int wake_write_fd_ = -1;
+        std::atomic<bool> stopping_{false};
+        TemplateCache cache_;
+        
+        std::mutex connections_mutex_;
+        std::unordered_set<int> connections_;  // Being served, shut down by run() on stop
+    };
+    
+    // Connection to a Server
+    class Client {
+    public:
+        // Throws std::runtime_error if nothing is listening on socket_path
+        explicit Client(const std::string& socket_path);
+        ~Client();
+        
+        Client(const Client&) = delete;
+        Client& operator=(const Client&) = delete;
+        
+        // Send one request and return the result text; context is sent as is,
+        // so the client never parses it. Throws std::runtime_error with the
+        // server's message if the request failed.
+        std::string apply(const ServeRequest& request, std::string_view context);
+    
+    private:
+        int fd_ = -1;
+        std::string header_;
+        std::string response_;
+    };
+}
@@ -1,8 +1,13 @@
 #pragma once
 #include <nlohmann/json.hpp>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
+#include <memory>
+#include <exception>
+#include <functional>
+#include <iosfwd>
 #include <stdexcept>
 
 namespace permuto {
@@ -13,6 +18,12 @@ namespace permuto {
         Remove   // Remove the containing key/element
     };
 
+    // Template traversal strategy
+    enum class ProcessingEngine {
+        Recursive,  // Native recursion, one stack frame chain per nesting level (default)
+        Iterative   // Explicit heap-allocated stack; safe for very deep templates
+    };
+
     struct Options {
         std::string start_marker = "${";
         std::string end_marker = "}";
@@ -20,6 +31,30 @@ namespace permuto {
         MissingKeyBehavior missing_key_behavior = MissingKeyBehavior::Ignore;
         size_t max_recursion_depth = 64;
         
+        // Arrays and objects with at least this many children are processed
+        // on worker threads and stitched back in order; 0 disables this
+        size_t parallel_threshold = 0;
+        size_t parallel_threads = 0;  // Worker threads; 0 uses one per hardware thread
+        
+        // Both engines produce identical results and exceptions; Iterative
+        // keeps native stack use constant, so max_recursion_depth can be
+        // raised far beyond what the recursive engine's stack allows. The
+        // engine applies to apply(), apply_inplace(), Pipeline and
+        // apply_batch() of an uncompiled template. render() and
+        // render_stream() walk templates without recursion under either
+        // engine; CompiledTemplate and TemplateArtifact always recurse and
+        // throw std::invalid_argument for Iterative.
+        // Iterative processing is always serial (parallel_threshold is ignored).
+        ProcessingEngine engine = ProcessingEngine::Recursive;
+        
+        // Expand placeholders inside resolved context values as well, so a
+        // context that refers to itself is fully resolved in one pass. Each
+        // path is expanded once per call and reused at every later use; a
+        // path that (indirectly) refers to itself throws CycleException with
+        // the chain of paths involved. Every level of expansion counts as one
+        // level of nesting towards max_recursion_depth.
+        bool recursive_expansion = false;
+        
         void validate() const;  // Throws std::invalid_argument if invalid
     };
 
@@ -60,7 +95,7 @@ namespace permuto {
     // THREAD SAFETY GUARANTEE:
     // All public API functions are thread-safe and can be called concurrently
     // from multiple threads without synchronization. Each function call operates
-    // on independent data and uses thread-local storage for internal state.
+    // on independent data and keeps its internal state in per-call storage.
     
     // Apply template substitutions to a JSON template using a context
     // Thread-safe: Can be called concurrently from multiple threads
@@ -70,6 +105,352 @@ namespace permuto {
         const Options& options = {}
     );
     
+    // Consuming overloads for inputs the caller no longer needs
+    // A context passed by rvalue has referenced values moved into the result
+    // instead of copied: each value is moved at its last use and copied at
+    // earlier uses; values that overlap another referenced value (one contains
+    // the other) are always copied. A template passed by rvalue becomes the
+    // result, with only its placeholder sites rewritten. Moved-from inputs are
+    // left in a valid but unspecified state.
+    // Thread-safe: Can be called concurrently from multiple threads
+    nlohmann::json apply(
+        const nlohmann::json& template_json,
+        nlohmann::json&& context,
+        const Options& options = {}
+    );
+    
+    nlohmann::json apply(
+        nlohmann::json&& template_json,
+        const nlohmann::json& context,
+        const Options& options = {}
+    );
+    
+    nlohmann::json apply(
+        nlohmann::json&& template_json,
+        nlohmann::json&& context,
+        const Options& options = {}
+    );
+    
+    // Apply template substitutions directly to a caller-owned document
+    // doc holds the template on entry and the result on return. Only
+    // placeholder-bearing strings are rewritten and Remove mode erases the
+    // affected keys/elements, so literal parts of doc are never rebuilt.
+    // doc must not alias context; if an exception is thrown, doc is left
+    // partially substituted.
+    // Thread-safe: Can be called concurrently on different documents
+    void apply_inplace(
+        nlohmann::json& doc,
+        const nlohmann::json& context,
+        const Options& options = {}
+    );
+    
+    // In-place application that also consumes the context (see apply above)
+    void apply_inplace(
+        nlohmann::json& doc,
+        nlohmann::json&& context,
+        const Options& options = {}
+    );
+    
+    // Destination for the text written by render()
+    // Output arrives in order, in chunks of arbitrary size.
+    class Sink {
+    public:
+        virtual ~Sink() = default;
+        virtual void write(const char* data, size_t length) = 0;
+    };
+    
+    // Writes to an output stream
+    class StreamSink : public Sink {
+    public:
+        explicit StreamSink(std::ostream& stream);
+        void write(const char* data, size_t length) override;
+        
+    private:
+        std::ostream& stream_;
+    };
+    
+    // Appends to a string; clear() it between renders to reuse its capacity
+    class StringSink : public Sink {
+    public:
+        explicit StringSink(std::string& output);
+        void write(const char* data, size_t length) override;
+        
+    private:
+        std::string& output_;
+    };
+    
+    // Passes each chunk to a callback; the view is only valid during the call
+    class CallbackSink : public Sink {
+    public:
+        explicit CallbackSink(std::function<void(std::string_view)> callback);
+        void write(const char* data, size_t length) override;
+        
+    private:
+        std::function<void(std::string_view)> callback_;
+    };
+    
+    // Apply a template and write the result as JSON text, without building
+    // the result document
+    // The output is byte-identical to apply(...).dump(indent): indent < 0 is
+    // compact, otherwise pretty-printed with indent spaces per level. Literal
+    // parts of the template and resolved context values are serialized in
+    // place. Processing is always serial (parallel_threshold is ignored).
+    // If an exception is thrown, the output written so far is incomplete.
+    // Thread-safe: Can be called concurrently with different sinks
+    void render(
+        const nlohmann::json& template_json,
+        const nlohmann::json& context,
+        const Options& options,
+        Sink& sink,
+        int indent = -1
+    );
+    
+    // Encodings of templates, contexts and results
+    // The binary formats are those of nlohmann::json::to_cbor(), to_msgpack(),
+    // to_bson() and to_ubjson().
+    enum class Format {
+        Json,
+        Cbor,
+        MessagePack,
+        Bson,   // The top-level value must be an object
+        Ubjson
+    };
+    
+    // Parse a document held in the given format, such as a MessagePack
+    // request body or a memory-mapped file
+    // Throws nlohmann::json::parse_error if data is not a valid document.
+    // Thread-safe: Can be called concurrently from multiple threads
+    nlohmann::json decode(std::string_view data, Format format);
+    
+    // Write value to sink in the given format; indent applies to Json only
+    // Throws nlohmann::json::type_error if the format cannot hold value
+    // (BSON requires an object).
+    // Thread-safe: Can be called concurrently with different sinks
+    void encode(const nlohmann::json& value, Format format, Sink& sink, int indent = -1);
+    
+    // Apply a template and write the result to sink in format
+    // Format::Json is render() with compact output. The binary formats
+    // encode the applied document directly, with no intermediate text.
+    // Thread-safe: Can be called concurrently with different sinks
+    void render(
+        const nlohmann::json& template_json,
+        const nlohmann::json& context,
+        const Options& options,
+        Sink& sink,
+        Format format
+    );
+    
+    // Apply a template read as a stream of parse events, for templates too
+    // large to hold in memory
+    // The template is never parsed into a document: each value is substituted
+    // and written to sink as soon as it has been read, so memory use is
+    // bounded by nesting depth and the longest single string, plus the
+    // context. Substitution follows apply() with two differences: object
+    // members keep their order in the template instead of being sorted, and
+    // duplicate keys are all written. For templates whose keys are sorted and
+    // unique the output is byte-identical to render().
+    // Throws nlohmann::json::parse_error if the template text is malformed;
+    // as with render(), the output written before an exception is incomplete.
+    // Thread-safe: Can be called concurrently with different inputs and sinks
+    void render_stream(
+        std::istream& template_input,
+        const nlohmann::json& context,
+        const Options& options,
+        Sink& sink,
+        int indent = -1
+    );
+    
+    // Streaming application of template text already in memory, such as a
+    // memory-mapped file
+    void render_stream(
+        std::string_view template_text,
+        const nlohmann::json& context,
+        const Options& options,
+        Sink& sink,
+        int indent = -1
+    );
+    
+    // Streaming application of a template in any Format, written as JSON text
+    // Binary templates are read as parse events straight from their encoding,
+    // so there is no text round trip.
+    void render_stream(
+        std::istream& template_input,
+        Format template_format,
+        const nlohmann::json& context,
+        const Options& options,
+        Sink& sink,
+        int indent = -1
+    );
+    
+    void render_stream(
+        std::string_view template_data,
+        Format template_format,
+        const nlohmann::json& context,
+        const Options& options,
+        Sink& sink,
+        int indent = -1
+    );
+    
+    // Template compiled once for repeated application against many contexts
+    // Placeholder sites, JSON Pointer tokens and literal subtrees are analyzed
+    // at construction, so apply() only performs lookups and copies.
+    // Produces the same results as permuto::apply() with the same options.
+    // Compilation and application recurse once per nesting level, so
+    // ProcessingEngine::Iterative is rejected with std::invalid_argument.
+    // Thread-safe: Immutable after construction, apply() can be called
+    // concurrently from multiple threads
+    class CompiledTemplate {
+    public:
+        explicit CompiledTemplate(const nlohmann::json& template_json,
+                                  const Options& options = {});
+        
+        // Apply the compiled template to a context
+        nlohmann::json apply(const nlohmann::json& context) const;
+        
+        // Write the result of apply(context) as text (see permuto::render)
+        void render(const nlohmann::json& context, Sink& sink, int indent = -1) const;
+        
+        const Options& options() const;
+        
+    private:
+        class Impl;
+        std::shared_ptr<const Impl> impl_;
+    };
+    
+    // Compiled template stored as a versioned binary file
+    // serialize() compiles a template with its options into a flat layout of
+    // nodes, pre-split interpolation segments and pre-parsed JSON Pointer
+    // tokens. open() maps such a file read-only and applies it where it lies:
+    // nothing is parsed or relocated, so loading costs a checksum and bounds
+    // checks, and processes opening the same file share its pages. The
+    // options are those of serialize(). Produces the same results as
+    // CompiledTemplate. Files are specific to the byte order that wrote them.
+    // open() and view() throw InvalidTemplateException for data that is not
+    // a valid artifact of this version or fails its checksum.
+    // Thread-safe: Immutable after loading, apply() and render() can be
+    // called concurrently from multiple threads
+    class TemplateArtifact {
+    public:
+        // Artifact bytes for a template; throws std::invalid_argument like
+        // CompiledTemplate, and for binary values
+        static std::string serialize(const nlohmann::json& template_json,
+                                     const Options& options = {});
+        
+        // Map an artifact file; it must not be modified while in use
+        static TemplateArtifact open(const std::string& path);
+        
+        // Use artifact bytes in memory, which must outlive the result
+        // Data that is not 8-byte aligned is copied.
+        static TemplateArtifact view(std::string_view data);
+        
+        nlohmann::json apply(const nlohmann::json& context) const;
+        
+        // Write the result of apply(context) as text (see permuto::render)
+        void render(const nlohmann::json& context, Sink& sink, int indent = -1) const;
+        
+        const Options& options() const;
+    
+    private:
+        class Impl;
+        explicit TemplateArtifact(std::shared_ptr<const Impl> impl);
+        std::shared_ptr<const Impl> impl_;
+    };
+    
+    // One stage of a Pipeline: a template and the options, including the
+    // placeholder markers, it is applied with
+    struct PipelineStage {
+        nlohmann::json template_json;
+        Options options;
+    };
+    
+    // Chain of templates where each stage is applied to the output of the one
+    // before it, and the first stage to the context passed to apply()
+    // Intermediate outputs are never built as whole documents: a placeholder
+    // of a later stage is resolved by walking the earlier stage's template to
+    // the node it refers to and substituting only that part, recursively
+    // through earlier stages. Array indices account for elements that Remove
+    // mode drops. The result equals applying the stages one after another,
+    // except that errors in parts of intermediate stages that no later stage
+    // refers to are not reported. Throws std::invalid_argument if there are
+    // no stages or a stage's options or template are invalid.
+    // Thread-safe: Immutable after construction, apply() can be called
+    // concurrently from multiple threads
+    class Pipeline {
+    public:
+        explicit Pipeline(std::vector<PipelineStage> stages);
+        
+        // Run all stages against a context and return the final output
+        nlohmann::json apply(const nlohmann::json& context) const;
+        
+        size_t size() const;
+        
+    private:
+        class Impl;
+        std::shared_ptr<const Impl> impl_;
+    };
+    
+    // A placeholder syntax and the context its placeholders resolve against
+    struct MarkerContext {
+        std::string start_marker;
+        std::string end_marker;
+        const nlohmann::json* context = nullptr;  // Must outlive the call
+    };
+    
+    // Apply a template that mixes several placeholder syntaxes, such as
+    // ${/user/name} against a request and #{/region} against configuration
+    // Every string is scanned once for all start markers together, however
+    // many marker pairs there are. Each placeholder resolves against the
+    // context of its own pair; substitution otherwise follows apply() with
+    // options, whose start_marker and end_marker are not used. The result
+    // equals applying the template once per pair, as long as no substituted
+    // value contains another pair's markers and placeholders of different
+    // pairs do not overlap. Throws std::invalid_argument if a pair's markers
+    // are invalid, two pairs share a start marker, a context is null, or
+    // options select recursive_expansion or ProcessingEngine::Iterative.
+    // Thread-safe: Can be called concurrently from multiple threads
+    nlohmann::json apply_multi(
+        const nlohmann::json& template_json,
+        const std::vector<MarkerContext>& contexts,
+        const Options& options = {}
+    );
+    
+    // Settings for apply_batch
+    struct BatchOptions {
+        size_t threads = 0;  // Worker threads; 0 uses one per hardware thread
+    };
+    
+    // Outcome of applying a template to one context of a batch
+    struct BatchResult {
+        nlohmann::json result;     // Substituted template, if no error occurred
+        std::exception_ptr error;  // Exception thrown for this context, if any
+        
+        bool ok() const { return !error; }
+    };
+    
+    // Apply one template to many contexts in parallel
+    // The template is compiled once (see CompiledTemplate) and contexts are
+    // spread across a work-stealing pool of worker threads started for this
+    // call; with one thread, or one context, they are applied on the calling
+    // thread. Results are returned in input order. An exception while processing
+    // one context is captured in its BatchResult and does not affect the
+    // others; invalid options or templates throw before any work starts.
+    // With ProcessingEngine::Iterative the template is not compiled: each
+    // context is processed as by apply(), still in parallel.
+    // Thread-safe: Can be called concurrently from multiple threads
+    std::vector<BatchResult> apply_batch(
+        const nlohmann::json& template_json,
+        const std::vector<nlohmann::json>& contexts,
+        const Options& options = {},
+        const BatchOptions& batch_options = {}
+    );
+    
+    // Batch application of an already compiled template
+    std::vector<BatchResult> apply_batch(
+        const CompiledTemplate& compiled,
+        const std::vector<nlohmann::json>& contexts,
+        const BatchOptions& batch_options = {}
+    );
+    
     // Create a reverse template that can reconstruct the original context
     // Thread-safe: Can be called concurrently from multiple threads
     nlohmann::json create_reverse_template(
@@ -83,4 +464,12 @@ namespace permuto {
         const nlohmann::json& reverse_template,
         const nlohmann::json& result_json
     );
+    
+    // Consuming overload: mapped values are moved out of result_json at their
+    // last use instead of copied
+    // Thread-safe: Can be called concurrently from multiple threads
+    nlohmann::json apply_reverse(
+        const nlohmann::json& reverse_template,
+        nlohmann::json&& result_json
+    );
 }
\ No newline at end of file
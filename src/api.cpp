@@ -1,31 +1,198 @@
 #include "../include/permuto/permuto.hpp"
 #include "template_processor.hpp"
+#include "multi_marker_processor.hpp"
 #include "reverse_processor.hpp"
+#include "stream_renderer.hpp"
+#include "formats.hpp"
 #include "placeholder_parser.hpp"
+#include "thread_pool.hpp"
 
 namespace permuto {
+    namespace {
+        // Validate root-level Remove mode
+        void validate_root_placeholder(const nlohmann::json& template_json, const Options& options) {
+            if (options.missing_key_behavior == MissingKeyBehavior::Remove && 
+                template_json.is_string()) {
+                // Check if the entire template is a single placeholder
+                PlaceholderParser parser(options.start_marker, options.end_marker);
+                auto placeholder_path = parser.extract_exact_placeholder(template_json.get<std::string>());
+                if (placeholder_path) {
+                    throw std::invalid_argument("Remove mode cannot be used with root-level placeholders");
+                }
+            }
+        }
+        
+        // Apply to every context on a work-stealing pool, capturing errors per context
+        template <typename ApplyOne>
+        std::vector<BatchResult> run_batch(const std::vector<nlohmann::json>& contexts,
+                                           const BatchOptions& batch_options,
+                                           const ApplyOne& apply_one) {
+            std::vector<BatchResult> results(contexts.size());
+            
+            // Each index writes only its own slot, so results need no locking
+            size_t threads = resolve_thread_count(batch_options.threads, contexts.size());
+            parallel_for(contexts.size(), threads, [&](size_t index) {
+                try {
+                    results[index].result = apply_one(contexts[index]);
+                } catch (...) {
+                    results[index].error = std::current_exception();
+                }
+            });
+            
+            return results;
+        }
+    }
+    
     // Thread-safe public API implementation
     // Each function creates its own processor instance to ensure thread safety
     
     nlohmann::json apply(const nlohmann::json& template_json,
                         const nlohmann::json& context,
                         const Options& options) {
-        // Validate root-level Remove mode
-        if (options.missing_key_behavior == MissingKeyBehavior::Remove && 
-            template_json.is_string()) {
-            // Check if the entire template is a single placeholder
-            PlaceholderParser parser(options.start_marker, options.end_marker);
-            auto placeholder_path = parser.extract_exact_placeholder(template_json.get<std::string>());
-            if (placeholder_path) {
-                throw std::invalid_argument("Remove mode cannot be used with root-level placeholders");
-            }
-        }
+        validate_root_placeholder(template_json, options);
         
-        // Create new processor instance - thread-safe due to thread-local storage
+        // Create new processor instance - thread-safe, processing state is per call
         TemplateProcessor processor(options);
         return processor.process(template_json, context);
     }
     
+    nlohmann::json apply(const nlohmann::json& template_json,
+                        nlohmann::json&& context,
+                        const Options& options) {
+        validate_root_placeholder(template_json, options);
+        
+        TemplateProcessor processor(options);
+        return processor.process(template_json, std::move(context));
+    }
+    
+    nlohmann::json apply(nlohmann::json&& template_json,
+                        const nlohmann::json& context,
+                        const Options& options) {
+        // The template becomes the result; only placeholder sites are rewritten
+        apply_inplace(template_json, context, options);
+        return std::move(template_json);
+    }
+    
+    nlohmann::json apply(nlohmann::json&& template_json,
+                        nlohmann::json&& context,
+                        const Options& options) {
+        apply_inplace(template_json, std::move(context), options);
+        return std::move(template_json);
+    }
+    
+    void apply_inplace(nlohmann::json& doc,
+                       const nlohmann::json& context,
+                       const Options& options) {
+        validate_root_placeholder(doc, options);
+        
+        TemplateProcessor processor(options);
+        processor.process_inplace(doc, context);
+    }
+    
+    void apply_inplace(nlohmann::json& doc,
+                       nlohmann::json&& context,
+                       const Options& options) {
+        validate_root_placeholder(doc, options);
+        
+        TemplateProcessor processor(options);
+        processor.process_inplace(doc, std::move(context));
+    }
+    
+    void render(const nlohmann::json& template_json,
+                const nlohmann::json& context,
+                const Options& options,
+                Sink& sink,
+                int indent) {
+        // Walk the template as if it were being parsed; nothing is compiled
+        StreamRenderer renderer(context, options, sink, indent);
+        renderer.render_value(template_json);
+        renderer.finish();
+    }
+    
+    void render(const nlohmann::json& template_json,
+                const nlohmann::json& context,
+                const Options& options,
+                Sink& sink,
+                Format format) {
+        if (format == Format::Json) {
+            render(template_json, context, options, sink, -1);
+            return;
+        }
+        encode(apply(template_json, context, options), format, sink);
+    }
+    
+    void render_stream(std::istream& template_input,
+                       const nlohmann::json& context,
+                       const Options& options,
+                       Sink& sink,
+                       int indent) {
+        render_stream(template_input, Format::Json, context, options, sink, indent);
+    }
+    
+    void render_stream(std::string_view template_text,
+                       const nlohmann::json& context,
+                       const Options& options,
+                       Sink& sink,
+                       int indent) {
+        render_stream(template_text, Format::Json, context, options, sink, indent);
+    }
+    
+    void render_stream(std::istream& template_input,
+                       Format template_format,
+                       const nlohmann::json& context,
+                       const Options& options,
+                       Sink& sink,
+                       int indent) {
+        StreamRenderer renderer(context, options, sink, indent);
+        nlohmann::json::sax_parse(template_input, &renderer, to_input_format(template_format));
+        renderer.finish();
+    }
+    
+    void render_stream(std::string_view template_data,
+                       Format template_format,
+                       const nlohmann::json& context,
+                       const Options& options,
+                       Sink& sink,
+                       int indent) {
+        StreamRenderer renderer(context, options, sink, indent);
+        nlohmann::json::sax_parse(template_data.begin(), template_data.end(), &renderer,
+                                  to_input_format(template_format));
+        renderer.finish();
+    }
+    
+    nlohmann::json apply_multi(const nlohmann::json& template_json,
+                               const std::vector<MarkerContext>& contexts,
+                               const Options& options) {
+        MultiMarkerProcessor processor(contexts, options);
+        return processor.process(template_json);
+    }
+    
+    std::vector<BatchResult> apply_batch(const nlohmann::json& template_json,
+                                         const std::vector<nlohmann::json>& contexts,
+                                         const Options& options,
+                                         const BatchOptions& batch_options) {
+        if (options.engine == ProcessingEngine::Iterative) {
+            // Compiled templates recurse, so each context is processed as by apply()
+            TemplateProcessor processor(options);
+            validate_root_placeholder(template_json, options);
+            return run_batch(contexts, batch_options, [&](const nlohmann::json& context) {
+                return processor.process(template_json, context);
+            });
+        }
+        
+        // Compile once; invalid options or templates throw here
+        CompiledTemplate compiled(template_json, options);
+        return apply_batch(compiled, contexts, batch_options);
+    }
+    
+    std::vector<BatchResult> apply_batch(const CompiledTemplate& compiled,
+                                         const std::vector<nlohmann::json>& contexts,
+                                         const BatchOptions& batch_options) {
+        return run_batch(contexts, batch_options, [&](const nlohmann::json& context) {
+            return compiled.apply(context);
+        });
+    }
+    
     nlohmann::json create_reverse_template(const nlohmann::json& template_json,
                                           const Options& options) {
         // Create new processor instance - thread-safe
@@ -39,4 +206,10 @@ namespace permuto {
         ReverseProcessor processor; // Use default options
         return processor.apply_reverse(reverse_template, result_json);
     }
-}
\ No newline at end of file
+    
+    nlohmann::json apply_reverse(const nlohmann::json& reverse_template,
+                                nlohmann::json&& result_json) {
+        ReverseProcessor processor; // Use default options
+        return processor.apply_reverse(reverse_template, std::move(result_json));
+    }
+}
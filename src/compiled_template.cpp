@@ -0,0 +1,329 @@
+#include "compiled_template.hpp"
+
+namespace permuto {
+    CompiledTemplate::Impl::Impl(const nlohmann::json& template_json, const Options& options)
+        : options_(options), parser_(options.start_marker, options.end_marker), processor_(options) {
+        options_.validate();
+        // Compilation and application recurse once per nesting level
+        if (options_.engine == ProcessingEngine::Iterative) {
+            throw std::invalid_argument("The iterative engine cannot be used with compiled templates");
+        }
+        root_ = compile_value(template_json, 0);
+
+        // Validate root-level Remove mode
+        if (options_.missing_key_behavior == MissingKeyBehavior::Remove &&
+            root_.kind == NodeKind::ExactPlaceholder) {
+            throw std::invalid_argument("Remove mode cannot be used with root-level placeholders");
+        }
+    }
+
+    nlohmann::json CompiledTemplate::Impl::apply(const nlohmann::json& context) const {
+        nlohmann::json result;
+        ProcessingContext ctx;
+        apply_node(root_, context, result, ctx);
+        return result;
+    }
+
+    void CompiledTemplate::Impl::render(const nlohmann::json& context, Sink& sink, int indent) const {
+        ProcessingContext ctx;
+        JsonWriter writer(sink, indent);
+        render_node(root_, context, writer, ctx);
+        writer.flush();
+    }
+
+    CompiledNode CompiledTemplate::Impl::compile_value(const nlohmann::json& value, size_t depth) const {
+        if (value.is_string()) {
+            return compile_string(value.get_ref<const std::string&>(), depth);
+        }
+
+        CompiledNode node;
+        node.depth = depth;
+        node.exceeds_depth = depth >= options_.max_recursion_depth;
+
+        // Applying throws on reaching this node, so its children are never
+        // needed; stopping here also bounds recursion on very deep input
+        if (node.exceeds_depth) {
+            if (value.is_object()) {
+                node.kind = NodeKind::Object;
+            } else if (value.is_array()) {
+                node.kind = NodeKind::Array;
+            }
+            return node;
+        }
+
+        if (value.is_object()) {
+            node.kind = NodeKind::Object;
+            for (auto it = value.begin(); it != value.end(); ++it) {
+                node.keys.push_back(it.key());
+                node.quoted_keys.push_back(quote_key(it.key()));
+                node.children.push_back(compile_value(it.value(), depth + 1));
+            }
+        } else if (value.is_array()) {
+            node.kind = NodeKind::Array;
+            for (const auto& item : value) {
+                node.children.push_back(compile_value(item, depth + 1));
+            }
+        }
+
+        // Collapse subtrees without placeholders into a single literal copy
+        // Children were collapsed first, so their literals are moved up rather
+        // than the subtree copied again at every level
+        bool all_literal = !node.exceeds_depth;
+        for (const auto& child : node.children) {
+            if (child.kind != NodeKind::Literal || child.exceeds_depth) {
+                all_literal = false;
+                break;
+            }
+        }
+        if (all_literal) {
+            if (node.kind == NodeKind::Object) {
+                node.literal = nlohmann::json::object();
+                for (size_t i = 0; i < node.children.size(); ++i) {
+                    node.literal.emplace(std::move(node.keys[i]), std::move(node.children[i].literal));
+                }
+            } else if (node.kind == NodeKind::Array) {
+                node.literal = nlohmann::json::array();
+                node.literal.get_ref<nlohmann::json::array_t&>().reserve(node.children.size());
+                for (auto& child : node.children) {
+                    node.literal.push_back(std::move(child.literal));
+                }
+            } else {
+                node.literal = value;
+            }
+            node.kind = NodeKind::Literal;
+            node.keys.clear();
+            node.quoted_keys.clear();
+            node.children.clear();
+        }
+
+        return node;
+    }
+
+    CompiledNode CompiledTemplate::Impl::compile_string(const std::string& str, size_t depth) const {
+        CompiledNode node;
+        node.depth = depth;
+        node.exceeds_depth = depth >= options_.max_recursion_depth;
+        node.literal = str;
+
+        // Check for exact-match placeholder first
+        auto exact_path = parser_.extract_exact_placeholder(str);
+        if (exact_path) {
+            node.kind = NodeKind::ExactPlaceholder;
+            node.pointer = intern_pointer(*exact_path);
+            return node;
+        }
+
+        if (!options_.enable_interpolation) {
+            return node;
+        }
+
+        auto placeholders = parser_.find_placeholders(str);
+        if (placeholders.empty()) {
+            return node;
+        }
+
+        // Split the string into literal text and placeholder segments
+        node.kind = NodeKind::Interpolated;
+        size_t last_pos = 0;
+        for (const auto& placeholder : placeholders) {
+            if (placeholder.start_pos > last_pos) {
+                node.segments.push_back({str.substr(last_pos, placeholder.start_pos - last_pos), nullptr});
+            }
+
+            Segment segment;
+            segment.text = str.substr(placeholder.start_pos, placeholder.end_pos - placeholder.start_pos);
+            segment.pointer = intern_pointer(placeholder.path);
+            node.segments.push_back(std::move(segment));
+
+            last_pos = placeholder.end_pos;
+        }
+        if (last_pos < str.length()) {
+            node.segments.push_back({str.substr(last_pos), nullptr});
+        }
+
+        return node;
+    }
+
+    bool CompiledTemplate::Impl::apply_node(const CompiledNode& node,
+                                            const nlohmann::json& context,
+                                            nlohmann::json& out,
+                                            ProcessingContext& ctx) const {
+        if (node.kind == NodeKind::ExactPlaceholder) {
+            const nlohmann::json* value = resolve_exact(node, context, ctx);
+            if (!value) {
+                return false;
+            }
+            out = *value;
+            return true;
+        }
+
+        check_depth(node);
+
+        switch (node.kind) {
+            case NodeKind::Interpolated:
+                out = std::string();
+                append_interpolated(node, context, ctx, out.get_ref<std::string&>());
+                break;
+            case NodeKind::Object:
+                out = nlohmann::json::object();
+                for (size_t i = 0; i < node.children.size(); ++i) {
+                    nlohmann::json value;
+                    if (apply_node(node.children[i], context, value, ctx)) {
+                        out[node.keys[i]] = std::move(value);
+                    }
+                }
+                break;
+            case NodeKind::Array:
+                out = nlohmann::json::array();
+                for (const auto& child : node.children) {
+                    nlohmann::json value;
+                    if (apply_node(child, context, value, ctx)) {
+                        out.push_back(std::move(value));
+                    }
+                }
+                break;
+            default:
+                out = node.literal;
+                break;
+        }
+
+        return true;
+    }
+
+    const nlohmann::json* CompiledTemplate::Impl::resolve_exact(const CompiledNode& node,
+                                                                const nlohmann::json& context,
+                                                                ProcessingContext& ctx) const {
+        // Remove mode decides on removal before the depth check, like TemplateProcessor
+        const bool remove_missing = options_.missing_key_behavior == MissingKeyBehavior::Remove;
+        if (!remove_missing) {
+            check_depth(node);
+        }
+
+        const nlohmann::json* resolved = lookup(*node.pointer, context, ctx);
+        if (resolved) {
+            check_depth(node);
+            return resolved;
+        }
+
+        if (remove_missing) {
+            return nullptr;
+        }
+        if (options_.missing_key_behavior == MissingKeyBehavior::Error) {
+            throw MissingKeyException("Missing key in context", node.pointer->path());
+        }
+
+        // Leave the placeholder as-is
+        return &node.literal;
+    }
+
+    void CompiledTemplate::Impl::append_interpolated(const CompiledNode& node,
+                                                     const nlohmann::json& context,
+                                                     ProcessingContext& ctx,
+                                                     std::string& result) const {
+        // The template string is usually a good estimate of the result size
+        result.reserve(result.size() + node.literal.get_ref<const std::string&>().size());
+
+        for (const auto& segment : node.segments) {
+            if (!segment.pointer) {
+                result += segment.text;
+                continue;
+            }
+
+            const nlohmann::json* resolved = lookup(*segment.pointer, context, ctx);
+            if (resolved) {
+                append_json_string(result, *resolved, &ctx.dump_cache);
+            } else if (options_.missing_key_behavior == MissingKeyBehavior::Error) {
+                throw MissingKeyException("Missing key in context", segment.pointer->path());
+            } else {
+                // Keep the original placeholder
+                result += segment.text;
+            }
+        }
+    }
+
+    void CompiledTemplate::Impl::render_node(const CompiledNode& node,
+                                             const nlohmann::json& context,
+                                             JsonWriter& writer,
+                                             ProcessingContext& ctx) const {
+        if (node.kind == NodeKind::ExactPlaceholder) {
+            // Only reached for the root, which Remove mode cannot drop
+            writer.value(*resolve_exact(node, context, ctx));
+            return;
+        }
+
+        check_depth(node);
+
+        switch (node.kind) {
+            case NodeKind::Interpolated:
+                append_interpolated(node, context, ctx, writer.string_buffer());
+                writer.string_value();
+                break;
+            case NodeKind::Object:
+            case NodeKind::Array: {
+                const bool is_object = node.kind == NodeKind::Object;
+                const char open_bracket = is_object ? '{' : '[';
+                bool empty = true;
+                for (size_t i = 0; i < node.children.size(); ++i) {
+                    const CompiledNode& child = node.children[i];
+
+                    // Removal has to be known before the separator is written
+                    const nlohmann::json* exact = nullptr;
+                    if (child.kind == NodeKind::ExactPlaceholder) {
+                        exact = resolve_exact(child, context, ctx);
+                        if (!exact) {
+                            continue;
+                        }
+                    }
+
+                    writer.element(open_bracket, empty);
+                    empty = false;
+                    if (is_object) {
+                        writer.key(node.quoted_keys[i], node.keys[i]);
+                    }
+                    if (exact) {
+                        writer.value(*exact);
+                    } else {
+                        render_node(child, context, writer, ctx);
+                    }
+                }
+                writer.end_container(open_bracket, is_object ? '}' : ']', empty);
+                break;
+            }
+            default:
+                writer.value(node.literal);
+                break;
+        }
+    }
+
+    const nlohmann::json* CompiledTemplate::Impl::lookup(const JsonPointer& pointer,
+                                                         const nlohmann::json& context,
+                                                         ProcessingContext& ctx) const {
+        if (options_.recursive_expansion) {
+            return processor_.resolve(pointer, context, ctx);
+        }
+        return pointer.find(context);
+    }
+
+    void CompiledTemplate::Impl::check_depth(const CompiledNode& node) const {
+        if (node.exceeds_depth) {
+            throw RecursionLimitException("Maximum recursion depth exceeded", node.depth);
+        }
+    }
+
+    // Public wrapper
+
+    CompiledTemplate::CompiledTemplate(const nlohmann::json& template_json, const Options& options)
+        : impl_(std::make_shared<const Impl>(template_json, options)) {}
+
+    nlohmann::json CompiledTemplate::apply(const nlohmann::json& context) const {
+        return impl_->apply(context);
+    }
+
+    void CompiledTemplate::render(const nlohmann::json& context, Sink& sink, int indent) const {
+        impl_->render(context, sink, indent);
+    }
+
+    const Options& CompiledTemplate::options() const {
+        return impl_->options();
+    }
+}
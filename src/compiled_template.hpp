@@ -0,0 +1,87 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+#include <optional>
+#include "../include/permuto/permuto.hpp"
+#include "json_pointer.hpp"
+#include "placeholder_parser.hpp"
+#include "json_writer.hpp"
+#include "template_processor.hpp"
+#include "value_formatter.hpp"
+
+namespace permuto {
+    enum class NodeKind {
+        Literal,           // Subtree without placeholders, copied as-is
+        ExactPlaceholder,  // String that is exactly one placeholder
+        Interpolated,      // String with embedded placeholders
+        Object,
+        Array
+    };
+
+    // Piece of an interpolated string: either literal text or a placeholder
+    struct Segment {
+        std::string text;                      // Literal text, or the original placeholder text
+        PointerRef pointer;                    // Interned target of placeholder segments
+    };
+
+    // Node of a compiled template tree
+    struct CompiledNode {
+        NodeKind kind = NodeKind::Literal;
+        size_t depth = 0;                   // Nesting depth of this node in the template
+        bool exceeds_depth = false;         // Processing this node exceeds max_recursion_depth
+        nlohmann::json literal;             // Literal subtree, or original placeholder string
+        PointerRef pointer;                 // Interned target of an exact placeholder
+        std::vector<Segment> segments;      // Pieces of an interpolated string
+        std::vector<std::string> keys;      // Object member keys, parallel to children
+        std::vector<std::string> quoted_keys; // Keys as serialized, for render()
+        std::vector<CompiledNode> children; // Object members or array elements
+    };
+
+    // Immutable compiled form of a template
+    //
+    // THREAD SAFETY:
+    // - Contains no mutable state after construction
+    // - apply() can be called concurrently from multiple threads
+    class CompiledTemplate::Impl {
+    public:
+        Impl(const nlohmann::json& template_json, const Options& options);
+
+        nlohmann::json apply(const nlohmann::json& context) const;
+        void render(const nlohmann::json& context, Sink& sink, int indent) const;
+
+        const Options& options() const { return options_; }
+
+    private:
+        const Options options_;
+        const PlaceholderParser parser_;
+        const TemplateProcessor processor_;  // Expands resolved values in recursive_expansion mode
+        CompiledNode root_;
+
+        // Compilation
+        CompiledNode compile_value(const nlohmann::json& value, size_t depth) const;
+        CompiledNode compile_string(const std::string& str, size_t depth) const;
+
+        // Application; returns false when Remove mode drops the node
+        // Objects and arrays interpolated more than once are serialized once per apply
+        bool apply_node(const CompiledNode& node, const nlohmann::json& context,
+                        nlohmann::json& out, ProcessingContext& ctx) const;
+        void append_interpolated(const CompiledNode& node, const nlohmann::json& context,
+                                 ProcessingContext& ctx, std::string& out) const;
+        
+        // Value an exact placeholder is replaced with: the resolved value, or
+        // the placeholder string itself; nullptr when Remove mode drops it
+        const nlohmann::json* resolve_exact(const CompiledNode& node, const nlohmann::json& context,
+                                            ProcessingContext& ctx) const;
+        
+        // Rendering; writes what apply_node would produce
+        void render_node(const CompiledNode& node, const nlohmann::json& context,
+                         JsonWriter& writer, ProcessingContext& ctx) const;
+        
+        // Look up a placeholder target, expanding it if recursive_expansion is set
+        const nlohmann::json* lookup(const JsonPointer& pointer, const nlohmann::json& context,
+                                     ProcessingContext& ctx) const;
+
+        void check_depth(const CompiledNode& node) const;
+    };
+}
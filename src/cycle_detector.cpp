@@ -1,30 +1,83 @@
 #include "cycle_detector.hpp"
 
 namespace permuto {
+    namespace {
+        const size_t FILTER_BITS = 64;
+    }
+    
     CycleDetector::CycleDetector() = default;
     
-    bool CycleDetector::would_create_cycle(const std::string& path) const {
-        return path_set_.find(path) != path_set_.end();
+    bool CycleDetector::would_create_cycle(std::string_view path) const {
+        if ((filter_ & filter_bit(path)) == 0) {
+            return false;
+        }
+        
+        for (size_t i = 0; i < size_; ++i) {
+            std::string_view entry = at(i);
+            // Interned paths share storage, so identity usually decides
+            if ((entry.data() == path.data() && entry.size() == path.size()) || entry == path) {
+                return true;
+            }
+        }
+        return false;
     }
     
-    void CycleDetector::push_path(const std::string& path) {
-        path_stack_.push_back(path);
-        path_set_.insert(path);
+    void CycleDetector::push_path(std::string_view path) {
+        if (size_ < INLINE_CAPACITY) {
+            inline_paths_[size_] = path;
+        } else {
+            overflow_paths_.push_back(path);
+        }
+        ++size_;
+        filter_ |= filter_bit(path);
     }
     
     void CycleDetector::pop_path() {
-        if (!path_stack_.empty()) {
-            path_set_.erase(path_stack_.back());
-            path_stack_.pop_back();
+        if (size_ == 0) {
+            return;
+        }
+        
+        --size_;
+        if (size_ >= INLINE_CAPACITY) {
+            overflow_paths_.pop_back();
         }
+        rebuild_filter();
     }
     
     std::vector<std::string> CycleDetector::get_current_path() const {
-        return path_stack_;
+        std::vector<std::string> path;
+        path.reserve(size_);
+        for (size_t i = 0; i < size_; ++i) {
+            path.emplace_back(at(i));
+        }
+        return path;
     }
     
     void CycleDetector::clear() {
-        path_stack_.clear();
-        path_set_.clear();
+        size_ = 0;
+        overflow_paths_.clear();
+        filter_ = 0;
+    }
+    
+    uint64_t CycleDetector::filter_bit(std::string_view path) {
+        // Cheap content hash: paths differ most in length and final characters
+        size_t hash = path.size();
+        if (!path.empty()) {
+            hash = hash * 31 + static_cast<unsigned char>(path.back());
+            hash = hash * 31 + static_cast<unsigned char>(path[path.size() / 2]);
+        }
+        return uint64_t{1} << (hash % FILTER_BITS);
+    }
+    
+    std::string_view CycleDetector::at(size_t index) const {
+        return index < INLINE_CAPACITY ? inline_paths_[index] : overflow_paths_[index - INLINE_CAPACITY];
+    }
+    
+    void CycleDetector::rebuild_filter() {
+        // The stack is shallow in practice, so recomputing beats counting bits
+        filter_ = 0;
+        for (size_t i = 0; i < size_; ++i) {
+            filter_ |= filter_bit(at(i));
+        }
     }
-}
\ No newline at end of file
+}
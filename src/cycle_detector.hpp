@@ -1,18 +1,27 @@
 #pragma once
+#include <array>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_set>
 
 namespace permuto {
+    // Tracks the chain of paths being resolved to detect cycles
+    // 
+    // Paths are held as views, so checking, pushing and popping never copy or
+    // allocate for chains up to INLINE_CAPACITY entries. The caller must keep
+    // each pushed path alive until it is popped; TemplateProcessor pushes the
+    // paths of JSON Pointers its callers hold for the lookup. Strings are only
+    // materialized by get_current_path(), when a cycle is reported.
     class CycleDetector {
     public:
         CycleDetector();
         
         // Check if adding this path would create a cycle
-        bool would_create_cycle(const std::string& path) const;
+        bool would_create_cycle(std::string_view path) const;
         
         // Add a path to the current stack (when entering)
-        void push_path(const std::string& path);
+        void push_path(std::string_view path);
         
         // Remove a path from the current stack (when exiting)
         void pop_path();
@@ -23,8 +32,22 @@ namespace permuto {
         // Clear all tracking (for reuse)
         void clear();
         
+        // Number of paths on the stack
+        size_t depth() const { return size_; }
+        
     private:
-        std::vector<std::string> path_stack_;
-        std::unordered_set<std::string> path_set_;
+        static constexpr size_t INLINE_CAPACITY = 16;
+        
+        std::array<std::string_view, INLINE_CAPACITY> inline_paths_;
+        std::vector<std::string_view> overflow_paths_;  // Entries past INLINE_CAPACITY
+        size_t size_ = 0;
+        
+        // One bit per filter_bit() of each path on the stack; a clear bit
+        // rules a path out without comparing strings
+        uint64_t filter_ = 0;
+        
+        static uint64_t filter_bit(std::string_view path);
+        std::string_view at(size_t index) const;
+        void rebuild_filter();
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,133 @@
+#include "formats.hpp"
+#include "json_writer.hpp"
+#include <array>
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+
+namespace permuto {
+    namespace {
+        // Stream buffer that passes what is written to a Sink in chunks
+        class SinkStreamBuf : public std::streambuf {
+        public:
+            explicit SinkStreamBuf(Sink& sink) : sink_(sink) {
+                setp(buffer_.data(), buffer_.data() + buffer_.size());
+            }
+            
+            // Pass everything buffered on to the sink
+            void flush() {
+                if (pptr() > pbase()) {
+                    sink_.write(pbase(), static_cast<size_t>(pptr() - pbase()));
+                    setp(buffer_.data(), buffer_.data() + buffer_.size());
+                }
+            }
+        
+        protected:
+            int_type overflow(int_type c) override {
+                flush();
+                if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                    *pptr() = traits_type::to_char_type(c);
+                    pbump(1);
+                }
+                return traits_type::not_eof(c);
+            }
+            
+            std::streamsize xsputn(const char* data, std::streamsize length) override {
+                if (length > epptr() - pptr()) {
+                    // Large pieces go to the sink without being copied
+                    flush();
+                    sink_.write(data, static_cast<size_t>(length));
+                    return length;
+                }
+                std::memcpy(pptr(), data, static_cast<size_t>(length));
+                pbump(static_cast<int>(length));
+                return length;
+            }
+            
+            int sync() override {
+                flush();
+                return 0;
+            }
+        
+        private:
+            Sink& sink_;
+            std::array<char, 16384> buffer_;
+        };
+    }
+    
+    nlohmann::json::input_format_t to_input_format(Format format) {
+        switch (format) {
+            case Format::Json:
+                return nlohmann::json::input_format_t::json;
+            case Format::Cbor:
+                return nlohmann::json::input_format_t::cbor;
+            case Format::MessagePack:
+                return nlohmann::json::input_format_t::msgpack;
+            case Format::Bson:
+#if PERMUTO_NLOHMANN_AT_LEAST(3, 4)
+                return nlohmann::json::input_format_t::bson;
+#else
+                throw std::invalid_argument("BSON requires nlohmann/json 3.4 or later");
+#endif
+            case Format::Ubjson:
+                return nlohmann::json::input_format_t::ubjson;
+        }
+        throw std::invalid_argument("Unknown format");
+    }
+    
+    nlohmann::json decode(std::string_view data, Format format) {
+        switch (format) {
+            case Format::Json:
+                return nlohmann::json::parse(data.begin(), data.end());
+            case Format::Cbor:
+                return nlohmann::json::from_cbor(data.begin(), data.end());
+            case Format::MessagePack:
+                return nlohmann::json::from_msgpack(data.begin(), data.end());
+            case Format::Bson:
+#if PERMUTO_NLOHMANN_AT_LEAST(3, 4)
+                return nlohmann::json::from_bson(data.begin(), data.end());
+#else
+                throw std::invalid_argument("BSON requires nlohmann/json 3.4 or later");
+#endif
+            case Format::Ubjson:
+                return nlohmann::json::from_ubjson(data.begin(), data.end());
+        }
+        throw std::invalid_argument("Unknown format");
+    }
+    
+    void encode(const nlohmann::json& value, Format format, Sink& sink, int indent) {
+        if (format == Format::Json) {
+            JsonWriter writer(sink, indent);
+            writer.value(value);
+            writer.flush();
+            return;
+        }
+        
+        // Written through the public encoders, in chunks straight to the sink
+        SinkStreamBuf buffer(sink);
+        std::ostream stream(&buffer);
+        // Errors of the sink surface as themselves instead of a failed stream
+        stream.exceptions(std::ios::badbit);
+        switch (format) {
+            case Format::Cbor:
+                nlohmann::json::to_cbor(value, stream);
+                break;
+            case Format::MessagePack:
+                nlohmann::json::to_msgpack(value, stream);
+                break;
+            case Format::Bson:
+#if PERMUTO_NLOHMANN_AT_LEAST(3, 4)
+                nlohmann::json::to_bson(value, stream);
+                break;
+#else
+                throw std::invalid_argument("BSON requires nlohmann/json 3.4 or later");
+#endif
+            case Format::Ubjson:
+                nlohmann::json::to_ubjson(value, stream);
+                break;
+            case Format::Json:
+                break;
+        }
+        buffer.flush();
+    }
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include "../include/permuto/permuto.hpp"
+
+// True if the nlohmann/json headers are at least version major.minor; the
+// library builds against 3.2 and later, and BSON (3.4) and binary values
+// (3.8) depend on the version found
+#define PERMUTO_NLOHMANN_AT_LEAST(major, minor)                                   \
+    (NLOHMANN_JSON_VERSION_MAJOR > (major) ||                                     \
+     (NLOHMANN_JSON_VERSION_MAJOR == (major) && NLOHMANN_JSON_VERSION_MINOR >= (minor)))
+
+namespace permuto {
+    // nlohmann's parser setting for a Format
+    nlohmann::json::input_format_t to_input_format(Format format);
+}
@@ -1,45 +1,63 @@
 #include "json_pointer.hpp"
 #include <stdexcept>
-#include <sstream>
+#include <cctype>
+#include <mutex>
 
 namespace permuto {
+    namespace {
+        const char PATH_SEPARATOR = '/';
+        const size_t DECIMAL_BASE = 10;
+    }
+    
     JsonPointer::JsonPointer(const std::string& path) : path_(path) {
         parse_path(path);
     }
     
     std::optional<nlohmann::json> JsonPointer::resolve(const nlohmann::json& context) const {
-        if (is_root()) {
-            return context;
+        const nlohmann::json* value = find(context);
+        if (!value) {
+            return std::nullopt;
         }
-        
+        return *value;
+    }
+    
+    template <typename Visitor>
+    const nlohmann::json* JsonPointer::walk(const nlohmann::json& context, Visitor&& visit) const {
         const nlohmann::json* current = &context;
         
-        for (const auto& token : tokens_) {
+        for (size_t i = 0; i < tokens_.size(); ++i) {
+            visit(current);
             if (current->is_object()) {
-                auto it = current->find(token);
+                auto it = current->find(tokens_[i]);
                 if (it == current->end()) {
-                    return std::nullopt;
+                    return nullptr;
                 }
                 current = &(*it);
             } else if (current->is_array()) {
-                // Try to parse as array index
-                try {
-                    size_t index = std::stoull(token);
-                    if (index >= current->size()) {
-                        return std::nullopt;
-                    }
-                    current = &(*current)[index];
-                } catch (const std::exception&) {
-                    // Not a valid array index
-                    return std::nullopt;
+                // Index was parsed when the pointer was built
+                size_t index = indices_[i];
+                if (index == NO_INDEX || index >= current->size()) {
+                    return nullptr;
                 }
+                current = &(*current)[index];
             } else {
                 // Can't traverse further
-                return std::nullopt;
+                return nullptr;
             }
         }
         
-        return *current;
+        return current;
+    }
+    
+    const nlohmann::json* JsonPointer::find(const nlohmann::json& context) const {
+        return walk(context, [](const nlohmann::json*) {});
+    }
+    
+    const nlohmann::json* JsonPointer::find(const nlohmann::json& context,
+                                            std::vector<const nlohmann::json*>& ancestors) const {
+        return walk(context, [&ancestors](const nlohmann::json* value) {
+            ancestors.push_back(value);
+        });
     }
     
     void JsonPointer::parse_path(const std::string& path) {
@@ -48,15 +66,21 @@ namespace permuto {
             return;
         }
         
-        if (path[0] != '/') {
+        if (path[0] != PATH_SEPARATOR) {
             throw std::invalid_argument("JSON Pointer must start with '/' or be empty");
         }
         
-        std::stringstream ss(path.substr(1)); // Skip leading '/'
-        std::string token;
-        
-        while (std::getline(ss, token, '/')) {
-            tokens_.push_back(unescape_token(token));
+        // Split on '/' after the leading separator; a trailing empty token is
+        // dropped, so "/" is the root and "/a/" is the same as "/a"
+        size_t token_start = 1;
+        while (token_start < path.length()) {
+            size_t token_end = path.find(PATH_SEPARATOR, token_start);
+            if (token_end == std::string::npos) {
+                token_end = path.length();
+            }
+            tokens_.push_back(unescape_token(path.substr(token_start, token_end - token_start)));
+            indices_.push_back(parse_index(tokens_.back()));
+            token_start = token_end + 1;
         }
     }
     
@@ -82,4 +106,81 @@ namespace permuto {
         
         return result;
     }
-}
\ No newline at end of file
+    
+    size_t JsonPointer::parse_index(const std::string& token) {
+        // Accepts the same inputs as std::stoull without throwing: optional
+        // leading whitespace and sign, then at least one digit; trailing
+        // characters are ignored and a minus sign wraps like strtoull
+        size_t pos = 0;
+        while (pos < token.size() && std::isspace(static_cast<unsigned char>(token[pos]))) {
+            ++pos;
+        }
+        
+        bool negative = false;
+        if (pos < token.size() && (token[pos] == '+' || token[pos] == '-')) {
+            negative = token[pos] == '-';
+            ++pos;
+        }
+        
+        if (pos >= token.size() || !std::isdigit(static_cast<unsigned char>(token[pos]))) {
+            return NO_INDEX;
+        }
+        
+        unsigned long long value = 0;
+        const unsigned long long max_value = std::numeric_limits<unsigned long long>::max();
+        for (; pos < token.size() && std::isdigit(static_cast<unsigned char>(token[pos])); ++pos) {
+            unsigned long long digit = static_cast<unsigned long long>(token[pos] - '0');
+            if (value > (max_value - digit) / DECIMAL_BASE) {
+                // Out of range
+                return NO_INDEX;
+            }
+            value = value * DECIMAL_BASE + digit;
+        }
+        
+        if (negative) {
+            value = 0ULL - value;
+        }
+        
+        return value > std::numeric_limits<size_t>::max() ? NO_INDEX : static_cast<size_t>(value);
+    }
+    
+    PointerTable& PointerTable::instance() {
+        static PointerTable table;
+        return table;
+    }
+    
+    PointerRef PointerTable::intern(std::string_view path) {
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = pointers_.find(path);
+            if (it != pointers_.end()) {
+                return it->second;
+            }
+        }
+        
+        // Parse outside the lock; invalid paths throw before anything is stored
+        auto pointer = std::make_shared<const JsonPointer>(std::string(path));
+        std::string_view key = pointer->path();
+        
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = pointers_.find(key);
+        if (it != pointers_.end()) {
+            return it->second;
+        }
+        if (pointers_.size() >= CAPACITY) {
+            // Holders of the dropped pointers keep them alive
+            pointers_.clear();
+        }
+        pointers_.emplace(key, pointer);
+        return pointer;
+    }
+    
+    size_t PointerTable::size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return pointers_.size();
+    }
+    
+    PointerRef intern_pointer(std::string_view path) {
+        return PointerTable::instance().intern(path);
+    }
+}
@@ -3,18 +3,38 @@
 #include <string>
 #include <vector>
 #include <optional>
+#include <memory>
+#include <limits>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
 
 namespace permuto {
     class JsonPointer {
     public:
+        // Marks a token that cannot be used as an array index
+        static constexpr size_t NO_INDEX = std::numeric_limits<size_t>::max();
+        
         explicit JsonPointer(const std::string& path);
         
         // Resolve path in context, returns nullopt if path doesn't exist
         std::optional<nlohmann::json> resolve(const nlohmann::json& context) const;
         
+        // Borrowing lookup: returns the matched value inside context without
+        // copying it, or nullptr if the path doesn't exist
+        const nlohmann::json* find(const nlohmann::json& context) const;
+        
+        // Like find(), also appending every value passed through on the way to
+        // the match (excluding the match itself) to ancestors
+        const nlohmann::json* find(const nlohmann::json& context,
+                                   std::vector<const nlohmann::json*>& ancestors) const;
+        
         // Get the path tokens
         const std::vector<std::string>& tokens() const { return tokens_; }
         
+        // Get the array index of each token, parsed once at construction
+        const std::vector<size_t>& indices() const { return indices_; }
+        
         // Get the raw path string
         const std::string& path() const { return path_; }
         
@@ -24,8 +44,55 @@ namespace permuto {
     private:
         std::string path_;
         std::vector<std::string> tokens_;
+        std::vector<size_t> indices_;
+        
+        template <typename Visitor>
+        const nlohmann::json* walk(const nlohmann::json& context, Visitor&& visit) const;
         
         void parse_path(const std::string& path);
         std::string unescape_token(const std::string& token) const;
+        static size_t parse_index(const std::string& token);
+    };
+    
+    // Shared handle to an immutable parsed JSON Pointer
+    using PointerRef = std::shared_ptr<const JsonPointer>;
+    
+    // Process-wide table of interned JSON Pointers
+    // 
+    // Each distinct path string is parsed once while it stays in the table.
+    // The table holds at most CAPACITY paths and is emptied when a new path
+    // would exceed that, so paths taken from contexts, reverse templates or
+    // loaded files cannot grow it without bound in a long-running process.
+    // A pointer stays valid for as long as a PointerRef to it is held, whether
+    // or not the table still holds it: compiled templates keep theirs, one-shot
+    // lookups keep theirs until they return. Interning the same path twice
+    // only yields the same pointer while it stays in the table, so compare
+    // paths rather than addresses.
+    // 
+    // THREAD SAFETY:
+    // - Lookups of already interned paths take a shared lock
+    // - Interning a new path takes an exclusive lock
+    class PointerTable {
+    public:
+        static constexpr size_t CAPACITY = 4096;
+        
+        static PointerTable& instance();
+        
+        // Get the interned pointer for a path, parsing it if it is not in the table
+        // Throws std::invalid_argument if the path is not a valid JSON Pointer
+        PointerRef intern(std::string_view path);
+        
+        // Number of interned paths
+        size_t size() const;
+        
+    private:
+        PointerTable() = default;
+        
+        mutable std::shared_mutex mutex_;
+        // Keys view the path owned by the mapped pointer, so lookups need no copy
+        std::unordered_map<std::string_view, PointerRef> pointers_;
     };
-}
\ No newline at end of file
+    
+    // Shorthand for PointerTable::instance().intern(path)
+    PointerRef intern_pointer(std::string_view path);
+}
@@ -0,0 +1,200 @@
+#include "json_writer.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+
+namespace permuto {
+    namespace {
+        // Enough for any 64-bit integer, with its sign
+        const size_t INTEGER_DIGITS = 21;
+        
+        const unsigned char FIRST_PRINTABLE = 0x20;
+        const unsigned char FIRST_NON_ASCII = 0x80;
+    }
+    
+    void SinkBuffer::write_characters(const char* data, size_t length) {
+        if (length > buffer_.size() - used_) {
+            flush();
+            if (length >= buffer_.size()) {
+                // Large pieces go straight through
+                sink_.write(data, length);
+                return;
+            }
+        }
+        std::memcpy(buffer_.data() + used_, data, length);
+        used_ += length;
+    }
+    
+    void SinkBuffer::flush() {
+        if (used_ > 0) {
+            sink_.write(buffer_.data(), used_);
+            used_ = 0;
+        }
+    }
+    
+    JsonWriter::JsonWriter(Sink& sink, int indent)
+        : buffer_(sink),
+          pretty_(indent >= 0),
+          indent_step_(indent >= 0 ? indent : 0) {}
+    
+    void JsonWriter::element(char open_bracket, bool first) {
+        if (first) {
+            buffer_.write_character(open_bracket);
+            ++level_;
+        } else {
+            buffer_.write_character(',');
+        }
+        new_line();
+    }
+    
+    void JsonWriter::key(std::string_view quoted_key, std::string_view key) {
+        if (quoted_key.empty()) {
+            // Not valid UTF-8; raises the same error dump() does
+            write_string(std::string(key));
+        }
+        buffer_.write_characters(quoted_key.data(), quoted_key.size());
+        key_separator();
+    }
+    
+    void JsonWriter::key(const std::string& key) {
+        write_string(key);
+        key_separator();
+    }
+    
+    void JsonWriter::end_container(char open_bracket, char close_bracket, bool empty) {
+        if (empty) {
+            buffer_.write_character(open_bracket);
+        } else {
+            --level_;
+            new_line();
+        }
+        buffer_.write_character(close_bracket);
+    }
+    
+    void JsonWriter::value(const nlohmann::json& value) {
+        switch (value.type()) {
+            case nlohmann::json::value_t::null:
+                buffer_.write_characters("null", 4);
+                break;
+            case nlohmann::json::value_t::boolean:
+                if (value.get<bool>()) {
+                    buffer_.write_characters("true", 4);
+                } else {
+                    buffer_.write_characters("false", 5);
+                }
+                break;
+            case nlohmann::json::value_t::number_integer:
+            case nlohmann::json::value_t::number_unsigned: {
+                char digits[INTEGER_DIGITS];
+                auto end = value.is_number_unsigned()
+                    ? std::to_chars(digits, digits + sizeof(digits), value.get<std::uint64_t>()).ptr
+                    : std::to_chars(digits, digits + sizeof(digits), value.get<std::int64_t>()).ptr;
+                buffer_.write_characters(digits, static_cast<size_t>(end - digits));
+                break;
+            }
+            case nlohmann::json::value_t::string:
+                write_string(value.get_ref<const std::string&>());
+                break;
+            default:
+                // Floating-point numbers keep dump()'s own formatting
+                write_dumped(value);
+                break;
+        }
+    }
+    
+    std::string& JsonWriter::string_buffer() {
+        scratch_.clear();
+        return scratch_;
+    }
+    
+    void JsonWriter::string_value() {
+        write_string(scratch_);
+    }
+    
+    void JsonWriter::write_string(const std::string& text) {
+        // dump() escapes only quotes, backslashes and control characters, and
+        // checks bytes from 0x80 up for UTF-8; text with none of them is
+        // written as is
+        bool plain = std::all_of(text.begin(), text.end(), [](char c) {
+            auto byte = static_cast<unsigned char>(c);
+            return byte >= FIRST_PRINTABLE && byte < FIRST_NON_ASCII && c != '"' && c != '\\';
+        });
+        if (!plain) {
+            std::string quoted = nlohmann::json(text).dump();
+            buffer_.write_characters(quoted.data(), quoted.size());
+            return;
+        }
+        buffer_.write_character('"');
+        buffer_.write_characters(text.data(), text.size());
+        buffer_.write_character('"');
+    }
+    
+    void JsonWriter::write_dumped(const nlohmann::json& value) {
+        std::string text = value.dump(pretty_ ? indent_step_ : -1);
+        // Strings in dump() output have their newlines escaped, so every
+        // newline starts a line of the layout
+        size_t width = level_ * static_cast<size_t>(indent_step_);
+        size_t line_start = 0;
+        size_t newline;
+        while (width > 0 && (newline = text.find('\n', line_start)) != std::string::npos) {
+            buffer_.write_characters(text.data() + line_start, newline + 1 - line_start);
+            write_indentation(width);
+            line_start = newline + 1;
+        }
+        buffer_.write_characters(text.data() + line_start, text.size() - line_start);
+    }
+    
+    void JsonWriter::key_separator() {
+        if (pretty_) {
+            buffer_.write_characters(": ", 2);
+        } else {
+            buffer_.write_character(':');
+        }
+    }
+    
+    void JsonWriter::new_line() {
+        if (!pretty_) {
+            return;
+        }
+        buffer_.write_character('\n');
+        write_indentation(level_ * static_cast<size_t>(indent_step_));
+    }
+    
+    void JsonWriter::write_indentation(size_t width) {
+        if (indentation_.size() < width) {
+            indentation_.resize(width, ' ');
+        }
+        buffer_.write_characters(indentation_.data(), width);
+    }
+    
+    std::string quote_key(const std::string& key) {
+        try {
+            return nlohmann::json(key).dump();
+        } catch (const nlohmann::json::type_error&) {
+            return std::string();
+        }
+    }
+    
+    // Public sinks
+    
+    StreamSink::StreamSink(std::ostream& stream) : stream_(stream) {}
+    
+    void StreamSink::write(const char* data, size_t length) {
+        stream_.write(data, static_cast<std::streamsize>(length));
+    }
+    
+    StringSink::StringSink(std::string& output) : output_(output) {}
+    
+    void StringSink::write(const char* data, size_t length) {
+        output_.append(data, length);
+    }
+    
+    CallbackSink::CallbackSink(std::function<void(std::string_view)> callback)
+        : callback_(std::move(callback)) {}
+    
+    void CallbackSink::write(const char* data, size_t length) {
+        callback_(std::string_view(data, length));
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include <array>
+#include <string>
+#include <string_view>
+#include "../include/permuto/permuto.hpp"
+
+namespace permuto {
+    // Collects small writes and hands them to a Sink in larger chunks
+    class SinkBuffer {
+    public:
+        explicit SinkBuffer(Sink& sink) : sink_(sink) {}
+        
+        void write_character(char c) {
+            if (used_ == buffer_.size()) {
+                flush();
+            }
+            buffer_[used_++] = c;
+        }
+        
+        void write_characters(const char* data, size_t length);
+        
+        // Pass everything buffered on to the sink
+        void flush();
+    
+    private:
+        Sink& sink_;
+        std::array<char, 16384> buffer_;
+        size_t used_ = 0;
+    };
+    
+    // Writes JSON text in the exact layout of nlohmann::json::dump(indent),
+    // one piece at a time
+    // Containers are opened by their first element, so a container whose
+    // elements all turn out to be removed is still written as {} or [].
+    // Only the public dump() is used: strings that need no escaping and
+    // integers are written directly, everything else is dumped and its lines
+    // indented to the current level.
+    class JsonWriter {
+    public:
+        // indent < 0 writes compact text
+        JsonWriter(Sink& sink, int indent);
+        
+        // Start the next element of the container being written; the first
+        // element also writes open_bracket
+        void element(char open_bracket, bool first);
+        
+        // Object member key, already quoted and escaped by quote_key(key)
+        void key(std::string_view quoted_key, std::string_view key);
+        
+        // Object member key, escaped as it is written
+        void key(const std::string& key);
+        
+        // Close the container; empty if element() was never called for it
+        void end_container(char open_bracket, char close_bracket, bool empty);
+        
+        // Serialize a complete value at the current nesting level
+        void value(const nlohmann::json& value);
+        
+        // Scalar already serialized by dump(), written as is
+        void raw_value(std::string_view text) { buffer_.write_characters(text.data(), text.size()); }
+        
+        // Scratch string written as a JSON string by string_value()
+        // Its capacity is reused, so building into it does not allocate
+        std::string& string_buffer();
+        void string_value();
+        
+        void flush() { buffer_.flush(); }
+    
+    private:
+        void new_line();
+        void key_separator();
+        
+        // Quoted and escaped as dump() would, including its error for
+        // invalid UTF-8
+        void write_string(const std::string& text);
+        
+        // dump() of value, with every line after the first continued at the
+        // current nesting level
+        void write_dumped(const nlohmann::json& value);
+        
+        void write_indentation(size_t width);
+        
+        SinkBuffer buffer_;
+        const bool pretty_;
+        const int indent_step_;
+        std::string indentation_;
+        size_t level_ = 0;
+        std::string scratch_;
+    };
+    
+    // A key as dump() writes it, including the quotes
+    // Returns an empty string if the key is not valid UTF-8, so that the
+    // error is raised when the key is written, as dump() would.
+    std::string quote_key(const std::string& key);
+}
@@ -0,0 +1,215 @@
+#include "marker_search.hpp"
+#include <cstdint>
+#include <cstring>
+
+#if PERMUTO_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace permuto {
+    namespace {
+        using FindMarkerFn = size_t (*)(std::string_view, size_t, std::string_view);
+        
+        const size_t SSE2_BLOCK_SIZE = 16;
+        const size_t AVX2_BLOCK_SIZE = 32;
+        
+        // Candidate positions checked per loop iteration, one bit each in a 64-bit mask
+        const size_t SIMD_STRIDE = 64;
+        
+        // Markers of this length are fully checked by the first/last byte filter
+        const size_t FILTERED_MARKER_LENGTH = 2;
+        
+        bool fits(std::string_view text, size_t from, std::string_view marker) {
+            return !marker.empty() && from <= text.size() && text.size() - from >= marker.size();
+        }
+        
+        // Check the marker bytes between its first and last byte
+        bool middle_matches(const char* candidate, std::string_view marker) {
+            return marker.size() <= FILTERED_MARKER_LENGTH ||
+                   std::memcmp(candidate + 1, marker.data() + 1, marker.size() - FILTERED_MARKER_LENGTH) == 0;
+        }
+        
+        struct ActiveImpl {
+            FindMarkerFn find;
+            MarkerSearchImpl kind;
+        };
+        
+        ActiveImpl select_impl() {
+#if PERMUTO_HAS_X86_SIMD
+            if (cpu_supports_avx2()) {
+                return {find_marker_avx2, MarkerSearchImpl::AVX2};
+            }
+            return {find_marker_sse2, MarkerSearchImpl::SSE2};
+#else
+            return {find_marker_scalar, MarkerSearchImpl::Scalar};
+#endif
+        }
+        
+        const ActiveImpl& active_impl() {
+            // Selected once per process
+            static const ActiveImpl impl = select_impl();
+            return impl;
+        }
+    }
+    
+    size_t find_marker(std::string_view text, size_t from, std::string_view marker) {
+        return active_impl().find(text, from, marker);
+    }
+    
+    MarkerSearchImpl active_marker_search() {
+        return active_impl().kind;
+    }
+    
+    size_t find_marker_scalar(std::string_view text, size_t from, std::string_view marker) {
+        if (!fits(text, from, marker)) {
+            return std::string_view::npos;
+        }
+        
+        const char* const begin = text.data();
+        // Last position where a full marker still fits
+        const char* const last = begin + (text.size() - marker.size());
+        const char first = marker.front();
+        
+        const char* candidate = begin + from;
+        while (candidate <= last) {
+            const void* hit = std::memchr(candidate, first, static_cast<size_t>(last - candidate) + 1);
+            if (!hit) {
+                break;
+            }
+            
+            candidate = static_cast<const char*>(hit);
+            if (std::memcmp(candidate + 1, marker.data() + 1, marker.size() - 1) == 0) {
+                return static_cast<size_t>(candidate - begin);
+            }
+            ++candidate;
+        }
+        
+        return std::string_view::npos;
+    }
+    
+#if PERMUTO_HAS_X86_SIMD
+    // Both SIMD versions compare a stride of candidate positions against the
+    // first marker byte and, shifted by the marker length, against the last
+    // marker byte. Only positions matching both are verified with memcmp, so
+    // text without the marker is rejected a whole stride at a time.
+    
+    namespace {
+        // Verify candidates flagged in mask, one bit per position from pos
+        size_t verify_candidates(const char* data, size_t pos, uint64_t mask, std::string_view marker) {
+            while (mask != 0) {
+                size_t candidate = pos + static_cast<size_t>(__builtin_ctzll(mask));
+                if (middle_matches(data + candidate, marker)) {
+                    return candidate;
+                }
+                mask &= mask - 1;
+            }
+            return std::string_view::npos;
+        }
+        
+        inline __m128i sse2_block(const char* data, size_t pos, size_t last_offset,
+                                  __m128i first, __m128i last) {
+            const __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+            const __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + last_offset));
+            return _mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last));
+        }
+        
+        __attribute__((target("avx2")))
+        inline __m256i avx2_block(const char* data, size_t pos, size_t last_offset,
+                                  __m256i first, __m256i last) {
+            const __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+            const __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + last_offset));
+            return _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first), _mm256_cmpeq_epi8(block_last, last));
+        }
+    }
+    
+    size_t find_marker_sse2(std::string_view text, size_t from, std::string_view marker) {
+        if (!fits(text, from, marker)) {
+            return std::string_view::npos;
+        }
+        if (marker.size() == 1) {
+            // libc memchr is already vectorized for a single byte
+            return find_marker_scalar(text, from, marker);
+        }
+        
+        const char* const data = text.data();
+        const size_t last_offset = marker.size() - 1;
+        const __m128i first = _mm_set1_epi8(marker.front());
+        const __m128i last = _mm_set1_epi8(marker.back());
+        
+        size_t pos = from;
+        while (pos + SIMD_STRIDE + last_offset <= text.size()) {
+            const __m128i m0 = sse2_block(data, pos, last_offset, first, last);
+            const __m128i m1 = sse2_block(data, pos + SSE2_BLOCK_SIZE, last_offset, first, last);
+            const __m128i m2 = sse2_block(data, pos + 2 * SSE2_BLOCK_SIZE, last_offset, first, last);
+            const __m128i m3 = sse2_block(data, pos + 3 * SSE2_BLOCK_SIZE, last_offset, first, last);
+            const __m128i any = _mm_or_si128(_mm_or_si128(m0, m1), _mm_or_si128(m2, m3));
+            
+            if (_mm_movemask_epi8(any) != 0) {
+                uint64_t mask = static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(m0))) |
+                                static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(m1))) << 16 |
+                                static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(m2))) << 32 |
+                                static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(m3))) << 48;
+                size_t found = verify_candidates(data, pos, mask, marker);
+                if (found != std::string_view::npos) {
+                    return found;
+                }
+            }
+            pos += SIMD_STRIDE;
+        }
+        
+        while (pos + SSE2_BLOCK_SIZE + last_offset <= text.size()) {
+            const __m128i m0 = sse2_block(data, pos, last_offset, first, last);
+            uint64_t mask = static_cast<uint16_t>(_mm_movemask_epi8(m0));
+            size_t found = verify_candidates(data, pos, mask, marker);
+            if (found != std::string_view::npos) {
+                return found;
+            }
+            pos += SSE2_BLOCK_SIZE;
+        }
+        
+        // Fewer than one block of candidates left
+        return find_marker_scalar(text, pos, marker);
+    }
+    
+    __attribute__((target("avx2")))
+    size_t find_marker_avx2(std::string_view text, size_t from, std::string_view marker) {
+        if (!fits(text, from, marker)) {
+            return std::string_view::npos;
+        }
+        if (marker.size() == 1) {
+            // libc memchr is already vectorized for a single byte
+            return find_marker_scalar(text, from, marker);
+        }
+        
+        const char* const data = text.data();
+        const size_t last_offset = marker.size() - 1;
+        const __m256i first = _mm256_set1_epi8(marker.front());
+        const __m256i last = _mm256_set1_epi8(marker.back());
+        
+        size_t pos = from;
+        while (pos + SIMD_STRIDE + last_offset <= text.size()) {
+            const __m256i m0 = avx2_block(data, pos, last_offset, first, last);
+            const __m256i m1 = avx2_block(data, pos + AVX2_BLOCK_SIZE, last_offset, first, last);
+            const __m256i any = _mm256_or_si256(m0, m1);
+            
+            if (!_mm256_testz_si256(any, any)) {
+                uint64_t mask = static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(m0))) |
+                                static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(m1))) << 32;
+                size_t found = verify_candidates(data, pos, mask, marker);
+                if (found != std::string_view::npos) {
+                    return found;
+                }
+            }
+            pos += SIMD_STRIDE;
+        }
+        
+        // Less than one stride of candidates left
+        return find_marker_sse2(text, pos, marker);
+    }
+    
+    bool cpu_supports_avx2() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    }
+#endif
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+// Vectorized marker search is available on x86-64 Linux with GCC or Clang;
+// other platforms use the portable scalar search
+#if defined(__x86_64__) && defined(__linux__) && (defined(__GNUC__) || defined(__clang__))
+#define PERMUTO_HAS_X86_SIMD 1
+#else
+#define PERMUTO_HAS_X86_SIMD 0
+#endif
+
+namespace permuto {
+    enum class MarkerSearchImpl {
+        Scalar,  // memchr for the first byte, then verification
+        SSE2,    // 16-byte blocks, baseline on x86-64
+        AVX2     // 32-byte blocks, selected when the CPU supports it
+    };
+    
+    // Find the first occurrence of marker in text at or after from
+    // Uses the fastest implementation the CPU supports, selected once at
+    // runtime. Cost is linear in the scanned length for any marker.
+    // Returns std::string_view::npos if there is no occurrence.
+    size_t find_marker(std::string_view text, size_t from, std::string_view marker);
+    
+    // Implementation used by find_marker on this machine
+    MarkerSearchImpl active_marker_search();
+    
+    // Individual implementations, exposed for tests and benchmarks
+    size_t find_marker_scalar(std::string_view text, size_t from, std::string_view marker);
+#if PERMUTO_HAS_X86_SIMD
+    size_t find_marker_sse2(std::string_view text, size_t from, std::string_view marker);
+    size_t find_marker_avx2(std::string_view text, size_t from, std::string_view marker);
+    
+    // True if the CPU supports the AVX2 implementation
+    bool cpu_supports_avx2();
+#endif
+}
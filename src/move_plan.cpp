@@ -0,0 +1,63 @@
+#include "move_plan.hpp"
+#include <unordered_set>
+
+namespace permuto {
+    namespace {
+        // Remaining count marking a value that must always be copied
+        const size_t PINNED = 0;
+    }
+    
+    void MovePlan::expect(const JsonPointer& pointer, const nlohmann::json& source) {
+        std::vector<const nlohmann::json*> ancestors;
+        const nlohmann::json* value = pointer.find(source, ancestors);
+        if (!value) {
+            return;
+        }
+        
+        auto inserted = entries_.try_emplace(value);
+        Entry& entry = inserted.first->second;
+        if (inserted.second) {
+            entry.ancestors = std::move(ancestors);
+        }
+        ++entry.remaining;
+    }
+    
+    bool MovePlan::use(const nlohmann::json* value) {
+        if (!finalized_) {
+            finalize();
+        }
+        
+        auto it = entries_.find(value);
+        if (it == entries_.end() || it->second.remaining == PINNED) {
+            return false;
+        }
+        
+        return --it->second.remaining == 0;
+    }
+    
+    void MovePlan::finalize() {
+        finalized_ = true;
+        
+        std::unordered_set<const nlohmann::json*> all_ancestors;
+        for (const auto& item : entries_) {
+            all_ancestors.insert(item.second.ancestors.begin(), item.second.ancestors.end());
+        }
+        
+        for (auto& item : entries_) {
+            // Contains another looked-up value
+            bool overlaps = all_ancestors.count(item.first) > 0;
+            
+            // Contained in another looked-up value
+            for (const nlohmann::json* ancestor : item.second.ancestors) {
+                if (overlaps) {
+                    break;
+                }
+                overlaps = entries_.count(ancestor) > 0;
+            }
+            
+            if (overlaps) {
+                item.second.remaining = PINNED;
+            }
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include <unordered_map>
+#include <vector>
+#include "json_pointer.hpp"
+
+namespace permuto {
+    // Decides when a value borrowed from a caller-owned (rvalue) source may be
+    // moved into the output instead of copied
+    // 
+    // Every lookup a traversal will perform is recorded up front with expect(),
+    // in the same order the traversal later calls use(). A value is moved at its
+    // last use; earlier uses copy. Values that contain, or are contained in,
+    // another looked-up value are always copied, so a move never empties data
+    // that a later lookup still needs.
+    class MovePlan {
+    public:
+        // Record a future lookup of pointer in source
+        void expect(const JsonPointer& pointer, const nlohmann::json& source);
+        
+        // Record one use of a looked-up value
+        // Returns true if this use may move the value out of the source
+        bool use(const nlohmann::json* value);
+        
+    private:
+        struct Entry {
+            size_t remaining = 0;
+            std::vector<const nlohmann::json*> ancestors;
+        };
+        
+        std::unordered_map<const nlohmann::json*, Entry> entries_;
+        bool finalized_ = false;
+        
+        // Pin values that overlap another looked-up value
+        void finalize();
+    };
+}
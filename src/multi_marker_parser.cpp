@@ -0,0 +1,347 @@
+#include "multi_marker_parser.hpp"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+
+#if PERMUTO_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace permuto {
+    namespace {
+        const uint32_t ROOT_STATE = 0;
+        
+        // Distinct bytes compared per block in the vector skip loops
+        const size_t MAX_VECTOR_BYTES = 8;
+        
+#if PERMUTO_HAS_X86_SIMD
+        const size_t SSE2_BLOCK_SIZE = 16;
+        const size_t AVX2_BLOCK_SIZE = 32;
+        const size_t SIMD_STRIDE = 64;
+        
+        // Bytes of block equal to any of the needles
+        inline __m128i sse2_any_of(__m128i block, const __m128i* needles, size_t count) {
+            __m128i hits = _mm_cmpeq_epi8(block, needles[0]);
+            for (size_t i = 1; i < count; ++i) {
+                hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, needles[i]));
+            }
+            return hits;
+        }
+        
+        // Positions whose byte may begin a start marker and whose next byte may follow it
+        inline uint64_t sse2_candidates(const char* data, const __m128i* first, size_t first_count,
+                                        const __m128i* second, size_t second_count) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            __m128i hits = sse2_any_of(block, first, first_count);
+            if (second_count > 0) {
+                __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 1));
+                hits = _mm_and_si128(hits, sse2_any_of(next, second, second_count));
+            }
+            return static_cast<uint16_t>(_mm_movemask_epi8(hits));
+        }
+        
+        __attribute__((target("avx2")))
+        inline __m256i avx2_any_of(__m256i block, const __m256i* needles, size_t count) {
+            __m256i hits = _mm256_cmpeq_epi8(block, needles[0]);
+            for (size_t i = 1; i < count; ++i) {
+                hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, needles[i]));
+            }
+            return hits;
+        }
+        
+        __attribute__((target("avx2")))
+        inline uint64_t avx2_candidates(const char* data, const __m256i* first, size_t first_count,
+                                        const __m256i* second, size_t second_count) {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+            __m256i hits = avx2_any_of(block, first, first_count);
+            if (second_count > 0) {
+                __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 1));
+                hits = _mm256_and_si256(hits, avx2_any_of(next, second, second_count));
+            }
+            return static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+        }
+        
+        // Skip whole strides without a candidate; returns the first candidate
+        // or the position where fewer than a stride of bytes remain
+        size_t sse2_skip(std::string_view text, size_t pos, const std::string& first_bytes,
+                         const std::string& second_bytes) {
+            __m128i first[MAX_VECTOR_BYTES];
+            __m128i second[MAX_VECTOR_BYTES];
+            for (size_t i = 0; i < first_bytes.size(); ++i) {
+                first[i] = _mm_set1_epi8(first_bytes[i]);
+            }
+            for (size_t i = 0; i < second_bytes.size(); ++i) {
+                second[i] = _mm_set1_epi8(second_bytes[i]);
+            }
+            
+            const char* data = text.data();
+            // One extra byte for the shifted load of the second-byte filter
+            while (pos + SIMD_STRIDE + 1 <= text.size()) {
+                uint64_t mask = 0;
+                for (size_t block = 0; block < SIMD_STRIDE / SSE2_BLOCK_SIZE; ++block) {
+                    mask |= sse2_candidates(data + pos + block * SSE2_BLOCK_SIZE, first, first_bytes.size(),
+                                            second, second_bytes.size()) << (block * SSE2_BLOCK_SIZE);
+                }
+                if (mask != 0) {
+                    return pos + static_cast<size_t>(__builtin_ctzll(mask));
+                }
+                pos += SIMD_STRIDE;
+            }
+            return pos;
+        }
+        
+        __attribute__((target("avx2")))
+        size_t avx2_skip(std::string_view text, size_t pos, const std::string& first_bytes,
+                         const std::string& second_bytes) {
+            __m256i first[MAX_VECTOR_BYTES];
+            __m256i second[MAX_VECTOR_BYTES];
+            for (size_t i = 0; i < first_bytes.size(); ++i) {
+                first[i] = _mm256_set1_epi8(first_bytes[i]);
+            }
+            for (size_t i = 0; i < second_bytes.size(); ++i) {
+                second[i] = _mm256_set1_epi8(second_bytes[i]);
+            }
+            
+            const char* data = text.data();
+            while (pos + SIMD_STRIDE + 1 <= text.size()) {
+                uint64_t mask = avx2_candidates(data + pos, first, first_bytes.size(),
+                                                second, second_bytes.size()) |
+                                avx2_candidates(data + pos + AVX2_BLOCK_SIZE, first, first_bytes.size(),
+                                                second, second_bytes.size()) << AVX2_BLOCK_SIZE;
+                if (mask != 0) {
+                    return pos + static_cast<size_t>(__builtin_ctzll(mask));
+                }
+                pos += SIMD_STRIDE;
+            }
+            return pos;
+        }
+#endif
+    }
+    
+    MultiMarkerParser::MultiMarkerParser(std::vector<MarkerPair> marker_sets)
+        : marker_sets_(std::move(marker_sets)) {
+        if (marker_sets_.empty()) {
+            throw std::invalid_argument("At least one marker pair is required");
+        }
+        if (marker_sets_.size() > MAX_MARKER_SETS) {
+            throw std::invalid_argument("Too many marker pairs");
+        }
+        
+        for (size_t i = 0; i < marker_sets_.size(); ++i) {
+            const auto& pair = marker_sets_[i];
+            if (pair.start_marker.empty() || pair.end_marker.empty()) {
+                throw std::invalid_argument("Markers cannot be empty");
+            }
+            if (pair.start_marker == pair.end_marker) {
+                throw std::invalid_argument("Start and end markers must be different");
+            }
+            for (size_t j = 0; j < i; ++j) {
+                if (marker_sets_[j].start_marker == pair.start_marker) {
+                    throw std::invalid_argument("Marker pairs must have distinct start markers");
+                }
+            }
+        }
+        
+        build_automaton();
+    }
+    
+    std::vector<MarkedPlaceholder> MultiMarkerParser::find_placeholders(std::string_view text) const {
+        std::vector<MarkedPlaceholder> placeholders;
+        for_each_placeholder(text, [&](size_t set, std::string_view path, size_t start_pos, size_t end_pos) {
+            placeholders.push_back({set, std::string(path), start_pos, end_pos});
+        });
+        return placeholders;
+    }
+    
+    std::optional<std::string_view> MultiMarkerParser::extract_exact_placeholder(std::string_view text,
+                                                                                 size_t& marker_set) const {
+        std::optional<std::string_view> path;
+        size_t matched_length = 0;
+        for (size_t set = 0; set < marker_sets_.size(); ++set) {
+            const MarkerPair& pair = marker_sets_[set];
+            size_t markers_length = pair.start_marker.length() + pair.end_marker.length();
+            if (pair.start_marker.length() <= matched_length || text.length() < markers_length ||
+                text.compare(0, pair.start_marker.length(), pair.start_marker) != 0 ||
+                text.compare(text.length() - pair.end_marker.length(), pair.end_marker.length(),
+                             pair.end_marker) != 0) {
+                continue;
+            }
+            
+            std::string_view inner = text.substr(pair.start_marker.length(), text.length() - markers_length);
+            if (PlaceholderParser::is_valid_path(inner)) {
+                path = inner;
+                marker_set = set;
+                matched_length = pair.start_marker.length();
+            }
+        }
+        return path;
+    }
+    
+    void MultiMarkerParser::build_automaton() {
+        auto add_state = [this](uint32_t depth) {
+            transitions_.resize(transitions_.size() + ALPHABET_SIZE, NO_STATE);
+            state_marker_.push_back(NO_STATE);
+            output_link_.push_back(NO_STATE);
+            state_depth_.push_back(depth);
+            return static_cast<uint32_t>(state_depth_.size() - 1);
+        };
+        
+        // Trie of the start markers
+        add_state(0);
+        for (size_t set = 0; set < marker_sets_.size(); ++set) {
+            const std::string& marker = marker_sets_[set].start_marker;
+            uint32_t state = ROOT_STATE;
+            for (char c : marker) {
+                size_t slot = state * ALPHABET_SIZE + static_cast<unsigned char>(c);
+                if (transitions_[slot] == NO_STATE) {
+                    // Assign after add_state, which grows the table
+                    uint32_t created = add_state(state_depth_[state] + 1);
+                    transitions_[slot] = created;
+                }
+                state = transitions_[slot];
+            }
+            state_marker_[state] = static_cast<uint32_t>(set);
+            max_marker_length_ = std::max(max_marker_length_, marker.size());
+            
+            unsigned char first = static_cast<unsigned char>(marker.front());
+            if (!first_byte_[first]) {
+                first_byte_[first] = true;
+                first_bytes_ += marker.front();
+            }
+            if (marker.size() > 1 && second_bytes_.find(marker[1]) == std::string::npos) {
+                second_bytes_ += marker[1];
+            }
+        }
+        
+        // A one-byte marker can be followed by anything
+        for (const auto& pair : marker_sets_) {
+            if (pair.start_marker.size() == 1) {
+                second_bytes_.clear();
+                break;
+            }
+        }
+        
+#if PERMUTO_HAS_X86_SIMD
+        use_avx2_ = cpu_supports_avx2();
+#endif
+        
+        // Breadth-first: fold failure transitions into the table and link
+        // each state to the nearest suffix state that ends a marker
+        std::vector<uint32_t> failure(state_depth_.size(), ROOT_STATE);
+        std::deque<uint32_t> queue;
+        for (size_t byte = 0; byte < ALPHABET_SIZE; ++byte) {
+            uint32_t& next = transitions_[ROOT_STATE * ALPHABET_SIZE + byte];
+            if (next == NO_STATE) {
+                next = ROOT_STATE;
+            } else {
+                queue.push_back(next);
+            }
+        }
+        
+        while (!queue.empty()) {
+            uint32_t state = queue.front();
+            queue.pop_front();
+            
+            uint32_t fail = failure[state];
+            output_link_[state] = state_marker_[fail] != NO_STATE ? fail : output_link_[fail];
+            
+            for (size_t byte = 0; byte < ALPHABET_SIZE; ++byte) {
+                uint32_t& next = transitions_[state * ALPHABET_SIZE + byte];
+                uint32_t fallback = transitions_[fail * ALPHABET_SIZE + byte];
+                if (next == NO_STATE) {
+                    next = fallback;
+                } else {
+                    failure[next] = fallback;
+                    queue.push_back(next);
+                }
+            }
+        }
+    }
+    
+    size_t MultiMarkerParser::skip_to_candidate(std::string_view text, size_t from) const {
+        size_t pos = from;
+        const char* data = text.data();
+        
+        // One byte that every start marker begins with or continues with:
+        // libc memchr finds it fastest, and with the least setup per call
+        if (first_bytes_.size() == 1 || second_bytes_.size() == 1) {
+            const size_t offset = first_bytes_.size() == 1 ? 0 : 1;
+            const char needle = offset == 0 ? first_bytes_[0] : second_bytes_[0];
+            for (size_t probe = pos + offset; probe < text.size(); ++probe) {
+                const void* hit = std::memchr(data + probe, needle, text.size() - probe);
+                if (!hit) {
+                    return std::string_view::npos;
+                }
+                probe = static_cast<size_t>(static_cast<const char*>(hit) - data);
+                if (first_byte_[static_cast<unsigned char>(data[probe - offset])]) {
+                    return probe - offset;
+                }
+            }
+            return std::string_view::npos;
+        }
+        
+#if PERMUTO_HAS_X86_SIMD
+        // Vector loops reject a stride of text at a time when the filter bytes
+        // are few; they stop at a candidate or near the end of the text
+        if (first_bytes_.size() <= MAX_VECTOR_BYTES && second_bytes_.size() <= MAX_VECTOR_BYTES) {
+            pos = use_avx2_ ? avx2_skip(text, pos, first_bytes_, second_bytes_)
+                            : sse2_skip(text, pos, first_bytes_, second_bytes_);
+        }
+#endif
+        
+        for (; pos < text.size(); ++pos) {
+            if (first_byte_[static_cast<unsigned char>(data[pos])]) {
+                return pos;
+            }
+        }
+        return std::string_view::npos;
+    }
+    
+    size_t MultiMarkerParser::find_start(std::string_view text, size_t from, uint64_t live,
+                                         size_t& marker_set) const {
+        size_t best_start = std::string_view::npos;
+        size_t best_length = 0;
+        
+        uint32_t state = ROOT_STATE;
+        size_t pos = from;
+        while (pos < text.size()) {
+            if (state == ROOT_STATE) {
+                // Nothing in progress can start before a match already found
+                if (best_start != std::string_view::npos) {
+                    break;
+                }
+                pos = skip_to_candidate(text, pos);
+                if (pos == std::string_view::npos) {
+                    break;
+                }
+            }
+            
+            state = transitions_[state * ALPHABET_SIZE + static_cast<unsigned char>(text[pos])];
+            
+            // Every marker ending at pos
+            uint32_t match = state_marker_[state] != NO_STATE ? state : output_link_[state];
+            for (; match != NO_STATE; match = output_link_[match]) {
+                size_t set = state_marker_[match];
+                if ((live & (uint64_t{1} << set)) == 0) {
+                    continue;
+                }
+                size_t length = state_depth_[match];
+                size_t start = pos + 1 - length;
+                if (start < best_start || (start == best_start && length > best_length)) {
+                    best_start = start;
+                    best_length = length;
+                    marker_set = set;
+                }
+            }
+            ++pos;
+            
+            // A marker starting at or before best_start has ended by now
+            if (best_start != std::string_view::npos && pos >= best_start + max_marker_length_) {
+                break;
+            }
+        }
+        
+        return best_start;
+    }
+}
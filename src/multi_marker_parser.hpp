@@ -0,0 +1,145 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "marker_search.hpp"
+#include "placeholder_parser.hpp"
+
+namespace permuto {
+    // Start and end marker of one placeholder syntax
+    struct MarkerPair {
+        std::string start_marker;
+        std::string end_marker;
+    };
+    
+    // Placeholder found by MultiMarkerParser
+    struct MarkedPlaceholder {
+        size_t marker_set;  // Index of the marker pair that matched
+        std::string path;
+        size_t start_pos;
+        size_t end_pos;
+    };
+    
+    // Finds the placeholders of several marker pairs in a single scan
+    // 
+    // All start markers are compiled into one Aho-Corasick automaton, so each
+    // byte of the text is examined once however many marker pairs there are;
+    // the caller maps each pair's index to its own context or stage.
+    // Placeholders never overlap: the scan takes the leftmost start marker
+    // (the longest if several start at the same position), then the first
+    // end marker of that pair, and continues after it. With a single pair this
+    // finds exactly what PlaceholderParser finds; with several, it finds the
+    // union of what each pair's PlaceholderParser finds as long as
+    // placeholders of different pairs do not overlap.
+    class MultiMarkerParser {
+    public:
+        // Throws std::invalid_argument if a pair's markers are empty or equal,
+        // two pairs share a start marker, or there are no or too many pairs
+        explicit MultiMarkerParser(std::vector<MarkerPair> marker_sets);
+        
+        static constexpr size_t MAX_MARKER_SETS = 64;
+        
+        size_t size() const { return marker_sets_.size(); }
+        const MarkerPair& marker_set(size_t index) const { return marker_sets_[index]; }
+        
+        // Find all placeholders in a string, in order
+        std::vector<MarkedPlaceholder> find_placeholders(std::string_view text) const;
+        
+        // Path of a string that is exactly one placeholder, as
+        // PlaceholderParser::extract_exact_placeholder accepts it; sets
+        // marker_set to its pair, the one with the longest start marker if
+        // several match. The path views into text.
+        std::optional<std::string_view> extract_exact_placeholder(std::string_view text,
+                                                                  size_t& marker_set) const;
+        
+        // Call fn(marker_set, path, start_pos, end_pos) for each placeholder in
+        // order; the path views into text and nothing is allocated
+        template <typename Fn>
+        void for_each_placeholder(std::string_view text, Fn&& fn) const;
+        
+        // Append text to out, with each placeholder replaced by whatever
+        // append_value(marker_set, path, out) appends. Returns the number of
+        // placeholders.
+        template <typename AppendFn>
+        size_t append_replaced(std::string_view text, std::string& out, AppendFn&& append_value) const;
+        
+    private:
+        static constexpr uint32_t NO_STATE = UINT32_MAX;
+        static constexpr size_t ALPHABET_SIZE = 256;
+        
+        std::vector<MarkerPair> marker_sets_;
+        
+        // Automaton over the start markers, with failure transitions folded
+        // into a dense table: transitions_[state * ALPHABET_SIZE + byte]
+        std::vector<uint32_t> transitions_;
+        std::vector<uint32_t> state_marker_;  // Marker set ending exactly at a state, or NO_STATE
+        std::vector<uint32_t> output_link_;   // Nearest proper suffix state ending a marker
+        std::vector<uint32_t> state_depth_;   // Length of the prefix a state represents
+        size_t max_marker_length_ = 0;
+        
+        bool first_byte_[ALPHABET_SIZE] = {};  // Bytes that can begin a start marker
+        std::string first_bytes_;              // The same bytes as a list, for vector skipping
+        std::string second_bytes_;             // Bytes that can follow them; empty if a marker is one byte
+        bool use_avx2_ = false;
+        
+        void build_automaton();
+        
+        // Position of the next byte at or after from that can begin a start marker
+        size_t skip_to_candidate(std::string_view text, size_t from) const;
+        
+        // Leftmost (then longest) start marker of a set in live at or after
+        // from; sets marker_set and returns its position, or npos if none
+        size_t find_start(std::string_view text, size_t from, uint64_t live, size_t& marker_set) const;
+    };
+    
+    template <typename Fn>
+    void MultiMarkerParser::for_each_placeholder(std::string_view text, Fn&& fn) const {
+        uint64_t live = marker_sets_.size() == MAX_MARKER_SETS
+            ? ~uint64_t{0} : (uint64_t{1} << marker_sets_.size()) - 1;
+        
+        size_t pos = 0;
+        while (pos < text.length() && live != 0) {
+            size_t set = 0;
+            size_t start = find_start(text, pos, live, set);
+            if (start == std::string_view::npos) {
+                break;
+            }
+            
+            const MarkerPair& pair = marker_sets_[set];
+            size_t path_start = start + pair.start_marker.length();
+            size_t end = find_marker(text, path_start, pair.end_marker);
+            if (end == std::string_view::npos) {
+                // This pair can never be closed again, but the others still can
+                live &= ~(uint64_t{1} << set);
+                pos = start + 1;
+                continue;
+            }
+            
+            std::string_view path = text.substr(path_start, end - path_start);
+            pos = end + pair.end_marker.length();
+            if (PlaceholderParser::is_valid_path(path)) {
+                fn(set, path, start, pos);
+            }
+        }
+    }
+    
+    template <typename AppendFn>
+    size_t MultiMarkerParser::append_replaced(std::string_view text, std::string& out,
+                                              AppendFn&& append_value) const {
+        out.reserve(out.size() + text.size());
+        
+        size_t count = 0;
+        size_t last_pos = 0;
+        for_each_placeholder(text, [&](size_t set, std::string_view path, size_t start_pos, size_t end_pos) {
+            out.append(text.data() + last_pos, start_pos - last_pos);
+            append_value(set, path, out);
+            last_pos = end_pos;
+            ++count;
+        });
+        
+        out.append(text.data() + last_pos, text.size() - last_pos);
+        return count;
+    }
+}
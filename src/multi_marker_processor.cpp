@@ -0,0 +1,164 @@
+#include "multi_marker_processor.hpp"
+#include <stdexcept>
+#include "json_pointer.hpp"
+#include "value_formatter.hpp"
+
+namespace permuto {
+    namespace {
+        const size_t INITIAL_RECURSION_DEPTH = 0;
+    }
+    
+    MultiMarkerProcessor::MultiMarkerProcessor(const std::vector<MarkerContext>& contexts,
+                                               const Options& options)
+        : options_(options), parser_(marker_pairs(contexts)) {
+        options_.validate();
+        if (options_.recursive_expansion) {
+            throw std::invalid_argument("apply_multi does not support recursive expansion");
+        }
+        if (options_.engine == ProcessingEngine::Iterative) {
+            throw std::invalid_argument("apply_multi does not support the iterative engine");
+        }
+        
+        contexts_.reserve(contexts.size());
+        for (const auto& marker_context : contexts) {
+            if (!marker_context.context) {
+                throw std::invalid_argument("Marker context cannot be null");
+            }
+            contexts_.push_back(marker_context.context);
+        }
+    }
+    
+    std::vector<MarkerPair> MultiMarkerProcessor::marker_pairs(const std::vector<MarkerContext>& contexts) {
+        std::vector<MarkerPair> pairs;
+        pairs.reserve(contexts.size());
+        for (const auto& marker_context : contexts) {
+            pairs.push_back({marker_context.start_marker, marker_context.end_marker});
+        }
+        return pairs;
+    }
+    
+    nlohmann::json MultiMarkerProcessor::process(const nlohmann::json& template_json) const {
+        if (options_.missing_key_behavior == MissingKeyBehavior::Remove && template_json.is_string()) {
+            size_t marker_set = 0;
+            if (parser_.extract_exact_placeholder(template_json.get_ref<const std::string&>(), marker_set)) {
+                throw std::invalid_argument("Remove mode cannot be used with root-level placeholders");
+            }
+        }
+        return process_value(template_json, INITIAL_RECURSION_DEPTH);
+    }
+    
+    nlohmann::json MultiMarkerProcessor::process_value(const nlohmann::json& value, size_t depth) const {
+        check_recursion_limit(depth);
+        
+        if (value.is_string()) {
+            return process_string(value.get_ref<const std::string&>());
+        }
+        
+        if (value.is_object()) {
+            nlohmann::json result = nlohmann::json::object();
+            for (auto it = value.begin(); it != value.end(); ++it) {
+                nlohmann::json processed;
+                if (process_element(it.value(), depth + 1, processed)) {
+                    result[it.key()] = std::move(processed);
+                }
+            }
+            return result;
+        }
+        
+        if (value.is_array()) {
+            nlohmann::json result = nlohmann::json::array();
+            for (const auto& item : value) {
+                nlohmann::json processed;
+                if (process_element(item, depth + 1, processed)) {
+                    result.push_back(std::move(processed));
+                }
+            }
+            return result;
+        }
+        
+        // Primitive values (numbers, booleans, null) are returned as-is
+        return value;
+    }
+    
+    nlohmann::json MultiMarkerProcessor::process_string(const std::string& str) const {
+        size_t marker_set = 0;
+        auto exact_path = parser_.extract_exact_placeholder(str, marker_set);
+        if (exact_path) {
+            const nlohmann::json* resolved = resolve(marker_set, *exact_path);
+            if (resolved) {
+                return *resolved;
+            }
+            if (options_.missing_key_behavior == MissingKeyBehavior::Error) {
+                throw MissingKeyException("Missing key in context", std::string(*exact_path));
+            }
+            return str;
+        }
+        
+        if (!options_.enable_interpolation) {
+            return str;
+        }
+        
+        // One scan finds the placeholders of every pair
+        std::string result;
+        size_t replaced = parser_.append_replaced(str, result,
+            [this](size_t set, std::string_view path, std::string& buffer) {
+                const nlohmann::json* resolved = resolve(set, path);
+                if (resolved) {
+                    append_json_string(buffer, *resolved);
+                } else if (options_.missing_key_behavior == MissingKeyBehavior::Error) {
+                    throw MissingKeyException("Missing key in context", std::string(path));
+                } else {
+                    // Keep the original placeholder
+                    const MarkerPair& pair = parser_.marker_set(set);
+                    buffer += pair.start_marker;
+                    buffer += path;
+                    buffer += pair.end_marker;
+                }
+            });
+        
+        if (replaced == 0) {
+            return str;
+        }
+        return result;
+    }
+    
+    bool MultiMarkerProcessor::process_element(const nlohmann::json& value, size_t depth,
+                                               nlohmann::json& out) const {
+        if (options_.missing_key_behavior == MissingKeyBehavior::Remove && value.is_string()) {
+            // Interpolation is disabled, so a string is either an exact
+            // placeholder or a literal
+            const auto& str = value.get_ref<const std::string&>();
+            size_t marker_set = 0;
+            auto exact_path = parser_.extract_exact_placeholder(str, marker_set);
+            if (exact_path) {
+                const nlohmann::json* resolved = resolve(marker_set, *exact_path);
+                if (!resolved) {
+                    return false;
+                }
+                check_recursion_limit(depth);
+                out = *resolved;
+                return true;
+            }
+        }
+        
+        out = process_value(value, depth);
+        return true;
+    }
+    
+    const nlohmann::json* MultiMarkerProcessor::resolve(size_t marker_set, std::string_view path) const {
+        // Invalid pointers resolve to nothing
+        PointerRef pointer;
+        try {
+            pointer = intern_pointer(path);
+        } catch (const std::exception&) {
+            return nullptr;
+        }
+        return pointer->find(*contexts_[marker_set]);
+    }
+    
+    void MultiMarkerProcessor::check_recursion_limit(size_t depth) const {
+        if (depth >= options_.max_recursion_depth) {
+            throw RecursionLimitException("Maximum recursion depth exceeded", depth);
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../include/permuto/permuto.hpp"
+#include "multi_marker_parser.hpp"
+
+namespace permuto {
+    // Applies templates whose placeholders use several marker pairs, each
+    // resolved against its own context (see apply_multi)
+    //
+    // THREAD SAFETY:
+    // - Contains no mutable state after construction
+    // - process() keeps nothing between calls
+    class MultiMarkerProcessor {
+    public:
+        // Throws std::invalid_argument for invalid marker pairs or options,
+        // a null context, recursive expansion or the iterative engine
+        MultiMarkerProcessor(const std::vector<MarkerContext>& contexts, const Options& options);
+        
+        nlohmann::json process(const nlohmann::json& template_json) const;
+        
+    private:
+        Options options_;
+        MultiMarkerParser parser_;
+        std::vector<const nlohmann::json*> contexts_;  // Context of each marker pair
+        
+        nlohmann::json process_value(const nlohmann::json& value, size_t depth) const;
+        nlohmann::json process_string(const std::string& str) const;
+        
+        // Process an object member or array element found at depth; returns
+        // false if Remove mode drops it
+        bool process_element(const nlohmann::json& value, size_t depth, nlohmann::json& out) const;
+        
+        // Value at path in the context of marker_set, or nullptr if missing
+        const nlohmann::json* resolve(size_t marker_set, std::string_view path) const;
+        
+        void check_recursion_limit(size_t depth) const;
+        
+        static std::vector<MarkerPair> marker_pairs(const std::vector<MarkerContext>& contexts);
+    };
+}
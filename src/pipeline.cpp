@@ -0,0 +1,268 @@
+#include "pipeline.hpp"
+#include "marker_search.hpp"
+#include <stdexcept>
+
+namespace permuto {
+    namespace {
+        const size_t ROOT_DEPTH = 0;
+        
+        // Append tokens[from..] to path in JSON Pointer syntax
+        void append_tokens(std::string& path, const std::vector<std::string>& tokens, size_t from) {
+            for (size_t i = from; i < tokens.size(); ++i) {
+                path += '/';
+                for (char c : tokens[i]) {
+                    if (c == '~') {
+                        path += "~0";
+                    } else if (c == '/') {
+                        path += "~1";
+                    } else {
+                        path += c;
+                    }
+                }
+            }
+        }
+        
+        // Interned pointer for path, or nullptr if path is not a valid JSON Pointer
+        PointerRef try_intern(std::string_view path) {
+            try {
+                return intern_pointer(path);
+            } catch (const std::exception&) {
+                return nullptr;
+            }
+        }
+    }
+    
+    Pipeline::Impl::Impl(std::vector<PipelineStage> stages) {
+        if (stages.empty()) {
+            throw std::invalid_argument("Pipeline must have at least one stage");
+        }
+        
+        stages_.reserve(stages.size());
+        for (auto& stage : stages) {
+            // The processor validates the options
+            TemplateProcessor processor(stage.options);
+            PlaceholderParser parser(stage.options.start_marker, stage.options.end_marker);
+            
+            if (stage.options.missing_key_behavior == MissingKeyBehavior::Remove &&
+                stage.template_json.is_string() &&
+                parser.extract_exact_placeholder(stage.template_json.get_ref<const std::string&>())) {
+                throw std::invalid_argument("Remove mode cannot be used with root-level placeholders");
+            }
+            
+            stages_.push_back(Stage{std::move(stage.template_json), stage.options,
+                                    std::move(parser), std::move(processor)});
+        }
+    }
+    
+    nlohmann::json Pipeline::Impl::apply(const nlohmann::json& context) const {
+        Evaluation eval;
+        eval.context = &context;
+        eval.contexts.resize(stages_.size());
+        eval.found.resize(stages_.size());
+        
+        // The first stage reads the context directly; later stages read the
+        // output of the stage before them
+        for (size_t stage = 1; stage < stages_.size(); ++stage) {
+            eval.contexts[stage].lookup = [this, stage, &eval](const JsonPointer& pointer) {
+                return find_input(stage, pointer, eval);
+            };
+        }
+        
+        const Stage& last = stages_.back();
+        return last.processor.process(last.template_json, context, eval.contexts.back(), ROOT_DEPTH);
+    }
+    
+    const nlohmann::json* Pipeline::Impl::find_input(size_t stage, const JsonPointer& pointer,
+                                                     Evaluation& eval) const {
+        if (stage == 0) {
+            return pointer.find(*eval.context);
+        }
+        return find_output(stage - 1, pointer, eval);
+    }
+    
+    const nlohmann::json* Pipeline::Impl::find_output(size_t stage, const JsonPointer& pointer,
+                                                      Evaluation& eval) const {
+        auto& found = eval.found[stage];
+        auto cached = found.find(pointer.path());
+        if (cached != found.end()) {
+            return cached->second;
+        }
+        
+        const nlohmann::json* value = walk_output(stage, pointer, eval);
+        found.emplace(pointer.path(), value);
+        return value;
+    }
+    
+    const nlohmann::json* Pipeline::Impl::walk_output(size_t stage, const JsonPointer& pointer,
+                                                      Evaluation& eval) const {
+        const Stage& current = stages_[stage];
+        const auto& tokens = pointer.tokens();
+        const bool remove_missing = current.options.missing_key_behavior == MissingKeyBehavior::Remove;
+        
+        const nlohmann::json* node = &current.template_json;
+        size_t depth = ROOT_DEPTH;
+        size_t next = 0;
+        
+        // Follow the pointer through the template while nodes are containers
+        for (; next < tokens.size() && node->is_structured(); ++next) {
+            check_depth(stage, depth);
+            
+            if (node->is_object()) {
+                auto it = node->find(tokens[next]);
+                if (it == node->end()) {
+                    return nullptr;
+                }
+                node = &*it;
+            } else if (remove_missing) {
+                node = kept_element(stage, *node, pointer.indices()[next], eval);
+                if (!node) {
+                    return nullptr;
+                }
+            } else {
+                size_t index = pointer.indices()[next];
+                if (index == JsonPointer::NO_INDEX || index >= node->size()) {
+                    return nullptr;
+                }
+                node = &(*node)[index];
+            }
+            ++depth;
+        }
+        
+        if (node->is_string()) {
+            const auto& str = node->get_ref<const std::string&>();
+            
+            // Exact placeholders continue straight into the previous stage;
+            // expanded values have to be substituted first
+            auto exact_path = current.parser.extract_exact_placeholder(str);
+            if (exact_path && !current.options.recursive_expansion) {
+                return resolve_placeholder(stage, *node, *exact_path, pointer, next, depth, eval);
+            }
+            
+            const bool substituted = exact_path ||
+                (current.options.enable_interpolation &&
+                 find_marker(str, 0, current.options.start_marker) != std::string_view::npos);
+            if (!substituted) {
+                if (next < tokens.size()) {
+                    return nullptr;
+                }
+                check_depth(stage, depth);
+                return node;
+            }
+        } else if (!node->is_structured()) {
+            if (next < tokens.size()) {
+                return nullptr;
+            }
+            check_depth(stage, depth);
+            return node;
+        }
+        
+        // Substitute the node reached, then follow the rest of the pointer in it
+        const nlohmann::json* value = materialize(stage, *node, depth, eval);
+        if (next == tokens.size()) {
+            return value;
+        }
+        
+        std::string rest;
+        append_tokens(rest, tokens, next);
+        PointerRef rest_pointer = try_intern(rest);
+        return rest_pointer ? rest_pointer->find(*value) : nullptr;
+    }
+    
+    const nlohmann::json* Pipeline::Impl::resolve_placeholder(size_t stage, const nlohmann::json& node,
+                                                              const std::string& path,
+                                                              const JsonPointer& pointer,
+                                                              size_t from, size_t depth,
+                                                              Evaluation& eval) const {
+        const Stage& current = stages_[stage];
+        const MissingKeyBehavior behavior = current.options.missing_key_behavior;
+        
+        // Remove mode decides on removal before the depth check, like TemplateProcessor
+        if (behavior != MissingKeyBehavior::Remove) {
+            check_depth(stage, depth);
+        }
+        
+        PointerRef target = try_intern(path);
+        const nlohmann::json* value = target ? find_input(stage, *target, eval) : nullptr;
+        if (!value) {
+            if (behavior == MissingKeyBehavior::Error) {
+                throw MissingKeyException("Missing key in context", path);
+            }
+            // Remove mode drops the node; otherwise the placeholder stays as-is
+            if (behavior == MissingKeyBehavior::Remove || from < pointer.tokens().size()) {
+                return nullptr;
+            }
+            return &node;
+        }
+        
+        check_depth(stage, depth);
+        if (from == pointer.tokens().size()) {
+            return value;
+        }
+        
+        // The rest of the pointer continues inside the substituted value
+        std::string combined;
+        append_tokens(combined, target->tokens(), 0);
+        append_tokens(combined, pointer.tokens(), from);
+        PointerRef continued = try_intern(combined);
+        return continued ? find_input(stage, *continued, eval) : nullptr;
+    }
+    
+    const nlohmann::json* Pipeline::Impl::materialize(size_t stage, const nlohmann::json& node,
+                                                      size_t depth, Evaluation& eval) const {
+        eval.values.push_front(stages_[stage].processor.process(node, *eval.context,
+                                                                eval.contexts[stage], depth));
+        return &eval.values.front();
+    }
+    
+    const nlohmann::json* Pipeline::Impl::kept_element(size_t stage, const nlohmann::json& array,
+                                                       size_t index, Evaluation& eval) const {
+        auto entry = eval.kept_elements.find(&array);
+        if (entry == eval.kept_elements.end()) {
+            // Remove mode drops exactly the elements that are unresolvable
+            // exact placeholders, so indices shift past them
+            const Stage& current = stages_[stage];
+            std::vector<size_t> kept;
+            kept.reserve(array.size());
+            for (size_t i = 0; i < array.size(); ++i) {
+                const nlohmann::json& element = array[i];
+                if (element.is_string()) {
+                    auto exact_path = current.parser.extract_exact_placeholder(
+                        element.get_ref<const std::string&>());
+                    if (exact_path) {
+                        PointerRef target = try_intern(*exact_path);
+                        if (!target || !find_input(stage, *target, eval)) {
+                            continue;
+                        }
+                    }
+                }
+                kept.push_back(i);
+            }
+            entry = eval.kept_elements.emplace(&array, std::move(kept)).first;
+        }
+        
+        const auto& kept = entry->second;
+        if (index == JsonPointer::NO_INDEX || index >= kept.size()) {
+            return nullptr;
+        }
+        return &array[kept[index]];
+    }
+    
+    void Pipeline::Impl::check_depth(size_t stage, size_t depth) const {
+        if (depth >= stages_[stage].options.max_recursion_depth) {
+            throw RecursionLimitException("Maximum recursion depth exceeded", depth);
+        }
+    }
+    
+    // Public wrapper
+    
+    Pipeline::Pipeline(std::vector<PipelineStage> stages)
+        : impl_(std::make_shared<const Impl>(std::move(stages))) {}
+    
+    nlohmann::json Pipeline::apply(const nlohmann::json& context) const {
+        return impl_->apply(context);
+    }
+    
+    size_t Pipeline::size() const {
+        return impl_->size();
+    }
+}
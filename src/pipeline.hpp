@@ -0,0 +1,77 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include <forward_list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../include/permuto/permuto.hpp"
+#include "json_pointer.hpp"
+#include "placeholder_parser.hpp"
+#include "template_processor.hpp"
+
+namespace permuto {
+    // Immutable chain of templates evaluated lazily from the last stage back
+    //
+    // THREAD SAFETY:
+    // - Contains no mutable state after construction
+    // - apply() keeps all lookups and materialized values in per-call storage
+    class Pipeline::Impl {
+    public:
+        explicit Impl(std::vector<PipelineStage> stages);
+        
+        nlohmann::json apply(const nlohmann::json& context) const;
+        
+        size_t size() const { return stages_.size(); }
+        
+    private:
+        struct Stage {
+            nlohmann::json template_json;
+            Options options;
+            PlaceholderParser parser;
+            TemplateProcessor processor;
+        };
+        
+        // State of one apply() call
+        struct Evaluation {
+            const nlohmann::json* context = nullptr;
+            std::vector<ProcessingContext> contexts;  // Processing state per stage
+            // Value at each path looked up in each stage's output (nullptr if missing)
+            std::vector<std::unordered_map<std::string, const nlohmann::json*>> found;
+            std::forward_list<nlohmann::json> values;  // Owns materialized parts of outputs
+            // Template indices of the elements Remove mode keeps, per array node
+            std::unordered_map<const nlohmann::json*, std::vector<size_t>> kept_elements;
+        };
+        
+        std::vector<Stage> stages_;
+        
+        // Value at pointer in the input of stage, i.e. the previous stage's
+        // output or the context; nullptr if missing
+        const nlohmann::json* find_input(size_t stage, const JsonPointer& pointer,
+                                         Evaluation& eval) const;
+        
+        // Value at pointer in the output of stage, substituting only the
+        // template node the pointer leads to
+        const nlohmann::json* find_output(size_t stage, const JsonPointer& pointer,
+                                          Evaluation& eval) const;
+        const nlohmann::json* walk_output(size_t stage, const JsonPointer& pointer,
+                                          Evaluation& eval) const;
+        
+        // Value of an exact placeholder node of stage at depth, continued
+        // with the pointer's tokens from index from on; applies the stage's
+        // missing key behavior to the placeholder itself
+        const nlohmann::json* resolve_placeholder(size_t stage, const nlohmann::json& node,
+                                                  const std::string& path, const JsonPointer& pointer,
+                                                  size_t from, size_t depth, Evaluation& eval) const;
+        
+        // Substitute a template node of stage found at depth and keep the result
+        const nlohmann::json* materialize(size_t stage, const nlohmann::json& node, size_t depth,
+                                          Evaluation& eval) const;
+        
+        // Template node of the element at output index of a Remove-mode array
+        const nlohmann::json* kept_element(size_t stage, const nlohmann::json& array, size_t index,
+                                           Evaluation& eval) const;
+        
+        // Throws RecursionLimitException if a node of stage at depth exceeds the limit
+        void check_depth(size_t stage, size_t depth) const;
+    };
+}
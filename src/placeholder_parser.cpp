@@ -14,37 +14,18 @@ namespace permuto {
         }
     }
     
-    std::vector<Placeholder> PlaceholderParser::find_placeholders(const std::string& text) const {
+    std::vector<Placeholder> PlaceholderParser::find_placeholders(std::string_view text) const {
         std::vector<Placeholder> placeholders;
         
-        size_t pos = 0;
-        while (pos < text.length()) {
-            size_t start = text.find(start_marker_, pos);
-            if (start == std::string::npos) {
-                break;
-            }
+        for_each_placeholder(text, [&](std::string_view path, size_t start_pos, size_t end_pos) {
+            Placeholder placeholder;
+            placeholder.path = std::string(path);
+            placeholder.start_pos = start_pos;
+            placeholder.end_pos = end_pos;
+            placeholder.is_exact_match = (start_pos == 0 && end_pos == text.length());
             
-            size_t path_start = start + start_marker_.length();
-            size_t end = text.find(end_marker_, path_start);
-            if (end == std::string::npos) {
-                // No matching end marker, skip this start marker
-                pos = start + 1;
-                continue;
-            }
-            
-            std::string path = text.substr(path_start, end - path_start);
-            if (is_valid_path(path)) {
-                Placeholder placeholder;
-                placeholder.path = path;
-                placeholder.start_pos = start;
-                placeholder.end_pos = end + end_marker_.length();
-                placeholder.is_exact_match = (start == 0 && placeholder.end_pos == text.length());
-                
-                placeholders.push_back(placeholder);
-            }
-            
-            pos = end + end_marker_.length();
-        }
+            placeholders.push_back(std::move(placeholder));
+        });
         
         return placeholders;
     }
@@ -54,17 +35,17 @@ namespace permuto {
             return std::nullopt;
         }
         
-        if (text.substr(0, start_marker_.length()) != start_marker_ || 
-            text.substr(text.length() - end_marker_.length()) != end_marker_) {
+        // Compare markers in place instead of through substr() copies
+        if (text.compare(0, start_marker_.length(), start_marker_) != 0 || 
+            text.compare(text.length() - end_marker_.length(), end_marker_.length(), end_marker_) != 0) {
             return std::nullopt;
         }
         
         size_t path_start = start_marker_.length();
         size_t path_length = text.length() - start_marker_.length() - end_marker_.length();
-        std::string path = text.substr(path_start, path_length);
         
-        if (is_valid_path(path)) {
-            return path;
+        if (is_valid_path(std::string_view(text).substr(path_start, path_length))) {
+            return text.substr(path_start, path_length);
         }
         
         return std::nullopt;
@@ -73,37 +54,20 @@ namespace permuto {
     std::string PlaceholderParser::replace_placeholders(const std::string& text,
         const std::function<std::string(const std::string&)>& value_provider) const {
         
-        auto placeholders = find_placeholders(text);
-        if (placeholders.empty()) {
-            return text;
-        }
-        
         std::string result;
-        size_t last_pos = 0;
-        
-        for (const auto& placeholder : placeholders) {
-            // Add text before this placeholder
-            result += text.substr(last_pos, placeholder.start_pos - last_pos);
-            
-            // Add the replacement value
-            result += value_provider(placeholder.path);
-            
-            last_pos = placeholder.end_pos;
-        }
-        
-        // Add remaining text
-        result += text.substr(last_pos);
-        
+        append_replaced(text, result, [&value_provider](std::string_view path, std::string& out) {
+            out += value_provider(std::string(path));
+        });
         return result;
     }
     
-    bool PlaceholderParser::is_valid_path(const std::string& path) const {
+    bool PlaceholderParser::is_valid_path(std::string_view path) {
         // Empty path is valid (refers to root)
         if (path.empty()) {
             return true;
         }
         
         // Must start with '/' for JSON Pointer
-        return path[0] == '/';
+        return path.front() == '/';
     }
 }
\ No newline at end of file
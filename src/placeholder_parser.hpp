@@ -1,8 +1,10 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
 #include <functional>
+#include "marker_search.hpp"
 
 namespace permuto {
     struct Placeholder {
@@ -18,19 +20,79 @@ namespace permuto {
                          const std::string& end_marker = "}");
         
         // Find all placeholders in a string
-        std::vector<Placeholder> find_placeholders(const std::string& text) const;
+        std::vector<Placeholder> find_placeholders(std::string_view text) const;
         
         // Check if string is exactly one placeholder (for exact-match substitution)
         std::optional<std::string> extract_exact_placeholder(const std::string& text) const;
         
         // Replace placeholders in text with provided values
+        // Convenience wrapper around append_replaced
         std::string replace_placeholders(const std::string& text, 
             const std::function<std::string(const std::string&)>& value_provider) const;
         
+        // Call fn(path, start_pos, end_pos) for each placeholder in order
+        // The path views into text; nothing is allocated
+        template <typename Fn>
+        void for_each_placeholder(std::string_view text, Fn&& fn) const;
+        
+        // Append text to out, with each placeholder replaced by whatever
+        // append_value(path, out) appends. Reserves room for text up front and
+        // builds no intermediate strings. Returns the number of placeholders.
+        template <typename AppendFn>
+        size_t append_replaced(std::string_view text, std::string& out, AppendFn&& append_value) const;
+        
+        // True if the text between markers can be a placeholder path
+        static bool is_valid_path(std::string_view path);
+        
     private:
         std::string start_marker_;
         std::string end_marker_;
-        
-        bool is_valid_path(const std::string& path) const;
     };
-}
\ No newline at end of file
+    
+    template <typename Fn>
+    void PlaceholderParser::for_each_placeholder(std::string_view text, Fn&& fn) const {
+        // Single pass: every byte is examined by at most one start-marker search
+        // and one end-marker search, so scanning is linear in the text length
+        size_t pos = 0;
+        while (pos < text.length()) {
+            size_t start = find_marker(text, pos, start_marker_);
+            if (start == std::string_view::npos) {
+                break;
+            }
+            
+            size_t path_start = start + start_marker_.length();
+            size_t end = find_marker(text, path_start, end_marker_);
+            if (end == std::string_view::npos) {
+                // No end marker after this start, so no later start marker can
+                // be closed either
+                break;
+            }
+            
+            std::string_view path = text.substr(path_start, end - path_start);
+            pos = end + end_marker_.length();
+            if (is_valid_path(path)) {
+                fn(path, start, pos);
+            }
+        }
+    }
+    
+    template <typename AppendFn>
+    size_t PlaceholderParser::append_replaced(std::string_view text, std::string& out,
+                                              AppendFn&& append_value) const {
+        out.reserve(out.size() + text.size());
+        
+        size_t count = 0;
+        size_t last_pos = 0;
+        for_each_placeholder(text, [&](std::string_view path, size_t start_pos, size_t end_pos) {
+            // Text before this placeholder, then its value
+            out.append(text.data() + last_pos, start_pos - last_pos);
+            append_value(path, out);
+            last_pos = end_pos;
+            ++count;
+        });
+        
+        // Remaining text
+        out.append(text.data() + last_pos, text.size() - last_pos);
+        return count;
+    }
+}
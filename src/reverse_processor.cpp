@@ -1,6 +1,5 @@
 #include "reverse_processor.hpp"
 #include "json_pointer.hpp"
-#include <sstream>
 
 namespace permuto {
     ReverseProcessor::ReverseProcessor(const Options& options) 
@@ -28,17 +27,45 @@ namespace permuto {
     
     nlohmann::json ReverseProcessor::apply_reverse(const nlohmann::json& reverse_template,
                                                   const nlohmann::json& result_json) const {
+        return reconstruct(reverse_template, result_json, nullptr);
+    }
+    
+    nlohmann::json ReverseProcessor::apply_reverse(const nlohmann::json& reverse_template,
+                                                  nlohmann::json&& result_json) const {
+        // Record every lookup so each result value is moved at its last use
+        MovePlan plan;
+        for (auto it = reverse_template.begin(); it != reverse_template.end(); ++it) {
+            try {
+                plan.expect(*intern_pointer(it.key()), result_json);
+            } catch (const std::exception&) {
+                // Invalid result paths are skipped by reconstruct() as well
+            }
+        }
+        
+        return reconstruct(reverse_template, result_json, &plan);
+    }
+    
+    nlohmann::json ReverseProcessor::reconstruct(const nlohmann::json& reverse_template,
+                                                const nlohmann::json& result_json,
+                                                MovePlan* plan) const {
         nlohmann::json context = nlohmann::json::object();
         
         // Process each mapping in the reverse template
         for (auto it = reverse_template.begin(); it != reverse_template.end(); ++it) {
             const std::string& result_path = it.key();
-            const std::string& context_path = it.value().get<std::string>();
+            const std::string& context_path = it.value().get_ref<const std::string&>();
             
             // Get value from result at result_path
-            auto result_value = get_at_path(result_json, result_path);
-            if (result_value) {
-                // Set value in context at context_path
+            const nlohmann::json* result_value = get_at_path(result_json, result_path);
+            if (!result_value) {
+                continue;
+            }
+            
+            // Set value in context at context_path
+            if (plan && plan->use(result_value)) {
+                // Only given a plan for results handed over by rvalue, so the value is not const
+                set_at_path(context, context_path, std::move(*const_cast<nlohmann::json*>(result_value)));
+            } else {
                 set_at_path(context, context_path, *result_value);
             }
         }
@@ -95,13 +122,14 @@ namespace permuto {
     }
     
     void ReverseProcessor::set_at_path(nlohmann::json& target, const std::string& path, 
-                                      const nlohmann::json& value) const {
+                                      nlohmann::json value) const {
         if (path.empty()) {
-            target = value;
+            target = std::move(value);
             return;
         }
         
-        auto tokens = path_to_tokens(path);
+        PointerRef pointer = intern_pointer(path);
+        const auto& tokens = pointer->tokens();
         nlohmann::json* current = &target;
         
         for (size_t i = 0; i < tokens.size(); ++i) {
@@ -113,7 +141,7 @@ namespace permuto {
                 if (current->is_null()) {
                     *current = nlohmann::json::object();
                 }
-                (*current)[token] = value;
+                (*current)[token] = std::move(value);
             } else {
                 // Navigate or create intermediate objects
                 if (current->is_null()) {
@@ -130,50 +158,12 @@ namespace permuto {
         }
     }
     
-    std::optional<nlohmann::json> ReverseProcessor::get_at_path(const nlohmann::json& source, 
-                                                               const std::string& path) const {
+    const nlohmann::json* ReverseProcessor::get_at_path(const nlohmann::json& source, 
+                                                       const std::string& path) const {
         try {
-            JsonPointer pointer(path);
-            return pointer.resolve(source);
+            return intern_pointer(path)->find(source);
         } catch (const std::exception&) {
-            return std::nullopt;
+            return nullptr;
         }
     }
-    
-    std::vector<std::string> ReverseProcessor::path_to_tokens(const std::string& path) const {
-        if (path.empty()) {
-            return {};
-        }
-        
-        if (path[0] != '/') {
-            throw std::invalid_argument("Path must start with '/'");
-        }
-        
-        std::vector<std::string> tokens;
-        std::stringstream ss(path.substr(1)); // Skip leading '/'
-        std::string token;
-        
-        while (std::getline(ss, token, '/')) {
-            // Unescape JSON Pointer tokens
-            std::string unescaped;
-            for (size_t i = 0; i < token.size(); ++i) {
-                if (token[i] == '~' && i + 1 < token.size()) {
-                    if (token[i + 1] == '0') {
-                        unescaped += '~';
-                        ++i;
-                    } else if (token[i + 1] == '1') {
-                        unescaped += '/';
-                        ++i;
-                    } else {
-                        unescaped += token[i];
-                    }
-                } else {
-                    unescaped += token[i];
-                }
-            }
-            tokens.push_back(unescaped);
-        }
-        
-        return tokens;
-    }
 }
\ No newline at end of file
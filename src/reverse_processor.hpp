@@ -2,6 +2,7 @@
 #include <nlohmann/json.hpp>
 #include "../include/permuto/permuto.hpp"
 #include "placeholder_parser.hpp"
+#include "move_plan.hpp"
 #include <map>
 
 namespace permuto {
@@ -21,6 +22,10 @@ namespace permuto {
         nlohmann::json apply_reverse(const nlohmann::json& reverse_template,
                                     const nlohmann::json& result_json) const;
         
+        // Apply reverse template, moving values out of a result the caller gives up
+        nlohmann::json apply_reverse(const nlohmann::json& reverse_template,
+                                    nlohmann::json&& result_json) const;
+        
     private:
         Options options_;
         PlaceholderParser parser_;
@@ -39,15 +44,17 @@ namespace permuto {
         void analyze_string(const std::string& str, const std::string& current_path,
                            std::vector<PathMapping>& mappings) const;
         
+        // Copy (or, with a move plan, move) mapped result values into a new context
+        nlohmann::json reconstruct(const nlohmann::json& reverse_template,
+                                   const nlohmann::json& result_json,
+                                   MovePlan* plan) const;
+        
         // Set value at JSON pointer path
         void set_at_path(nlohmann::json& target, const std::string& path, 
-                        const nlohmann::json& value) const;
-        
-        // Get value at JSON pointer path
-        std::optional<nlohmann::json> get_at_path(const nlohmann::json& source, 
-                                                 const std::string& path) const;
+                        nlohmann::json value) const;
         
-        // Convert JSON pointer path to array of tokens
-        std::vector<std::string> path_to_tokens(const std::string& path) const;
+        // Get value at JSON pointer path (borrowed from source, nullptr if missing)
+        const nlohmann::json* get_at_path(const nlohmann::json& source, 
+                                          const std::string& path) const;
     };
 }
\ No newline at end of file
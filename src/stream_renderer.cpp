@@ -0,0 +1,234 @@
+#include "stream_renderer.hpp"
+#include <stdexcept>
+
+namespace permuto {
+    namespace {
+        const size_t POINTER_CACHE_LIMIT = 4096;
+    }
+    
+    StreamRenderer::StreamRenderer(const nlohmann::json& context, const Options& options,
+                                   Sink& sink, int indent)
+        : context_(context), options_(options), processor_(options),
+          parser_(options.start_marker, options.end_marker), writer_(sink, indent) {
+        options_.validate();
+    }
+    
+    void StreamRenderer::render_value(const nlohmann::json& value) {
+        // Containers being walked and their next child, on the heap like the
+        // parser's own state, so deep templates are safe with either engine
+        struct Position {
+            const nlohmann::json* container;
+            nlohmann::json::const_iterator next;
+        };
+        std::vector<Position> open;
+        
+        const nlohmann::json* current = &value;
+        for (;;) {
+            switch (current->type()) {
+                case nlohmann::json::value_t::object:
+                case nlohmann::json::value_t::array:
+                    start_container(current->is_object());
+                    open.push_back({current, current->cbegin()});
+                    break;
+                case nlohmann::json::value_t::string:
+                    write_string(current->get_ref<const std::string&>());
+                    break;
+                default:
+                    write_scalar(*current);
+                    break;
+            }
+            
+            // Close finished containers, then move on to the next child
+            while (!open.empty() && open.back().next == open.back().container->cend()) {
+                end_container();
+                open.pop_back();
+            }
+            if (open.empty()) {
+                return;
+            }
+            Position& position = open.back();
+            if (position.container->is_object()) {
+                pending_key_ = position.next.key();
+            }
+            current = &*position.next;
+            ++position.next;
+        }
+    }
+    
+    void StreamRenderer::finish() {
+        writer_.flush();
+    }
+    
+    bool StreamRenderer::null() {
+        return write_scalar(nullptr);
+    }
+    
+    bool StreamRenderer::boolean(bool value) {
+        return write_scalar(value);
+    }
+    
+    bool StreamRenderer::number_integer(nlohmann::json::number_integer_t value) {
+        return write_scalar(value);
+    }
+    
+    bool StreamRenderer::number_unsigned(nlohmann::json::number_unsigned_t value) {
+        return write_scalar(value);
+    }
+    
+    bool StreamRenderer::number_float(nlohmann::json::number_float_t value, const std::string&) {
+        // Written as dump() formats the parsed number, not as spelled in the template
+        return write_scalar(value);
+    }
+    
+#if PERMUTO_NLOHMANN_AT_LEAST(3, 8)
+    bool StreamRenderer::binary(nlohmann::json::binary_t& value) {
+        return write_scalar(nlohmann::json::binary(std::move(value)));
+    }
+#endif
+    
+    bool StreamRenderer::string(std::string& value) {
+        return write_string(value);
+    }
+    
+    bool StreamRenderer::write_string(const std::string& value) {
+        auto exact_path = parser_.extract_exact_placeholder(value);
+        if (exact_path) {
+            const bool remove_missing = options_.missing_key_behavior == MissingKeyBehavior::Remove;
+            if (remove_missing && frames_.empty()) {
+                throw std::invalid_argument("Remove mode cannot be used with root-level placeholders");
+            }
+            
+            // Remove mode decides on removal before the depth check, like TemplateProcessor
+            if (!remove_missing) {
+                check_depth();
+            }
+            
+            const nlohmann::json* resolved = lookup(*exact_path);
+            if (resolved) {
+                check_depth();
+                begin_value();
+                writer_.value(*resolved);
+                return true;
+            }
+            
+            if (remove_missing) {
+                return true;
+            }
+            if (options_.missing_key_behavior == MissingKeyBehavior::Error) {
+                throw MissingKeyException("Missing key in context", *exact_path);
+            }
+            
+            // Leave the placeholder as-is
+            begin_value();
+            writer_.string_buffer() = value;
+            writer_.string_value();
+            return true;
+        }
+        
+        check_depth();
+        begin_value();
+        
+        std::string& out = writer_.string_buffer();
+        if (!options_.enable_interpolation) {
+            out = value;
+        } else {
+            parser_.append_replaced(value, out, [&](std::string_view path, std::string& text) {
+                const nlohmann::json* resolved = lookup(path);
+                if (resolved) {
+                    append_json_string(text, *resolved, &ctx_.dump_cache);
+                } else if (options_.missing_key_behavior == MissingKeyBehavior::Error) {
+                    throw MissingKeyException("Missing key in context", std::string(path));
+                } else {
+                    // Keep the original placeholder
+                    text += options_.start_marker;
+                    text += path;
+                    text += options_.end_marker;
+                }
+            });
+        }
+        writer_.string_value();
+        return true;
+    }
+    
+    bool StreamRenderer::start_object(size_t) {
+        return start_container(true);
+    }
+    
+    bool StreamRenderer::key(std::string& key) {
+        pending_key_ = key;
+        return true;
+    }
+    
+    bool StreamRenderer::end_object() {
+        return end_container();
+    }
+    
+    bool StreamRenderer::start_array(size_t) {
+        return start_container(false);
+    }
+    
+    bool StreamRenderer::end_array() {
+        return end_container();
+    }
+    
+    void StreamRenderer::check_depth() const {
+        if (depth() >= options_.max_recursion_depth) {
+            throw RecursionLimitException("Maximum recursion depth exceeded", depth());
+        }
+    }
+    
+    void StreamRenderer::begin_value() {
+        if (frames_.empty()) {
+            return;
+        }
+        Frame& frame = frames_.back();
+        writer_.element(frame.is_object ? '{' : '[', frame.empty);
+        frame.empty = false;
+        if (frame.is_object) {
+            writer_.key(pending_key_);
+        }
+    }
+    
+    bool StreamRenderer::write_scalar(const nlohmann::json& value) {
+        check_depth();
+        begin_value();
+        writer_.value(value);
+        return true;
+    }
+    
+    bool StreamRenderer::start_container(bool is_object) {
+        check_depth();
+        begin_value();
+        frames_.push_back(Frame{is_object, true});
+        return true;
+    }
+    
+    bool StreamRenderer::end_container() {
+        Frame frame = frames_.back();
+        frames_.pop_back();
+        writer_.end_container(frame.is_object ? '{' : '[', frame.is_object ? '}' : ']', frame.empty);
+        return true;
+    }
+    
+    const nlohmann::json* StreamRenderer::lookup(std::string_view path) {
+        try {
+            if (options_.recursive_expansion) {
+                // Expansion memoizes by path, for the whole call
+                return processor_.resolve(*intern_pointer(path), context_, ctx_);
+            }
+            
+            path_key_.assign(path.data(), path.size());
+            auto it = pointers_.find(path_key_);
+            if (it == pointers_.end()) {
+                if (pointers_.size() >= POINTER_CACHE_LIMIT) {
+                    pointers_.clear();
+                }
+                it = pointers_.emplace(path_key_, JsonPointer(path_key_)).first;
+            }
+            return it->second.find(context_);
+        } catch (const std::invalid_argument&) {
+            // Not a valid JSON Pointer, so it cannot be found
+            return nullptr;
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../include/permuto/permuto.hpp"
+#include "formats.hpp"
+#include "json_pointer.hpp"
+#include "json_writer.hpp"
+#include "placeholder_parser.hpp"
+#include "template_processor.hpp"
+
+namespace permuto {
+    // SAX handler that substitutes placeholders in template events as they
+    // arrive and writes the result through a JsonWriter
+    // render() drives it from a parsed template with render_value().
+    //
+    // Keeps one frame per open container and the key of the member being
+    // read; nothing else of the template is retained. A member's key is only
+    // written once its value is known, so Remove mode can drop the member.
+    // Depth and missing-key rules match CompiledTemplate.
+    class StreamRenderer {
+    public:
+        StreamRenderer(const nlohmann::json& context, const Options& options,
+                       Sink& sink, int indent);
+        
+        // Feed a whole template value, as the parser would report it
+        void render_value(const nlohmann::json& value);
+        
+        // Flush output once the whole template has been read
+        void finish();
+        
+        // nlohmann::json_sax interface; binary() is part of it from 3.8 on
+        bool null();
+        bool boolean(bool value);
+        bool number_integer(nlohmann::json::number_integer_t value);
+        bool number_unsigned(nlohmann::json::number_unsigned_t value);
+        bool number_float(nlohmann::json::number_float_t value, const std::string& text);
+        bool string(std::string& value);
+#if PERMUTO_NLOHMANN_AT_LEAST(3, 8)
+        bool binary(nlohmann::json::binary_t& value);
+#endif
+        bool start_object(size_t elements);
+        bool key(std::string& key);
+        bool end_object();
+        bool start_array(size_t elements);
+        bool end_array();
+        
+        // Rethrown as the concrete nlohmann exception, like json::parse()
+        template <typename Exception>
+        bool parse_error(size_t, const std::string&, const Exception& error) {
+            throw error;
+        }
+    
+    private:
+        struct Frame {
+            bool is_object = false;
+            bool empty = true;
+        };
+        
+        // Depth of the value about to be read
+        size_t depth() const { return frames_.size(); }
+        
+        void check_depth() const;
+        
+        // Separator, and key inside objects, before the next value
+        void begin_value();
+        
+        bool write_scalar(const nlohmann::json& value);
+        bool write_string(const std::string& value);
+        bool start_container(bool is_object);
+        bool end_container();
+        
+        // Resolved value of a placeholder path, or nullptr if missing
+        const nlohmann::json* lookup(std::string_view path);
+        
+        const nlohmann::json& context_;
+        const Options& options_;
+        const TemplateProcessor processor_;  // Expands resolved values in recursive_expansion mode
+        const PlaceholderParser parser_;
+        JsonWriter writer_;
+        ProcessingContext ctx_;
+        
+        std::vector<Frame> frames_;
+        std::string pending_key_;
+        
+        // Parsed pointers of recent paths; cleared when it reaches its limit
+        // so that templates with many distinct paths stay in bounded memory
+        std::unordered_map<std::string, JsonPointer> pointers_;
+        std::string path_key_;
+    };
+}
@@ -0,0 +1,934 @@
+#include "template_artifact.hpp"
+#include "placeholder_parser.hpp"
+#include "value_formatter.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace permuto {
+    namespace artifact {
+        static_assert(std::is_trivially_copyable<Header>::value && sizeof(Header) % 8 == 0,
+                      "Header must be copyable as bytes and keep sections aligned");
+        static_assert(std::is_trivially_copyable<NodeRecord>::value &&
+                      std::is_trivially_copyable<SlotRecord>::value &&
+                      std::is_trivially_copyable<SegmentRecord>::value &&
+                      std::is_trivially_copyable<PointerRecord>::value &&
+                      std::is_trivially_copyable<TokenRecord>::value,
+                      "Records must be copyable as bytes");
+        
+        namespace {
+            const size_t SECTION_ALIGNMENT = 8;
+            const std::uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+            const std::uint64_t FNV_PRIME = 1099511628211ull;
+            
+            size_t align(size_t offset) {
+                return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+            }
+            
+            std::uint32_t to_u32(size_t value) {
+                if (value > std::numeric_limits<std::uint32_t>::max()) {
+                    throw std::length_error("Template is too large for an artifact");
+                }
+                return static_cast<std::uint32_t>(value);
+            }
+            
+            // Flattens a template into records, parsing each string once
+            class Builder {
+            public:
+                explicit Builder(const Options& options)
+                    : options_(options), parser_(options.start_marker, options.end_marker) {}
+                
+                std::string build(const nlohmann::json& template_json);
+            
+            private:
+                std::uint32_t add_node(const nlohmann::json& value, std::uint32_t depth);
+                void add_string_node(const std::string& str, NodeRecord& node);
+                std::uint32_t add_pointer(const std::string& path);
+                StringRef add_string(std::string_view text);
+                
+                template <typename Record>
+                Section place(size_t& offset, const std::vector<Record>& records) const;
+                
+                const Options& options_;
+                const PlaceholderParser parser_;
+                
+                std::vector<NodeRecord> nodes_;
+                std::vector<SlotRecord> slots_;
+                std::vector<SegmentRecord> segments_;
+                std::vector<PointerRecord> pointers_;
+                std::vector<TokenRecord> tokens_;
+                std::string strings_;
+                
+                // Every distinct string and path is stored once
+                std::unordered_map<std::string, std::uint32_t> string_offsets_;
+                std::unordered_map<std::string, std::uint32_t> pointer_indices_;
+            };
+            
+            std::string Builder::build(const nlohmann::json& template_json) {
+                Header header{};
+                std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+                header.version = FORMAT_VERSION;
+                header.byte_order = BYTE_ORDER_MARK;
+                header.flags = (options_.enable_interpolation ? FLAG_INTERPOLATION : 0) |
+                               (options_.recursive_expansion ? FLAG_RECURSIVE_EXPANSION : 0);
+                header.missing_key_behavior = static_cast<std::uint32_t>(options_.missing_key_behavior);
+                header.max_recursion_depth = options_.max_recursion_depth;
+                header.start_marker = add_string(options_.start_marker);
+                header.end_marker = add_string(options_.end_marker);
+                header.root = add_node(template_json, 0);
+                
+                // Validate root-level Remove mode
+                if (options_.missing_key_behavior == MissingKeyBehavior::Remove &&
+                    nodes_[header.root].type == NodeType::ExactPlaceholder) {
+                    throw std::invalid_argument("Remove mode cannot be used with root-level placeholders");
+                }
+                
+                size_t size = sizeof(Header);
+                header.nodes = place(size, nodes_);
+                header.slots = place(size, slots_);
+                header.segments = place(size, segments_);
+                header.pointers = place(size, pointers_);
+                header.tokens = place(size, tokens_);
+                header.strings = {to_u32(size), to_u32(strings_.size())};
+                size = align(size + strings_.size());
+                header.file_size = size;
+                
+                std::string out(size, '\0');
+                auto copy = [&out](Section section, const void* records, size_t bytes) {
+                    if (bytes > 0) {
+                        std::memcpy(&out[section.offset], records, bytes);
+                    }
+                };
+                copy(header.nodes, nodes_.data(), nodes_.size() * sizeof(NodeRecord));
+                copy(header.slots, slots_.data(), slots_.size() * sizeof(SlotRecord));
+                copy(header.segments, segments_.data(), segments_.size() * sizeof(SegmentRecord));
+                copy(header.pointers, pointers_.data(), pointers_.size() * sizeof(PointerRecord));
+                copy(header.tokens, tokens_.data(), tokens_.size() * sizeof(TokenRecord));
+                copy(header.strings, strings_.data(), strings_.size());
+                
+                std::memcpy(&out[0], &header, sizeof(Header));
+                header.checksum = checksum(out.data(), out.size());
+                std::memcpy(&out[offsetof(Header, checksum)], &header.checksum, sizeof(header.checksum));
+                return out;
+            }
+            
+            std::uint32_t Builder::add_node(const nlohmann::json& value, std::uint32_t depth) {
+                // Nodes are numbered in pre-order; the record is filled in
+                // once the children have been added
+                std::uint32_t index = to_u32(nodes_.size());
+                nodes_.emplace_back();
+                
+                NodeRecord node{};
+                node.depth = depth;
+                
+                switch (value.type()) {
+                    case nlohmann::json::value_t::null:
+                        node.type = NodeType::Null;
+                        break;
+                    case nlohmann::json::value_t::boolean:
+                        node.type = NodeType::Boolean;
+                        node.scalar = value.get<bool>() ? 1 : 0;
+                        break;
+                    case nlohmann::json::value_t::number_integer: {
+                        node.type = NodeType::Integer;
+                        auto number = value.get<std::int64_t>();
+                        std::memcpy(&node.scalar, &number, sizeof(number));
+                        break;
+                    }
+                    case nlohmann::json::value_t::number_unsigned:
+                        node.type = NodeType::Unsigned;
+                        node.scalar = value.get<std::uint64_t>();
+                        break;
+                    case nlohmann::json::value_t::number_float: {
+                        node.type = NodeType::Float;
+                        auto number = value.get<double>();
+                        std::memcpy(&node.scalar, &number, sizeof(number));
+                        break;
+                    }
+                    case nlohmann::json::value_t::string:
+                        add_string_node(value.get_ref<const std::string&>(), node);
+                        break;
+                    case nlohmann::json::value_t::object:
+                    case nlohmann::json::value_t::array: {
+                        const bool is_object = value.is_object();
+                        node.type = is_object ? NodeType::Object : NodeType::Array;
+                        // Applying throws on reaching this node, so its children
+                        // are left out; this also bounds recursion on deep input
+                        if (depth >= options_.max_recursion_depth) {
+                            break;
+                        }
+                        
+                        // Children's own slots are added while they are built,
+                        // so this container's slots are appended afterwards
+                        std::vector<SlotRecord> children;
+                        children.reserve(value.size());
+                        for (auto it = value.begin(); it != value.end(); ++it) {
+                            SlotRecord slot{};
+                            slot.node = add_node(it.value(), depth + 1);
+                            if (is_object) {
+                                slot.key = add_string(it.key());
+                                std::string quoted = quote_key(it.key());
+                                if (!quoted.empty()) {
+                                    slot.quoted_key = add_string(quoted);
+                                }
+                            }
+                            children.push_back(slot);
+                        }
+                        node.first = to_u32(slots_.size());
+                        node.count = to_u32(children.size());
+                        slots_.insert(slots_.end(), children.begin(), children.end());
+                        break;
+                    }
+                    default:
+                        throw std::invalid_argument("Binary values cannot be stored in a template artifact");
+                }
+                
+                if (node.type <= NodeType::Float) {
+                    node.text = add_string(value.dump());
+                }
+                
+                nodes_[index] = node;
+                return index;
+            }
+            
+            void Builder::add_string_node(const std::string& str, NodeRecord& node) {
+                node.text = add_string(str);
+                
+                // Check for exact-match placeholder first
+                auto exact_path = parser_.extract_exact_placeholder(str);
+                if (exact_path) {
+                    node.type = NodeType::ExactPlaceholder;
+                    node.first = add_pointer(*exact_path);
+                    return;
+                }
+                
+                std::vector<Placeholder> placeholders;
+                if (options_.enable_interpolation) {
+                    placeholders = parser_.find_placeholders(str);
+                }
+                if (placeholders.empty()) {
+                    node.type = NodeType::String;
+                    std::string quoted = quote_key(str);
+                    if (!quoted.empty()) {
+                        StringRef ref = add_string(quoted);
+                        node.first = ref.offset;
+                        node.count = ref.length;
+                    }
+                    return;
+                }
+                
+                // Split the string into literal text and placeholder segments
+                node.type = NodeType::Interpolated;
+                node.first = to_u32(segments_.size());
+                size_t last_pos = 0;
+                for (const auto& placeholder : placeholders) {
+                    if (placeholder.start_pos > last_pos) {
+                        segments_.push_back({NO_POINTER, add_string(std::string_view(str).substr(
+                            last_pos, placeholder.start_pos - last_pos))});
+                    }
+                    segments_.push_back({add_pointer(placeholder.path), add_string(std::string_view(str).substr(
+                        placeholder.start_pos, placeholder.end_pos - placeholder.start_pos))});
+                    last_pos = placeholder.end_pos;
+                }
+                if (last_pos < str.length()) {
+                    segments_.push_back({NO_POINTER, add_string(std::string_view(str).substr(last_pos))});
+                }
+                node.count = to_u32(segments_.size() - node.first);
+            }
+            
+            std::uint32_t Builder::add_pointer(const std::string& path) {
+                auto found = pointer_indices_.find(path);
+                if (found != pointer_indices_.end()) {
+                    return found->second;
+                }
+                
+                // Throws std::invalid_argument for invalid paths
+                const JsonPointer pointer(path);
+                
+                PointerRecord record{};
+                record.path = add_string(path);
+                record.first_token = to_u32(tokens_.size());
+                record.token_count = to_u32(pointer.tokens().size());
+                for (size_t i = 0; i < pointer.tokens().size(); ++i) {
+                    tokens_.push_back({add_string(pointer.tokens()[i]),
+                                       pointer.indices()[i] == JsonPointer::NO_INDEX
+                                           ? std::numeric_limits<std::uint64_t>::max()
+                                           : static_cast<std::uint64_t>(pointer.indices()[i])});
+                }
+                
+                std::uint32_t index = to_u32(pointers_.size());
+                pointers_.push_back(record);
+                pointer_indices_.emplace(path, index);
+                return index;
+            }
+            
+            StringRef Builder::add_string(std::string_view text) {
+                std::uint32_t length = to_u32(text.size());
+                auto found = string_offsets_.find(std::string(text));
+                if (found != string_offsets_.end()) {
+                    return {found->second, length};
+                }
+                std::uint32_t offset = to_u32(strings_.size());
+                to_u32(strings_.size() + text.size());
+                strings_.append(text.data(), text.size());
+                string_offsets_.emplace(std::string(text), offset);
+                return {offset, length};
+            }
+            
+            // FNV-1a over 8-byte words, with the high half folded back into
+            // the low half at each step; detects corruption, not tampering
+            std::uint64_t hash_words(const char* data, size_t length, std::uint64_t hash) {
+                size_t i = 0;
+                for (; i + sizeof(std::uint64_t) <= length; i += sizeof(std::uint64_t)) {
+                    std::uint64_t word;
+                    std::memcpy(&word, data + i, sizeof(word));
+                    hash = (hash ^ word) * FNV_PRIME;
+                    hash ^= hash >> 32;
+                }
+                for (; i < length; ++i) {
+                    hash = (hash ^ static_cast<unsigned char>(data[i])) * FNV_PRIME;
+                }
+                return hash;
+            }
+            
+            template <typename Record>
+            Section Builder::place(size_t& offset, const std::vector<Record>& records) const {
+                static_assert(alignof(Record) <= SECTION_ALIGNMENT, "Record alignment");
+                Section section{to_u32(offset), to_u32(records.size())};
+                offset = align(offset + records.size() * sizeof(Record));
+                return section;
+            }
+        }
+        
+        std::uint64_t checksum(const char* data, size_t length) {
+            // The field splits the file into two parts, both starting on a word
+            static_assert(offsetof(Header, checksum) % 8 == 0, "Checksum field alignment");
+            const size_t field = offsetof(Header, checksum);
+            const size_t rest = field + sizeof(std::uint64_t);
+            std::uint64_t hash = hash_words(data, field, FNV_OFFSET_BASIS);
+            return hash_words(data + rest, length - rest, hash);
+        }
+        
+        std::string serialize(const nlohmann::json& template_json, const Options& options) {
+            options.validate();
+            if (options.engine == ProcessingEngine::Iterative) {
+                throw std::invalid_argument("The iterative engine cannot be used with compiled templates");
+            }
+            Builder builder(options);
+            return builder.build(template_json);
+        }
+    }
+    
+    namespace {
+        using namespace artifact;
+        
+        InvalidTemplateException invalid_artifact(const std::string& reason) {
+            return InvalidTemplateException("Invalid template artifact: " + reason);
+        }
+        
+        // Records of a section, after checking that they lie within data
+        template <typename Record>
+        const Record* locate(std::string_view data, Section section, const char* name) {
+            std::uint64_t end = static_cast<std::uint64_t>(section.offset) +
+                                static_cast<std::uint64_t>(section.count) * sizeof(Record);
+            if (section.offset < sizeof(Header) || section.offset % alignof(Record) != 0 ||
+                end > data.size()) {
+                throw invalid_artifact(std::string("bad ") + name + " section");
+            }
+            return reinterpret_cast<const Record*>(data.data() + section.offset);
+        }
+        
+        bool in_range(std::uint32_t first, std::uint32_t count, std::uint32_t size) {
+            return static_cast<std::uint64_t>(first) + count <= size;
+        }
+        
+        const std::uint32_t NO_LITERAL = std::numeric_limits<std::uint32_t>::max();
+    }
+    
+    TemplateArtifact::Impl::Impl(std::string_view data, void* mapping, std::vector<std::uint64_t> owned)
+        : data_(data), mapping_(mapping), owned_(std::move(owned)) {
+        try {
+            load();
+        } catch (...) {
+            release_mapping();
+            throw;
+        }
+    }
+    
+    TemplateArtifact::Impl::~Impl() {
+        release_mapping();
+    }
+    
+    void TemplateArtifact::Impl::release_mapping() {
+#if !defined(_WIN32)
+        if (mapping_ != nullptr) {
+            ::munmap(mapping_, data_.size());
+            mapping_ = nullptr;
+        }
+#endif
+    }
+    
+    void TemplateArtifact::Impl::load() {
+        if (data_.size() < sizeof(Header)) {
+            throw invalid_artifact("truncated");
+        }
+        header_ = reinterpret_cast<const Header*>(data_.data());
+        if (std::memcmp(header_->magic, MAGIC, sizeof(MAGIC)) != 0) {
+            throw invalid_artifact("not a template artifact");
+        }
+        if (header_->version != FORMAT_VERSION) {
+            throw invalid_artifact("unsupported version " + std::to_string(header_->version));
+        }
+        if (header_->byte_order != BYTE_ORDER_MARK) {
+            throw invalid_artifact("written on a machine with a different byte order");
+        }
+        if (header_->file_size != data_.size()) {
+            throw invalid_artifact("size does not match its header");
+        }
+        if (header_->checksum != checksum(data_.data(), data_.size())) {
+            throw invalid_artifact("checksum mismatch");
+        }
+        
+        nodes_ = locate<NodeRecord>(data_, header_->nodes, "nodes");
+        slots_ = locate<SlotRecord>(data_, header_->slots, "slots");
+        segments_ = locate<SegmentRecord>(data_, header_->segments, "segments");
+        pointers_ = locate<PointerRecord>(data_, header_->pointers, "pointers");
+        tokens_ = locate<TokenRecord>(data_, header_->tokens, "tokens");
+        strings_ = locate<char>(data_, header_->strings, "strings");
+        
+        // Options
+        if ((header_->flags & ~(FLAG_INTERPOLATION | FLAG_RECURSIVE_EXPANSION)) != 0 ||
+            header_->missing_key_behavior > static_cast<std::uint32_t>(MissingKeyBehavior::Remove) ||
+            header_->max_recursion_depth > std::numeric_limits<size_t>::max()) {
+            throw invalid_artifact("bad options");
+        }
+        check_string(header_->start_marker);
+        check_string(header_->end_marker);
+        options_.start_marker = std::string(text(header_->start_marker));
+        options_.end_marker = std::string(text(header_->end_marker));
+        options_.enable_interpolation = (header_->flags & FLAG_INTERPOLATION) != 0;
+        options_.recursive_expansion = (header_->flags & FLAG_RECURSIVE_EXPANSION) != 0;
+        options_.missing_key_behavior = static_cast<MissingKeyBehavior>(header_->missing_key_behavior);
+        options_.max_recursion_depth = static_cast<size_t>(header_->max_recursion_depth);
+        try {
+            options_.validate();
+        } catch (const std::invalid_argument& error) {
+            throw invalid_artifact(error.what());
+        }
+        
+        for (std::uint32_t i = 0; i < header_->tokens.count; ++i) {
+            check_string(tokens_[i].text);
+        }
+        for (std::uint32_t i = 0; i < header_->pointers.count; ++i) {
+            check_string(pointers_[i].path);
+            if (!in_range(pointers_[i].first_token, pointers_[i].token_count, header_->tokens.count)) {
+                throw invalid_artifact("bad pointer");
+            }
+        }
+        for (std::uint32_t i = 0; i < header_->segments.count; ++i) {
+            check_string(segments_[i].text);
+            if (segments_[i].pointer != NO_POINTER && segments_[i].pointer >= header_->pointers.count) {
+                throw invalid_artifact("bad segment");
+            }
+        }
+        check_nodes();
+        
+        if (options_.missing_key_behavior == MissingKeyBehavior::Remove &&
+            nodes_[header_->root].type == NodeType::ExactPlaceholder) {
+            throw invalid_artifact("Remove mode cannot be used with root-level placeholders");
+        }
+        
+        // Expansion goes through TemplateProcessor, which works on parsed
+        // pointers; only this mode parses the paths again. They are owned here
+        // rather than interned, so loading artifacts never grows the pointer table.
+        if (options_.recursive_expansion) {
+            processor_ = std::make_unique<const TemplateProcessor>(options_);
+            parsed_pointers_.reserve(header_->pointers.count);
+            for (std::uint32_t i = 0; i < header_->pointers.count; ++i) {
+                try {
+                    parsed_pointers_.emplace_back(std::string(text(pointers_[i].path)));
+                } catch (const std::invalid_argument& error) {
+                    throw invalid_artifact(error.what());
+                }
+            }
+        }
+    }
+    
+    void TemplateArtifact::Impl::check_string(StringRef ref) const {
+        if (!in_range(ref.offset, ref.length, header_->strings.count)) {
+            throw invalid_artifact("bad string reference");
+        }
+    }
+    
+    void TemplateArtifact::Impl::check_nodes() const {
+        const std::uint32_t count = header_->nodes.count;
+        if (header_->root >= count || nodes_[header_->root].depth != 0) {
+            throw invalid_artifact("bad root");
+        }
+        
+        // Each node has at most one parent, one level above it, so the nodes
+        // form a tree and recursion over them terminates
+        std::vector<bool> referenced(count, false);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            const NodeRecord& node = nodes_[i];
+            check_string(node.text);
+            switch (node.type) {
+                case NodeType::Null:
+                case NodeType::Boolean:
+                case NodeType::Integer:
+                case NodeType::Unsigned:
+                case NodeType::Float:
+                    break;
+                case NodeType::String:
+                    if (node.count != 0) {
+                        check_string({node.first, node.count});
+                    }
+                    break;
+                case NodeType::Object:
+                case NodeType::Array:
+                    if (!in_range(node.first, node.count, header_->slots.count)) {
+                        throw invalid_artifact("bad container");
+                    }
+                    for (std::uint32_t s = node.first; s < node.first + node.count; ++s) {
+                        const SlotRecord& slot = slots_[s];
+                        if (slot.node >= count || referenced[slot.node] ||
+                            nodes_[slot.node].depth != static_cast<std::uint64_t>(node.depth) + 1) {
+                            throw invalid_artifact("bad container");
+                        }
+                        referenced[slot.node] = true;
+                        check_string(slot.key);
+                        check_string(slot.quoted_key);
+                    }
+                    break;
+                case NodeType::ExactPlaceholder:
+                    if (node.first >= header_->pointers.count) {
+                        throw invalid_artifact("bad placeholder");
+                    }
+                    break;
+                case NodeType::Interpolated:
+                    if (!in_range(node.first, node.count, header_->segments.count)) {
+                        throw invalid_artifact("bad placeholder");
+                    }
+                    break;
+                default:
+                    throw invalid_artifact("unknown node type");
+            }
+        }
+        if (referenced[header_->root]) {
+            throw invalid_artifact("bad root");
+        }
+    }
+    
+    nlohmann::json TemplateArtifact::Impl::apply(const nlohmann::json& context) const {
+        std::call_once(literals_built_, [this] {
+            literal_index_.assign(header_->nodes.count, NO_LITERAL);
+            nlohmann::json root;
+            collect_literals(header_->root, root);
+        });
+        
+        nlohmann::json result;
+        ProcessingContext ctx;
+        apply_node(header_->root, context, result, ctx);
+        return result;
+    }
+    
+    void TemplateArtifact::Impl::render(const nlohmann::json& context, Sink& sink, int indent) const {
+        ProcessingContext ctx;
+        JsonWriter writer(sink, indent);
+        render_node(nodes_[header_->root], context, writer, ctx);
+        writer.flush();
+    }
+    
+    bool TemplateArtifact::Impl::apply_node(std::uint32_t index,
+                                            const nlohmann::json& context,
+                                            nlohmann::json& out,
+                                            ProcessingContext& ctx) const {
+        const NodeRecord& node = nodes_[index];
+        if (node.type == NodeType::ExactPlaceholder) {
+            bool unresolved = false;
+            const nlohmann::json* value = resolve_exact(node, context, ctx, unresolved);
+            if (value) {
+                out = *value;
+            } else if (unresolved) {
+                out = std::string(text(node.text));
+            }
+            return value || unresolved;
+        }
+        
+        // Checked for every node it holds when it was collected
+        if (literal_index_[index] != NO_LITERAL) {
+            out = literals_[literal_index_[index]];
+            return true;
+        }
+        
+        check_depth(node);
+        
+        switch (node.type) {
+            case NodeType::Interpolated:
+                out = std::string();
+                append_interpolated(node, context, ctx, out.get_ref<std::string&>());
+                break;
+            case NodeType::Object:
+                out = nlohmann::json::object();
+                for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    nlohmann::json value;
+                    if (apply_node(slots_[i].node, context, value, ctx)) {
+                        out[std::string(text(slots_[i].key))] = std::move(value);
+                    }
+                }
+                break;
+            case NodeType::Array:
+                out = nlohmann::json::array();
+                for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    nlohmann::json value;
+                    if (apply_node(slots_[i].node, context, value, ctx)) {
+                        out.push_back(std::move(value));
+                    }
+                }
+                break;
+            default:
+                out = scalar_value(node);
+                break;
+        }
+        
+        return true;
+    }
+    
+    nlohmann::json TemplateArtifact::Impl::scalar_value(const NodeRecord& node) const {
+        switch (node.type) {
+            case NodeType::Boolean:
+                return node.scalar != 0;
+            case NodeType::Integer: {
+                std::int64_t number;
+                std::memcpy(&number, &node.scalar, sizeof(number));
+                return number;
+            }
+            case NodeType::Unsigned:
+                return node.scalar;
+            case NodeType::Float: {
+                double number;
+                std::memcpy(&number, &node.scalar, sizeof(number));
+                return number;
+            }
+            case NodeType::String:
+                return std::string(text(node.text));
+            default:
+                return nullptr;
+        }
+    }
+    
+    bool TemplateArtifact::Impl::collect_literals(std::uint32_t index, nlohmann::json& literal) const {
+        const NodeRecord& node = nodes_[index];
+        // apply_node throws for these nodes, so they are never collapsed
+        if (node.depth >= options_.max_recursion_depth) {
+            return false;
+        }
+        
+        switch (node.type) {
+            case NodeType::ExactPlaceholder:
+            case NodeType::Interpolated:
+                return false;
+            case NodeType::Object:
+            case NodeType::Array: {
+                // Children first, so their values are moved up rather than copied
+                std::vector<nlohmann::json> values(node.count);
+                bool all_literal = true;
+                for (std::uint32_t i = 0; i < node.count; ++i) {
+                    all_literal = collect_literals(slots_[node.first + i].node, values[i]) && all_literal;
+                }
+                if (!all_literal) {
+                    // Keep the literal containers among the children
+                    for (std::uint32_t i = 0; i < node.count; ++i) {
+                        std::uint32_t child = slots_[node.first + i].node;
+                        if (values[i].is_structured()) {
+                            literal_index_[child] = static_cast<std::uint32_t>(literals_.size());
+                            literals_.push_back(std::move(values[i]));
+                        }
+                    }
+                    return false;
+                }
+                
+                if (node.type == NodeType::Object) {
+                    literal = nlohmann::json::object();
+                    for (std::uint32_t i = 0; i < node.count; ++i) {
+                        literal[std::string(text(slots_[node.first + i].key))] = std::move(values[i]);
+                    }
+                } else {
+                    literal = nlohmann::json::array();
+                    literal.get_ref<nlohmann::json::array_t&>().reserve(node.count);
+                    for (auto& value : values) {
+                        literal.push_back(std::move(value));
+                    }
+                }
+                if (index == header_->root) {
+                    literal_index_[index] = static_cast<std::uint32_t>(literals_.size());
+                    literals_.push_back(std::move(literal));
+                }
+                return true;
+            }
+            default:
+                literal = scalar_value(node);
+                return true;
+        }
+    }
+    
+    const nlohmann::json* TemplateArtifact::Impl::resolve_exact(const NodeRecord& node,
+                                                                const nlohmann::json& context,
+                                                                ProcessingContext& ctx,
+                                                                bool& unresolved) const {
+        // Remove mode decides on removal before the depth check, like TemplateProcessor
+        const bool remove_missing = options_.missing_key_behavior == MissingKeyBehavior::Remove;
+        if (!remove_missing) {
+            check_depth(node);
+        }
+        
+        const nlohmann::json* resolved = lookup(node.first, context, ctx);
+        if (resolved) {
+            check_depth(node);
+            return resolved;
+        }
+        
+        if (options_.missing_key_behavior == MissingKeyBehavior::Error) {
+            missing_key(node.first);
+        }
+        
+        // Leave the placeholder as-is unless it is removed
+        unresolved = !remove_missing;
+        return nullptr;
+    }
+    
+    void TemplateArtifact::Impl::append_interpolated(const NodeRecord& node,
+                                                     const nlohmann::json& context,
+                                                     ProcessingContext& ctx,
+                                                     std::string& result) const {
+        // The template string is usually a good estimate of the result size
+        result.reserve(result.size() + node.text.length);
+        
+        for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+            const SegmentRecord& segment = segments_[i];
+            if (segment.pointer == NO_POINTER) {
+                result += text(segment.text);
+                continue;
+            }
+            
+            const nlohmann::json* resolved = lookup(segment.pointer, context, ctx);
+            if (resolved) {
+                append_json_string(result, *resolved, &ctx.dump_cache);
+            } else if (options_.missing_key_behavior == MissingKeyBehavior::Error) {
+                missing_key(segment.pointer);
+            } else {
+                // Keep the original placeholder
+                result += text(segment.text);
+            }
+        }
+    }
+    
+    void TemplateArtifact::Impl::render_node(const NodeRecord& node,
+                                             const nlohmann::json& context,
+                                             JsonWriter& writer,
+                                             ProcessingContext& ctx) const {
+        if (node.type == NodeType::ExactPlaceholder) {
+            // Only reached for the root, which Remove mode cannot drop
+            bool unresolved = false;
+            const nlohmann::json* value = resolve_exact(node, context, ctx, unresolved);
+            if (value) {
+                writer.value(*value);
+            } else {
+                writer.string_buffer() = text(node.text);
+                writer.string_value();
+            }
+            return;
+        }
+        
+        check_depth(node);
+        
+        switch (node.type) {
+            case NodeType::String:
+                if (node.count != 0) {
+                    writer.raw_value(text({node.first, node.count}));
+                } else {
+                    // Not valid UTF-8; the writer raises the same error dump() does
+                    writer.string_buffer() = text(node.text);
+                    writer.string_value();
+                }
+                break;
+            case NodeType::Interpolated:
+                append_interpolated(node, context, ctx, writer.string_buffer());
+                writer.string_value();
+                break;
+            case NodeType::Object:
+            case NodeType::Array: {
+                const bool is_object = node.type == NodeType::Object;
+                const char open_bracket = is_object ? '{' : '[';
+                bool empty = true;
+                for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    const SlotRecord& slot = slots_[i];
+                    const NodeRecord& child = nodes_[slot.node];
+                    
+                    // Removal has to be known before the separator is written
+                    const nlohmann::json* exact = nullptr;
+                    bool unresolved = false;
+                    if (child.type == NodeType::ExactPlaceholder) {
+                        exact = resolve_exact(child, context, ctx, unresolved);
+                        if (!exact && !unresolved) {
+                            continue;
+                        }
+                    }
+                    
+                    writer.element(open_bracket, empty);
+                    empty = false;
+                    if (is_object) {
+                        writer.key(text(slot.quoted_key), text(slot.key));
+                    }
+                    if (exact) {
+                        writer.value(*exact);
+                    } else if (unresolved) {
+                        writer.string_buffer() = text(child.text);
+                        writer.string_value();
+                    } else {
+                        render_node(child, context, writer, ctx);
+                    }
+                }
+                writer.end_container(open_bracket, is_object ? '}' : ']', empty);
+                break;
+            }
+            default:
+                // Scalars are stored as dump() writes them
+                writer.raw_value(text(node.text));
+                break;
+        }
+    }
+    
+    const nlohmann::json* TemplateArtifact::Impl::lookup(std::uint32_t pointer,
+                                                         const nlohmann::json& context,
+                                                         ProcessingContext& ctx) const {
+        if (options_.recursive_expansion) {
+            return processor_->resolve(parsed_pointers_[pointer], context, ctx);
+        }
+        
+        // Same walk as JsonPointer::find, over the stored tokens
+        const PointerRecord& record = pointers_[pointer];
+        const nlohmann::json* current = &context;
+        for (std::uint32_t i = record.first_token; i < record.first_token + record.token_count; ++i) {
+            const TokenRecord& token = tokens_[i];
+            if (current->is_object()) {
+                auto it = current->find(text(token.text));
+                if (it == current->end()) {
+                    return nullptr;
+                }
+                current = &(*it);
+            } else if (current->is_array()) {
+                // Tokens that are not indices are stored as the largest index
+                if (token.index >= current->size()) {
+                    return nullptr;
+                }
+                current = &(*current)[static_cast<size_t>(token.index)];
+            } else {
+                // Can't traverse further
+                return nullptr;
+            }
+        }
+        return current;
+    }
+    
+    void TemplateArtifact::Impl::missing_key(std::uint32_t pointer) const {
+        throw MissingKeyException("Missing key in context", std::string(text(pointers_[pointer].path)));
+    }
+    
+    void TemplateArtifact::Impl::check_depth(const NodeRecord& node) const {
+        if (node.depth >= options_.max_recursion_depth) {
+            throw RecursionLimitException("Maximum recursion depth exceeded", node.depth);
+        }
+    }
+    
+    // Public wrapper
+    
+    TemplateArtifact::TemplateArtifact(std::shared_ptr<const Impl> impl) : impl_(std::move(impl)) {}
+    
+    std::string TemplateArtifact::serialize(const nlohmann::json& template_json, const Options& options) {
+        return artifact::serialize(template_json, options);
+    }
+    
+    TemplateArtifact TemplateArtifact::open(const std::string& path) {
+#if defined(_WIN32)
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        size_t size = static_cast<size_t>(file.tellg());
+        std::vector<std::uint64_t> owned((size + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t));
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char*>(owned.data()), static_cast<std::streamsize>(size))) {
+            throw std::runtime_error("Cannot read file: " + path);
+        }
+        std::string_view data(reinterpret_cast<const char*>(owned.data()), size);
+        return TemplateArtifact(std::make_shared<const Impl>(data, nullptr, std::move(owned)));
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open file: " + path + " (" + std::strerror(errno) + ")");
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::runtime_error("Cannot read file: " + path + " (" + std::strerror(error) + ")");
+        }
+        size_t size = static_cast<size_t>(info.st_size);
+        if (size < sizeof(Header)) {
+            ::close(fd);
+            throw invalid_artifact("truncated");
+        }
+        
+        // Shared and read-only: every process applying the file uses the
+        // same pages of the page cache
+        void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        int error = errno;
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error("Cannot map file: " + path + " (" + std::strerror(error) + ")");
+        }
+        std::string_view data(static_cast<const char*>(mapping), size);
+        return TemplateArtifact(std::make_shared<const Impl>(data, mapping, std::vector<std::uint64_t>()));
+#endif
+    }
+    
+    TemplateArtifact TemplateArtifact::view(std::string_view data) {
+        if (reinterpret_cast<std::uintptr_t>(data.data()) % SECTION_ALIGNMENT == 0) {
+            return TemplateArtifact(std::make_shared<const Impl>(data, nullptr, std::vector<std::uint64_t>()));
+        }
+        
+        // Records are read in place, so they have to be aligned
+        std::vector<std::uint64_t> owned((data.size() + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t));
+        if (!data.empty()) {
+            std::memcpy(owned.data(), data.data(), data.size());
+        }
+        std::string_view copy(reinterpret_cast<const char*>(owned.data()), data.size());
+        return TemplateArtifact(std::make_shared<const Impl>(copy, nullptr, std::move(owned)));
+    }
+    
+    nlohmann::json TemplateArtifact::apply(const nlohmann::json& context) const {
+        return impl_->apply(context);
+    }
+    
+    void TemplateArtifact::render(const nlohmann::json& context, Sink& sink, int indent) const {
+        impl_->render(context, sink, indent);
+    }
+    
+    const Options& TemplateArtifact::options() const {
+        return impl_->options();
+    }
+}
@@ -0,0 +1,206 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../include/permuto/permuto.hpp"
+#include "json_pointer.hpp"
+#include "json_writer.hpp"
+#include "template_processor.hpp"
+
+namespace permuto {
+    // On-disk layout of a TemplateArtifact
+    //
+    // A header followed by sections of fixed-size records and a string pool.
+    // Records refer to each other by index and to text by offset into the
+    // pool, so the file is used exactly as it is mapped. Every section starts
+    // on an 8-byte boundary. Integers are in the byte order of the machine
+    // that wrote the file, recorded in byte_order.
+    namespace artifact {
+        const char MAGIC[8] = {'P', 'E', 'R', 'M', 'U', 'T', 'O', '\x1a'};
+        const std::uint32_t FORMAT_VERSION = 1;
+        const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+        const std::uint32_t NO_POINTER = 0xffffffff;
+        const std::uint32_t FLAG_INTERPOLATION = 1u << 0;
+        const std::uint32_t FLAG_RECURSIVE_EXPANSION = 1u << 1;
+        
+        enum class NodeType : std::uint32_t {
+            Null,
+            Boolean,
+            Integer,
+            Unsigned,
+            Float,
+            String,
+            Object,
+            Array,
+            ExactPlaceholder,
+            Interpolated
+        };
+        
+        // Text in the string pool
+        struct StringRef {
+            std::uint32_t offset;
+            std::uint32_t length;
+        };
+        
+        // Records of one kind
+        struct Section {
+            std::uint32_t offset;  // From the start of the file
+            std::uint32_t count;
+        };
+        
+        struct Header {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t byte_order;
+            std::uint64_t file_size;
+            std::uint64_t checksum;  // See checksum()
+            
+            // Options the template was compiled with
+            std::uint32_t flags;
+            std::uint32_t missing_key_behavior;
+            std::uint64_t max_recursion_depth;
+            StringRef start_marker;
+            StringRef end_marker;
+            
+            std::uint32_t root;      // Node index
+            std::uint32_t reserved;
+            Section nodes;
+            Section slots;
+            Section segments;
+            Section pointers;
+            Section tokens;
+            Section strings;         // Count is in bytes
+        };
+        
+        // Meaning of first, count, text and scalar by type:
+        // - Null, Boolean, Integer, Unsigned, Float: text is the value as
+        //   dump() writes it, scalar its bits
+        // - String: text is the string; first and count locate it as dump()
+        //   writes it, count 0 if it is not valid UTF-8
+        // - Object, Array: first and count are the range of child slots
+        // - ExactPlaceholder: first is the pointer, text the original string
+        // - Interpolated: first and count are the range of segments, text the
+        //   original string
+        struct NodeRecord {
+            NodeType type;
+            std::uint32_t depth;
+            std::uint32_t first;
+            std::uint32_t count;
+            StringRef text;
+            std::uint64_t scalar;
+        };
+        
+        // Position of a child in its container; keys are empty in arrays
+        struct SlotRecord {
+            std::uint32_t node;
+            StringRef key;
+            StringRef quoted_key;  // As serialized; empty if not valid UTF-8
+        };
+        
+        // Literal text (pointer is NO_POINTER) or a placeholder and its text
+        struct SegmentRecord {
+            std::uint32_t pointer;
+            StringRef text;
+        };
+        
+        struct PointerRecord {
+            StringRef path;
+            std::uint32_t first_token;
+            std::uint32_t token_count;
+        };
+        
+        // Unescaped reference token and its array index (JsonPointer::NO_INDEX if none)
+        struct TokenRecord {
+            StringRef text;
+            std::uint64_t index;
+        };
+        
+        // Checksum of a whole file, except the checksum field itself
+        std::uint64_t checksum(const char* data, size_t length);
+        
+        // Compile a template into artifact bytes
+        std::string serialize(const nlohmann::json& template_json, const Options& options);
+    }
+    
+    // Validated artifact, applied in place
+    //
+    // THREAD SAFETY:
+    // - The only mutable state is the cache of literal subtrees, which the
+    //   first apply() builds under std::call_once and nothing changes after
+    // - apply() and render() can be called concurrently from multiple threads
+    class TemplateArtifact::Impl {
+    public:
+        // Takes ownership of a mapping of the whole file, or of owned bytes;
+        // data must stay valid for the lifetime of this object
+        Impl(std::string_view data, void* mapping, std::vector<std::uint64_t> owned);
+        ~Impl();
+        
+        Impl(const Impl&) = delete;
+        Impl& operator=(const Impl&) = delete;
+        
+        nlohmann::json apply(const nlohmann::json& context) const;
+        void render(const nlohmann::json& context, Sink& sink, int indent) const;
+        
+        const Options& options() const { return options_; }
+    
+    private:
+        // Locate the sections and check everything apply() and render() rely
+        // on; throws InvalidTemplateException
+        void load();
+        void check_string(artifact::StringRef ref) const;
+        void check_nodes() const;
+        
+        void release_mapping();
+        
+        std::string_view text(artifact::StringRef ref) const { return {strings_ + ref.offset, ref.length}; }
+        
+        bool apply_node(std::uint32_t index, const nlohmann::json& context,
+                        nlohmann::json& out, ProcessingContext& ctx) const;
+        nlohmann::json scalar_value(const artifact::NodeRecord& node) const;
+        
+        // Builds the subtree at index into literal if it has no placeholders
+        // and stays within the depth limit; otherwise returns false, keeping
+        // the largest literal containers below it for apply_node
+        bool collect_literals(std::uint32_t index, nlohmann::json& literal) const;
+        void render_node(const artifact::NodeRecord& node, const nlohmann::json& context,
+                         JsonWriter& writer, ProcessingContext& ctx) const;
+        void append_interpolated(const artifact::NodeRecord& node, const nlohmann::json& context,
+                                 ProcessingContext& ctx, std::string& out) const;
+        
+        // Value an exact placeholder is replaced with, nullptr if Remove mode
+        // drops it; the placeholder text itself is reported through unresolved
+        const nlohmann::json* resolve_exact(const artifact::NodeRecord& node, const nlohmann::json& context,
+                                            ProcessingContext& ctx, bool& unresolved) const;
+        const nlohmann::json* lookup(std::uint32_t pointer, const nlohmann::json& context,
+                                     ProcessingContext& ctx) const;
+        [[noreturn]] void missing_key(std::uint32_t pointer) const;
+        void check_depth(const artifact::NodeRecord& node) const;
+        
+        std::string_view data_;
+        void* mapping_;
+        std::vector<std::uint64_t> owned_;
+        
+        const artifact::Header* header_ = nullptr;
+        const artifact::NodeRecord* nodes_ = nullptr;
+        const artifact::SlotRecord* slots_ = nullptr;
+        const artifact::SegmentRecord* segments_ = nullptr;
+        const artifact::PointerRecord* pointers_ = nullptr;
+        const artifact::TokenRecord* tokens_ = nullptr;
+        const char* strings_ = nullptr;
+        
+        Options options_;
+        std::unique_ptr<const TemplateProcessor> processor_;  // Only for recursive_expansion
+        std::vector<JsonPointer> parsed_pointers_;              // Only for recursive_expansion
+        
+        // Literal containers that apply() copies whole, like CompiledTemplate
+        // does. Built on the first apply(), so render() alone never holds
+        // them; literal_index_ maps each node to one, or to NO_LITERAL.
+        mutable std::once_flag literals_built_;
+        mutable std::vector<std::uint32_t> literal_index_;
+        mutable std::vector<nlohmann::json> literals_;
+    };
+}
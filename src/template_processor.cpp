@@ -1,5 +1,6 @@
 #include "template_processor.hpp"
-#include <sstream>
+#include "value_formatter.hpp"
+#include "thread_pool.hpp"
 
 namespace permuto {
     namespace {
@@ -7,207 +8,655 @@ namespace permuto {
         const size_t INITIAL_RECURSION_DEPTH = 0;
     }
     
-    TemplateProcessor::TemplateProcessor(const Options& options) 
+    TemplateProcessor::TemplateProcessor(const Options& options)
         : options_(options), parser_(options.start_marker, options.end_marker) {
         options_.validate();
     }
     
-    ProcessingContext& TemplateProcessor::get_processing_context() const {
-        // Create thread-local context for each thread
-        static thread_local ProcessingContext context;
-        return context;
+    nlohmann::json TemplateProcessor::process(const nlohmann::json& template_json,
+                                            const nlohmann::json& context) const {
+        ProcessingContext ctx;
+        if (options_.engine == ProcessingEngine::Iterative) {
+            return process_iterative(template_json, context, ctx, INITIAL_RECURSION_DEPTH);
+        }
+        return process_value(template_json, context, ctx, INITIAL_RECURSION_DEPTH);
+    }
+    
+    nlohmann::json TemplateProcessor::process(const nlohmann::json& value,
+                                            const nlohmann::json& context,
+                                            ProcessingContext& ctx, size_t depth) const {
+        if (options_.engine == ProcessingEngine::Iterative) {
+            return process_iterative(value, context, ctx, depth);
+        }
+        return process_value(value, context, ctx, depth);
+    }
+    
+    nlohmann::json TemplateProcessor::process(const nlohmann::json& template_json,
+                                            nlohmann::json&& context) const {
+        // Expanded values are copies, so there is nothing to move out of context
+        if (options_.recursive_expansion) {
+            return process(template_json, static_cast<const nlohmann::json&>(context));
+        }
+        
+        MovePlan plan;
+        plan_moves(template_json, context, plan, INITIAL_RECURSION_DEPTH);
+        
+        ProcessingContext ctx;
+        ctx.move_plan = &plan;
+        if (options_.engine == ProcessingEngine::Iterative) {
+            return process_iterative(template_json, context, ctx, INITIAL_RECURSION_DEPTH);
+        }
+        return process_value(template_json, context, ctx, INITIAL_RECURSION_DEPTH);
     }
     
-    nlohmann::json TemplateProcessor::process(const nlohmann::json& template_json, 
+    void TemplateProcessor::process_inplace(nlohmann::json& doc,
                                             const nlohmann::json& context) const {
-        // Get thread-local processing context and reset state
-        ProcessingContext& ctx = get_processing_context();
-        ctx.cycle_detector.clear();
-        ctx.current_depth = INITIAL_RECURSION_DEPTH;
-        return process_value(template_json, context);
+        ProcessingContext ctx;
+        if (options_.engine == ProcessingEngine::Iterative) {
+            process_inplace_iterative(doc, context, ctx);
+            return;
+        }
+        process_value_inplace(doc, context, ctx, INITIAL_RECURSION_DEPTH);
     }
     
-    nlohmann::json TemplateProcessor::process_value(const nlohmann::json& value, 
-                                                   const nlohmann::json& context) const {
-        ProcessingContext& ctx = get_processing_context();
-        enter_recursion(ctx);
+    void TemplateProcessor::process_inplace(nlohmann::json& doc,
+                                            nlohmann::json&& context) const {
+        if (options_.recursive_expansion) {
+            process_inplace(doc, static_cast<const nlohmann::json&>(context));
+            return;
+        }
         
-        try {
-            if (value.is_string()) {
-                auto result = process_string(value.get<std::string>(), context);
-                exit_recursion(ctx);
-                return result;
-            } else if (value.is_object()) {
-                auto result = process_object(value, context);
-                exit_recursion(ctx);
-                return result;
-            } else if (value.is_array()) {
-                auto result = process_array(value, context);
-                exit_recursion(ctx);
-                return result;
-            } else {
-                // Primitive values (numbers, booleans, null) are returned as-is
-                exit_recursion(ctx);
-                return value;
-            }
-        } catch (...) {
-            exit_recursion(ctx);
-            throw;
+        MovePlan plan;
+        plan_moves(doc, context, plan, INITIAL_RECURSION_DEPTH);
+        
+        ProcessingContext ctx;
+        ctx.move_plan = &plan;
+        if (options_.engine == ProcessingEngine::Iterative) {
+            process_inplace_iterative(doc, context, ctx);
+            return;
+        }
+        process_value_inplace(doc, context, ctx, INITIAL_RECURSION_DEPTH);
+    }
+    
+    nlohmann::json TemplateProcessor::process_value(const nlohmann::json& value,
+                                                   const nlohmann::json& context,
+                                                   ProcessingContext& ctx, size_t depth) const {
+        check_recursion_limit(depth);
+        
+        if (value.is_string()) {
+            return process_string(value.get_ref<const std::string&>(), context, ctx);
+        } else if (value.is_object()) {
+            return process_object(value, context, ctx, depth + 1);
+        } else if (value.is_array()) {
+            return process_array(value, context, ctx, depth + 1);
         }
+        
+        // Primitive values (numbers, booleans, null) are returned as-is
+        return value;
+    }
+    
+    nlohmann::json TemplateProcessor::process_string(const std::string& str,
+                                                    const nlohmann::json& context,
+                                                    ProcessingContext& ctx) const {
+        nlohmann::json result;
+        if (substitute_string(str, context, ctx, result)) {
+            return result;
+        }
+        return str;
     }
     
-    nlohmann::json TemplateProcessor::process_string(const std::string& str, 
-                                                    const nlohmann::json& context) const {
+    bool TemplateProcessor::substitute_string(const std::string& str, const nlohmann::json& context,
+                                              ProcessingContext& ctx, nlohmann::json& out) const {
         // Check for exact-match placeholder first
         auto exact_path = parser_.extract_exact_placeholder(str);
         if (exact_path) {
-            auto resolved = resolve_path(*exact_path, context);
+            const nlohmann::json* resolved = resolve_path(*exact_path, context, ctx);
             if (resolved) {
-                return *resolved;
+                // The only copy of the matched context value
+                out = use_value(resolved, ctx);
+                return true;
             } else {
                 // Handle missing key based on options
                 if (options_.missing_key_behavior == MissingKeyBehavior::Error) {
                     throw MissingKeyException("Missing key in context", *exact_path);
                 } else {
-                    // Return original string
-                    return str;
+                    // Leave the original string
+                    return false;
                 }
             }
         }
         
         // Handle interpolation mode
         if (!options_.enable_interpolation) {
-            return str;
+            return false;
         }
         
-        // Process placeholders within the string
-        std::string result = parser_.replace_placeholders(str, 
-            [this, &context](const std::string& path) -> std::string {
-                auto resolved = resolve_path(path, context);
+        // Process placeholders within the string, appending values in place
+        std::string result;
+        size_t replaced = parser_.append_replaced(str, result,
+            [this, &context, &ctx](std::string_view path, std::string& buffer) {
+                const nlohmann::json* resolved = resolve_path(path, context, ctx);
                 if (resolved) {
-                    return json_to_string(*resolved);
+                    if (ctx.move_plan) {
+                        ctx.move_plan->use(resolved);
+                    }
+                    append_json_string(buffer, *resolved, &ctx.dump_cache);
                 } else {
                     if (options_.missing_key_behavior == MissingKeyBehavior::Error) {
-                        throw MissingKeyException("Missing key in context", path);
+                        throw MissingKeyException("Missing key in context", std::string(path));
                     } else {
-                        // Return the original placeholder
-                        return options_.start_marker + path + options_.end_marker;
+                        // Keep the original placeholder
+                        buffer += options_.start_marker;
+                        buffer += path;
+                        buffer += options_.end_marker;
                     }
                 }
             });
         
-        return result;
+        if (replaced == 0) {
+            return false;
+        }
+        out = std::move(result);
+        return true;
     }
     
-    nlohmann::json TemplateProcessor::process_object(const nlohmann::json& obj, 
-                                                    const nlohmann::json& context) const {
+    nlohmann::json TemplateProcessor::process_object(const nlohmann::json& obj,
+                                                    const nlohmann::json& context,
+                                                    ProcessingContext& ctx, size_t depth) const {
         nlohmann::json result = nlohmann::json::object();
         
-        for (auto it = obj.begin(); it != obj.end(); ++it) {
-            const auto& key = it.key();
-            const auto& value = it.value();
+        if (should_parallelize(obj.size(), ctx)) {
+            std::vector<const nlohmann::json*> items;
+            items.reserve(obj.size());
+            for (const auto& item : obj) {
+                items.push_back(&item);
+            }
             
-            // Check if this is an exact placeholder that might need removal
-            if (value.is_string()) {
-                auto placeholder_path = parser_.extract_exact_placeholder(value.get<std::string>());
-                if (placeholder_path) {
-                    auto resolved_value = resolve_path(*placeholder_path, context);
-                    if (!resolved_value && options_.missing_key_behavior == MissingKeyBehavior::Remove) {
-                        // Skip this key-value pair (remove from object)
-                        continue;
-                    }
+            std::vector<nlohmann::json> values;
+            std::vector<char> keep;
+            process_elements_parallel(items, context, ctx, depth, values, keep);
+            
+            size_t index = 0;
+            for (auto it = obj.begin(); it != obj.end(); ++it, ++index) {
+                if (keep[index]) {
+                    result[it.key()] = std::move(values[index]);
                 }
             }
-            
-            // Process normally
-            result[key] = process_value(value, context);
+            return result;
+        }
+        
+        for (auto it = obj.begin(); it != obj.end(); ++it) {
+            nlohmann::json value;
+            if (process_element(it.value(), context, ctx, depth, value)) {
+                result[it.key()] = std::move(value);
+            }
+            // Otherwise Remove mode drops the key-value pair
         }
         
         return result;
     }
     
-    nlohmann::json TemplateProcessor::process_array(const nlohmann::json& arr, 
-                                                   const nlohmann::json& context) const {
+    nlohmann::json TemplateProcessor::process_array(const nlohmann::json& arr,
+                                                   const nlohmann::json& context,
+                                                   ProcessingContext& ctx, size_t depth) const {
         nlohmann::json result = nlohmann::json::array();
         
+        if (should_parallelize(arr.size(), ctx)) {
+            std::vector<const nlohmann::json*> items;
+            items.reserve(arr.size());
+            for (const auto& item : arr) {
+                items.push_back(&item);
+            }
+            
+            std::vector<nlohmann::json> values;
+            std::vector<char> keep;
+            process_elements_parallel(items, context, ctx, depth, values, keep);
+            
+            // Stitch the kept elements back together in order
+            result.get_ref<nlohmann::json::array_t&>().reserve(values.size());
+            for (size_t i = 0; i < values.size(); ++i) {
+                if (keep[i]) {
+                    result.push_back(std::move(values[i]));
+                }
+            }
+            return result;
+        }
+        
         for (const auto& item : arr) {
-            // Check if this is an exact placeholder that might need removal
-            if (item.is_string()) {
-                auto placeholder_path = parser_.extract_exact_placeholder(item.get<std::string>());
-                if (placeholder_path) {
-                    auto resolved_value = resolve_path(*placeholder_path, context);
-                    if (!resolved_value && options_.missing_key_behavior == MissingKeyBehavior::Remove) {
-                        // Skip this array element (remove from array)
-                        continue;
-                    }
+            nlohmann::json value;
+            if (process_element(item, context, ctx, depth, value)) {
+                result.push_back(std::move(value));
+            }
+            // Otherwise Remove mode drops the array element
+        }
+        
+        return result;
+    }
+    
+    bool TemplateProcessor::should_parallelize(size_t size, const ProcessingContext& ctx) const {
+        // Consuming an rvalue context relies on the serial order of uses,
+        // expanding a context value relies on the chain in the cycle detector,
+        // and custom lookups are not required to be thread-safe
+        return options_.parallel_threshold > 0 && size >= options_.parallel_threshold &&
+               !ctx.in_parallel && ctx.move_plan == nullptr && ctx.cycle_detector.depth() == 0 &&
+               !ctx.lookup;
+    }
+    
+    void TemplateProcessor::process_elements_parallel(const std::vector<const nlohmann::json*>& items,
+                                                      const nlohmann::json& context,
+                                                      const ProcessingContext& ctx, size_t child_depth,
+                                                      std::vector<nlohmann::json>& out,
+                                                      std::vector<char>& keep) const {
+        out.resize(items.size());
+        keep.assign(items.size(), 0);
+        
+        // One processing context per worker, so workers share no mutable state
+        size_t threads = resolve_thread_count(options_.parallel_threads, items.size());
+        std::vector<ProcessingContext> worker_contexts(threads);
+        for (auto& worker_ctx : worker_contexts) {
+            worker_ctx.move_plan = ctx.move_plan;
+            worker_ctx.in_parallel = true;
+        }
+        
+        parallel_for(items.size(), threads, [&](size_t index, size_t worker) {
+            keep[index] = process_element(*items[index], context, worker_contexts[worker],
+                                          child_depth, out[index]);
+        });
+    }
+    
+    nlohmann::json TemplateProcessor::process_iterative(const nlohmann::json& template_json,
+                                                        const nlohmann::json& context,
+                                                        ProcessingContext& ctx, size_t depth) const {
+        if (!template_json.is_structured()) {
+            return process_value(template_json, context, ctx, depth);
+        }
+        
+        // Container being rebuilt, with the next child to process
+        struct Frame {
+            const nlohmann::json* source;
+            nlohmann::json result;
+            nlohmann::json::const_iterator next;
+            size_t child_depth;
+        };
+        
+        auto make_frame = [](const nlohmann::json& source, size_t child_depth) {
+            return Frame{&source,
+                         source.is_object() ? nlohmann::json::object() : nlohmann::json::array(),
+                         source.cbegin(), child_depth};
+        };
+        
+        // Add a processed child to its container and move past it
+        auto attach = [](Frame& frame, nlohmann::json&& value) {
+            if (frame.source->is_object()) {
+                frame.result[frame.next.key()] = std::move(value);
+            } else {
+                frame.result.push_back(std::move(value));
+            }
+            ++frame.next;
+        };
+        
+        check_recursion_limit(depth);
+        std::vector<Frame> stack;
+        stack.push_back(make_frame(template_json, depth + 1));
+        
+        while (true) {
+            Frame& top = stack.back();
+            
+            if (top.next == top.source->cend()) {
+                nlohmann::json done = std::move(top.result);
+                stack.pop_back();
+                if (stack.empty()) {
+                    return done;
                 }
+                attach(stack.back(), std::move(done));
+                continue;
             }
             
-            // Process normally
-            result.push_back(process_value(item, context));
+            const nlohmann::json& child = *top.next;
+            if (child.is_structured()) {
+                // process_value's depth check for the container itself
+                check_recursion_limit(top.child_depth);
+                size_t grandchild_depth = top.child_depth + 1;
+                stack.push_back(make_frame(child, grandchild_depth));
+                continue;
+            }
+            
+            nlohmann::json value;
+            if (process_element(child, context, ctx, top.child_depth, value)) {
+                attach(top, std::move(value));
+            } else {
+                // Remove mode drops the key-value pair or element
+                ++top.next;
+            }
+        }
+    }
+    
+    void TemplateProcessor::process_inplace_iterative(nlohmann::json& doc,
+                                                      const nlohmann::json& context,
+                                                      ProcessingContext& ctx) const {
+        if (!doc.is_structured()) {
+            process_value_inplace(doc, context, ctx, INITIAL_RECURSION_DEPTH);
+            return;
         }
         
-        return result;
+        // Container being rewritten; objects advance an iterator, arrays an
+        // index plus the count of kept elements compacted to the front
+        struct Frame {
+            nlohmann::json* node;
+            nlohmann::json::iterator next;
+            size_t index;
+            size_t kept;
+            size_t child_depth;
+        };
+        
+        auto make_frame = [](nlohmann::json& node, size_t child_depth) {
+            return Frame{&node, node.begin(), 0, 0, child_depth};
+        };
+        
+        auto at_end = [](const Frame& frame) {
+            return frame.node->is_object() ? frame.next == frame.node->end()
+                                           : frame.index == frame.node->size();
+        };
+        
+        auto current = [](Frame& frame) -> nlohmann::json& {
+            return frame.node->is_object() ? frame.next.value() : (*frame.node)[frame.index];
+        };
+        
+        // Move past the current child, keeping or dropping it
+        auto advance = [](Frame& frame, bool keep) {
+            if (frame.node->is_object()) {
+                frame.next = keep ? std::next(frame.next) : frame.node->erase(frame.next);
+                return;
+            }
+            if (keep) {
+                if (frame.kept != frame.index) {
+                    (*frame.node)[frame.kept] = std::move((*frame.node)[frame.index]);
+                }
+                ++frame.kept;
+            }
+            ++frame.index;
+        };
+        
+        check_recursion_limit(INITIAL_RECURSION_DEPTH);
+        std::vector<Frame> stack;
+        stack.push_back(make_frame(doc, INITIAL_RECURSION_DEPTH + 1));
+        
+        while (!stack.empty()) {
+            Frame& top = stack.back();
+            
+            if (at_end(top)) {
+                if (top.node->is_array() && top.kept < top.node->size()) {
+                    top.node->erase(top.node->begin() + static_cast<std::ptrdiff_t>(top.kept),
+                                    top.node->end());
+                }
+                stack.pop_back();
+                if (!stack.empty()) {
+                    advance(stack.back(), true);
+                }
+                continue;
+            }
+            
+            nlohmann::json& child = current(top);
+            if (child.is_structured()) {
+                // process_value_inplace's depth check for the container itself
+                check_recursion_limit(top.child_depth);
+                size_t grandchild_depth = top.child_depth + 1;
+                stack.push_back(make_frame(child, grandchild_depth));
+                continue;
+            }
+            
+            advance(top, process_element_inplace(child, context, ctx, top.child_depth));
+        }
     }
     
-    std::optional<nlohmann::json> TemplateProcessor::resolve_path(const std::string& path, 
-                                                                 const nlohmann::json& context) const {
-        ProcessingContext& ctx = get_processing_context();
+    bool TemplateProcessor::process_element(const nlohmann::json& value, const nlohmann::json& context,
+                                            ProcessingContext& ctx, size_t depth,
+                                            nlohmann::json& out) const {
+        if (options_.missing_key_behavior != MissingKeyBehavior::Remove || !value.is_string()) {
+            out = process_value(value, context, ctx, depth);
+            return true;
+        }
         
-        // Check for cycles
-        if (ctx.cycle_detector.would_create_cycle(path)) {
-            auto cycle_path = ctx.cycle_detector.get_current_path();
-            cycle_path.push_back(path);
-            throw CycleException("Cycle detected in template processing", cycle_path);
+        // Remove mode: interpolation is disabled, so a string is either an exact
+        // placeholder or a literal. Resolve once to decide removal and substitute.
+        const auto& str = value.get_ref<const std::string&>();
+        const nlohmann::json* resolved = nullptr;
+        auto placeholder_path = parser_.extract_exact_placeholder(str);
+        if (placeholder_path) {
+            resolved = resolve_path(*placeholder_path, context, ctx);
+            if (!resolved) {
+                return false;
+            }
         }
         
-        // Add path to cycle detector
-        ctx.cycle_detector.push_path(path);
+        check_recursion_limit(depth);
+        if (resolved) {
+            out = use_value(resolved, ctx);
+        } else {
+            out = str;
+        }
+        return true;
+    }
+    
+    void TemplateProcessor::process_value_inplace(nlohmann::json& value,
+                                                  const nlohmann::json& context,
+                                                  ProcessingContext& ctx, size_t depth) const {
+        check_recursion_limit(depth);
+        
+        if (value.is_string()) {
+            nlohmann::json substituted;
+            if (substitute_string(value.get_ref<const std::string&>(), context, ctx, substituted)) {
+                value = std::move(substituted);
+            }
+        } else if (value.is_object()) {
+            process_object_inplace(value, context, ctx, depth + 1);
+        } else if (value.is_array()) {
+            process_array_inplace(value, context, ctx, depth + 1);
+        }
+        // Primitive values (numbers, booleans, null) stay as they are
+    }
+    
+    void TemplateProcessor::process_object_inplace(nlohmann::json& obj,
+                                                   const nlohmann::json& context,
+                                                   ProcessingContext& ctx, size_t depth) const {
+        for (auto it = obj.begin(); it != obj.end();) {
+            if (!process_element_inplace(it.value(), context, ctx, depth)) {
+                it = obj.erase(it);
+                continue;
+            }
+            ++it;
+        }
+    }
+    
+    void TemplateProcessor::process_array_inplace(nlohmann::json& arr,
+                                                  const nlohmann::json& context,
+                                                  ProcessingContext& ctx, size_t depth) const {
+        // Compact kept elements towards the front, then drop the tail once
+        size_t kept = 0;
+        for (size_t i = 0; i < arr.size(); ++i) {
+            if (!process_element_inplace(arr[i], context, ctx, depth)) {
+                continue;
+            }
+            
+            if (kept != i) {
+                arr[kept] = std::move(arr[i]);
+            }
+            ++kept;
+        }
         
+        if (kept < arr.size()) {
+            arr.erase(arr.begin() + static_cast<std::ptrdiff_t>(kept), arr.end());
+        }
+    }
+    
+    bool TemplateProcessor::process_element_inplace(nlohmann::json& value,
+                                                    const nlohmann::json& context,
+                                                    ProcessingContext& ctx, size_t depth) const {
+        if (options_.missing_key_behavior != MissingKeyBehavior::Remove || !value.is_string()) {
+            process_value_inplace(value, context, ctx, depth);
+            return true;
+        }
+        
+        // Remove mode: resolve once to decide removal and substitute
+        auto placeholder_path = parser_.extract_exact_placeholder(value.get_ref<const std::string&>());
+        if (!placeholder_path) {
+            // Literal string stays as it is, but still counts towards the depth limit
+            check_recursion_limit(depth);
+            return true;
+        }
+        
+        const nlohmann::json* resolved = resolve_path(*placeholder_path, context, ctx);
+        if (!resolved) {
+            return false;
+        }
+        
+        check_recursion_limit(depth);
+        value = use_value(resolved, ctx);
+        return true;
+    }
+    
+    void TemplateProcessor::plan_moves(const nlohmann::json& value, const nlohmann::json& context,
+                                       MovePlan& plan, size_t depth) const {
+        // Explicit stack in processing order, so deep templates are safe with either engine
+        std::vector<std::pair<const nlohmann::json*, size_t>> pending;
+        pending.emplace_back(&value, depth);
+        
+        while (!pending.empty()) {
+            auto [node, node_depth] = pending.back();
+            pending.pop_back();
+            
+            // Processing stops with RecursionLimitException at this depth
+            if (node_depth >= options_.max_recursion_depth) {
+                continue;
+            }
+            
+            if (node->is_string()) {
+                const auto& str = node->get_ref<const std::string&>();
+                auto exact_path = parser_.extract_exact_placeholder(str);
+                if (exact_path) {
+                    plan.expect(*intern_pointer(*exact_path), context);
+                } else if (options_.enable_interpolation) {
+                    for (const auto& placeholder : parser_.find_placeholders(str)) {
+                        plan.expect(*intern_pointer(placeholder.path), context);
+                    }
+                }
+            } else if (node->is_structured()) {
+                // Reversed, so children come off the stack in iteration order
+                for (auto it = node->crbegin(); it != node->crend(); ++it) {
+                    pending.emplace_back(&*it, node_depth + 1);
+                }
+            }
+        }
+    }
+    
+    nlohmann::json TemplateProcessor::use_value(const nlohmann::json* resolved,
+                                                ProcessingContext& ctx) const {
+        if (ctx.move_plan && ctx.move_plan->use(resolved)) {
+            // Only set for contexts handed over by rvalue, so the value is not const
+            return std::move(*const_cast<nlohmann::json*>(resolved));
+        }
+        return *resolved;
+    }
+    
+    const nlohmann::json* TemplateProcessor::resolve_path(std::string_view path,
+                                                         const nlohmann::json& context,
+                                                         ProcessingContext& ctx) const {
+        // Invalid pointers resolve to nothing
+        PointerRef pointer;
         try {
-            JsonPointer pointer(path);
-            auto result = pointer.resolve(context);
-            ctx.cycle_detector.pop_path();
-            return result;
+            pointer = intern_pointer(path);
         } catch (const std::exception&) {
-            ctx.cycle_detector.pop_path();
-            return std::nullopt;
+            return nullptr;
         }
+        return resolve(*pointer, context, ctx);
     }
     
-    std::string TemplateProcessor::json_to_string(const nlohmann::json& value) const {
-        if (value.is_string()) {
-            return value.get<std::string>();
-        } else if (value.is_number_integer()) {
-            return std::to_string(value.get<int64_t>());
-        } else if (value.is_number_unsigned()) {
-            return std::to_string(value.get<uint64_t>());
-        } else if (value.is_number_float()) {
-            return std::to_string(value.get<double>());
-        } else if (value.is_boolean()) {
-            return value.get<bool>() ? "true" : "false";
-        } else if (value.is_null()) {
-            return "null";
-        } else {
-            // For objects and arrays, serialize to JSON string
-            return value.dump();
+    const nlohmann::json* TemplateProcessor::resolve(const JsonPointer& pointer,
+                                                     const nlohmann::json& context,
+                                                     ProcessingContext& ctx) const {
+        // Check for cycles; the caller keeps pointer, and so the path, alive
+        // until the detector entry is popped
+        std::string_view path = pointer.path();
+        if (ctx.cycle_detector.would_create_cycle(path)) {
+            auto cycle_path = ctx.cycle_detector.get_current_path();
+            cycle_path.emplace_back(path);
+            throw CycleException("Cycle detected in template processing", cycle_path);
         }
+        
+        if (options_.recursive_expansion) {
+            return expand_resolved(pointer, context, ctx);
+        }
+        
+        ctx.cycle_detector.push_path(path);
+        const nlohmann::json* result = find_in_context(pointer, context, ctx);
+        ctx.cycle_detector.pop_path();
+        return result;
     }
     
-    void TemplateProcessor::check_recursion_limit(ProcessingContext& ctx) const {
-        if (ctx.current_depth >= options_.max_recursion_depth) {
-            throw RecursionLimitException("Maximum recursion depth exceeded", ctx.current_depth);
+    const nlohmann::json* TemplateProcessor::expand_resolved(const JsonPointer& pointer,
+                                                             const nlohmann::json& context,
+                                                             ProcessingContext& ctx) const {
+        auto cached = ctx.expanded_paths.find(pointer.path());
+        if (cached != ctx.expanded_paths.end()) {
+            return cached->second;
         }
+        
+        // Values without markers are used straight from the context
+        const nlohmann::json* result = find_in_context(pointer, context, ctx);
+        if (result && has_markers(*result)) {
+            // Paths being expanded stay on the detector until their value is done
+            ctx.cycle_detector.push_path(pointer.path());
+            size_t depth = ctx.cycle_detector.depth();
+            nlohmann::json expanded;
+            try {
+                if (options_.engine == ProcessingEngine::Iterative) {
+                    expanded = process_iterative(*result, context, ctx, depth);
+                } else {
+                    expanded = process_value(*result, context, ctx, depth);
+                }
+            } catch (...) {
+                ctx.cycle_detector.pop_path();
+                throw;
+            }
+            ctx.cycle_detector.pop_path();
+            
+            ctx.expanded_values.push_front(std::move(expanded));
+            result = &ctx.expanded_values.front();
+        }
+        
+        ctx.expanded_paths.emplace(pointer.path(), result);
+        return result;
+    }
+    
+    const nlohmann::json* TemplateProcessor::find_in_context(const JsonPointer& pointer,
+                                                             const nlohmann::json& context,
+                                                             const ProcessingContext& ctx) const {
+        return ctx.lookup ? ctx.lookup(pointer) : pointer.find(context);
     }
     
-    void TemplateProcessor::enter_recursion(ProcessingContext& ctx) const {
-        check_recursion_limit(ctx);
-        ++ctx.current_depth;
+    bool TemplateProcessor::has_markers(const nlohmann::json& value) const {
+        std::vector<const nlohmann::json*> pending{&value};
+        while (!pending.empty()) {
+            const nlohmann::json* node = pending.back();
+            pending.pop_back();
+            
+            if (node->is_string()) {
+                if (find_marker(node->get_ref<const std::string&>(), 0, options_.start_marker) !=
+                    std::string_view::npos) {
+                    return true;
+                }
+            } else if (node->is_structured()) {
+                for (const auto& child : *node) {
+                    pending.push_back(&child);
+                }
+            }
+        }
+        return false;
     }
     
-    void TemplateProcessor::exit_recursion(ProcessingContext& ctx) const {
-        if (ctx.current_depth > INITIAL_RECURSION_DEPTH) {
-            --ctx.current_depth;
+    void TemplateProcessor::check_recursion_limit(size_t depth) const {
+        if (depth >= options_.max_recursion_depth) {
+            throw RecursionLimitException("Maximum recursion depth exceeded", depth);
         }
     }
-}
\ No newline at end of file
+}
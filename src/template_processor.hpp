@@ -1,19 +1,34 @@
 #pragma once
 #include <nlohmann/json.hpp>
-#include <thread>
+#include <forward_list>
+#include <functional>
 #include <unordered_map>
-#include <mutex>
 #include "../include/permuto/permuto.hpp"
 #include "json_pointer.hpp"
 #include "placeholder_parser.hpp"
 #include "cycle_detector.hpp"
+#include "move_plan.hpp"
+#include "value_formatter.hpp"
 
 namespace permuto {
-    // Thread-safe context for processing state
-    // Each thread gets its own independent processing context via thread_local storage
+    // Mutable state of one process()/process_inplace() call
+    // Created on the caller's stack and passed down the traversal, so calls
+    // on different threads (or the same thread) never share it
     struct ProcessingContext {
         CycleDetector cycle_detector;
-        size_t current_depth = 0;
+        MovePlan* move_plan = nullptr;  // Set while consuming an rvalue context
+        DumpCache dump_cache;           // Objects and arrays interpolated in this call
+        bool in_parallel = false;       // Inside a parallel section; nested containers stay serial
+        
+        // Recursive expansion: fully expanded value of each path looked up so
+        // far (nullptr if missing), and storage for the expanded copies
+        // Keyed by path, since the same path may be interned more than once
+        std::unordered_map<std::string, const nlohmann::json*> expanded_paths;
+        std::forward_list<nlohmann::json> expanded_values;
+        
+        // Replaces lookups in the context when set; returned values must stay
+        // valid for the rest of the call (used by Pipeline)
+        std::function<const nlohmann::json*(const JsonPointer&)> lookup;
     };
     
     // Thread-safe template processor
@@ -21,7 +36,7 @@ namespace permuto {
     // THREAD SAFETY:
     // - Multiple TemplateProcessor instances can be used concurrently
     // - A single TemplateProcessor instance can be used concurrently from multiple threads
-    // - All mutable state is stored in thread-local storage (ProcessingContext)
+    // - All mutable state lives in a ProcessingContext owned by each call
     // - The processor itself contains only immutable data after construction
     class TemplateProcessor {
     public:
@@ -32,36 +47,111 @@ namespace permuto {
         nlohmann::json process(const nlohmann::json& template_json, 
                               const nlohmann::json& context) const;
         
+        // Process a template with a context the caller gives up
+        // Referenced context values are moved into the result at their last
+        // use; earlier uses, and values overlapping other referenced values, copy
+        nlohmann::json process(const nlohmann::json& template_json,
+                              nlohmann::json&& context) const;
+        
+        // Substitute placeholders directly in doc, which becomes the result
+        // Only placeholder-bearing strings are replaced; doc must not alias context
+        void process_inplace(nlohmann::json& doc, const nlohmann::json& context) const;
+        void process_inplace(nlohmann::json& doc, nlohmann::json&& context) const;
+        
+        // Process value as if it were found at depth in a larger template,
+        // with per-call state supplied by the caller
+        nlohmann::json process(const nlohmann::json& value, const nlohmann::json& context,
+                               ProcessingContext& ctx, size_t depth) const;
+        
+        // Look up pointer in context as processing does, with cycle checks and,
+        // if options.recursive_expansion is set, expansion of the value found
+        // Returns nullptr if missing; expanded values live as long as ctx
+        const nlohmann::json* resolve(const JsonPointer& pointer, const nlohmann::json& context,
+                                      ProcessingContext& ctx) const;
+        
     private:
         const Options options_;
         const PlaceholderParser parser_;
         
-        // Get or create processing context for current thread
-        ProcessingContext& get_processing_context() const;
+        // Recursive traversal; depth is the nesting level of value in the template
         
         // Process different JSON value types
-        nlohmann::json process_value(const nlohmann::json& value, 
-                                    const nlohmann::json& context) const;
+        nlohmann::json process_value(const nlohmann::json& value, const nlohmann::json& context,
+                                    ProcessingContext& ctx, size_t depth) const;
+        
+        nlohmann::json process_string(const std::string& str, const nlohmann::json& context,
+                                     ProcessingContext& ctx) const;
+        
+        nlohmann::json process_object(const nlohmann::json& obj, const nlohmann::json& context,
+                                     ProcessingContext& ctx, size_t depth) const;
         
-        nlohmann::json process_string(const std::string& str, 
-                                     const nlohmann::json& context) const;
+        nlohmann::json process_array(const nlohmann::json& arr, const nlohmann::json& context,
+                                    ProcessingContext& ctx, size_t depth) const;
         
-        nlohmann::json process_object(const nlohmann::json& obj, 
-                                     const nlohmann::json& context) const;
+        // Substitute placeholders in a string; returns false if it stays unchanged
+        bool substitute_string(const std::string& str, const nlohmann::json& context,
+                               ProcessingContext& ctx, nlohmann::json& out) const;
         
-        nlohmann::json process_array(const nlohmann::json& arr, 
-                                    const nlohmann::json& context) const;
+        // True if a container with this many children is processed on worker threads
+        bool should_parallelize(size_t size, const ProcessingContext& ctx) const;
+        
+        // Process *items[i] at child_depth into out[i] on worker threads; keep[i]
+        // is false where Remove mode drops the item. Rethrows the exception of
+        // the first failing item, as serial processing would.
+        void process_elements_parallel(const std::vector<const nlohmann::json*>& items,
+                                       const nlohmann::json& context,
+                                       const ProcessingContext& ctx, size_t child_depth,
+                                       std::vector<nlohmann::json>& out,
+                                       std::vector<char>& keep) const;
+        
+        // In-place counterparts of the process_* functions
+        void process_value_inplace(nlohmann::json& value, const nlohmann::json& context,
+                                   ProcessingContext& ctx, size_t depth) const;
+        void process_object_inplace(nlohmann::json& obj, const nlohmann::json& context,
+                                    ProcessingContext& ctx, size_t depth) const;
+        void process_array_inplace(nlohmann::json& arr, const nlohmann::json& context,
+                                   ProcessingContext& ctx, size_t depth) const;
+        
+        // Explicit-stack counterparts of process_value and process_value_inplace
+        // Same traversal order, depth checks and results as the recursive
+        // functions, with native stack use independent of template depth
+        nlohmann::json process_iterative(const nlohmann::json& template_json,
+                                         const nlohmann::json& context,
+                                         ProcessingContext& ctx, size_t depth) const;
+        void process_inplace_iterative(nlohmann::json& doc, const nlohmann::json& context,
+                                       ProcessingContext& ctx) const;
+        
+        // Process an object member or array element with a single context lookup
+        // Returns false if Remove mode drops it
+        bool process_element(const nlohmann::json& value, const nlohmann::json& context,
+                             ProcessingContext& ctx, size_t depth, nlohmann::json& out) const;
+        bool process_element_inplace(nlohmann::json& value, const nlohmann::json& context,
+                                     ProcessingContext& ctx, size_t depth) const;
+        
+        // Record every context lookup processing will perform, in order
+        void plan_moves(const nlohmann::json& value, const nlohmann::json& context,
+                        MovePlan& plan, size_t depth) const;
+        
+        // Copy a resolved context value, or move it when the move plan allows
+        nlohmann::json use_value(const nlohmann::json* resolved, ProcessingContext& ctx) const;
         
         // Resolve a path in the context with safety checks
-        std::optional<nlohmann::json> resolve_path(const std::string& path, 
-                                                  const nlohmann::json& context) const;
+        // Returns a borrowed pointer into context, or nullptr if missing
+        const nlohmann::json* resolve_path(std::string_view path, const nlohmann::json& context,
+                                           ProcessingContext& ctx) const;
+        
+        // Process a resolved context value as a template, memoizing the result
+        const nlohmann::json* expand_resolved(const JsonPointer& pointer, const nlohmann::json& context,
+                                              ProcessingContext& ctx) const;
+        
+        // Look up pointer in context, or through ctx.lookup if set
+        const nlohmann::json* find_in_context(const JsonPointer& pointer, const nlohmann::json& context,
+                                              const ProcessingContext& ctx) const;
         
-        // Convert JSON value to string for interpolation
-        std::string json_to_string(const nlohmann::json& value) const;
+        // True if any string in value contains the start marker
+        bool has_markers(const nlohmann::json& value) const;
         
-        // Safety checks (now thread-safe)
-        void check_recursion_limit(ProcessingContext& ctx) const;
-        void enter_recursion(ProcessingContext& ctx) const;
-        void exit_recursion(ProcessingContext& ctx) const;
+        // Throws RecursionLimitException if a node at depth exceeds the limit
+        void check_recursion_limit(size_t depth) const;
     };
 }
\ No newline at end of file
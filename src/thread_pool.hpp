@@ -0,0 +1,124 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace permuto {
+    // Number of worker threads to use for count items
+    // requested == 0 means one per hardware thread; never more than count
+    inline size_t resolve_thread_count(size_t requested, size_t count) {
+        size_t threads = requested;
+        if (threads == 0) {
+            threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+        return std::max<size_t>(1, std::min(threads, count));
+    }
+    
+    // Run fn(i) for every i in [0, count) on thread_count threads
+    // fn may also take a second argument, the index in [0, thread_count) of
+    // the worker running it, to keep per-worker state without locking.
+    // 
+    // Indices are split into one contiguous range per thread. A thread claims
+    // indices from the front of its own range and, once that is drained,
+    // steals from the ranges of the others, so uneven per-item costs still
+    // keep every thread busy. The calling thread is one of the workers.
+    // 
+    // If fn throws, indices above the failing one are skipped where possible
+    // and the exception of the lowest failing index is rethrown after all
+    // threads have joined. Every index below it has run, so the reported
+    // error is the same on every run regardless of scheduling.
+    // 
+    // With a single thread (or a single index) everything runs in order on
+    // the calling thread, without starting or synchronizing any threads.
+    template <typename Fn>
+    void parallel_for(size_t count, size_t thread_count, Fn&& fn) {
+        if (count == 0) {
+            return;
+        }
+        thread_count = std::max<size_t>(1, std::min(thread_count, count));
+        
+        if (thread_count == 1) {
+            // The first exception is that of the lowest failing index
+            for (size_t index = 0; index < count; ++index) {
+                if constexpr (std::is_invocable_v<Fn&, size_t, size_t>) {
+                    fn(index, 0);
+                } else {
+                    fn(index);
+                }
+            }
+            return;
+        }
+        
+        struct Range {
+            std::atomic<size_t> next{0};
+            size_t end = 0;
+        };
+        std::vector<Range> ranges(thread_count);
+        for (size_t t = 0; t < thread_count; ++t) {
+            ranges[t].next.store(count * t / thread_count, std::memory_order_relaxed);
+            ranges[t].end = count * (t + 1) / thread_count;
+        }
+        
+        const size_t NO_FAILURE = std::numeric_limits<size_t>::max();
+        std::atomic<size_t> first_failure{NO_FAILURE};
+        std::exception_ptr first_error;
+        std::mutex error_mutex;
+        
+        auto run_index = [&](size_t index, size_t self) {
+            if (index > first_failure.load(std::memory_order_relaxed)) {
+                return;
+            }
+            try {
+                if constexpr (std::is_invocable_v<Fn&, size_t, size_t>) {
+                    fn(index, self);
+                } else {
+                    fn(index);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (index < first_failure.load(std::memory_order_relaxed)) {
+                    first_failure.store(index, std::memory_order_relaxed);
+                    first_error = std::current_exception();
+                }
+            }
+        };
+        
+        auto worker = [&](size_t self) {
+            // Own range first, then the others in order
+            for (size_t offset = 0; offset < thread_count; ++offset) {
+                Range& range = ranges[(self + offset) % thread_count];
+                for (size_t index = range.next.fetch_add(1, std::memory_order_relaxed);
+                     index < range.end;
+                     index = range.next.fetch_add(1, std::memory_order_relaxed)) {
+                    run_index(index, self);
+                }
+            }
+        };
+        
+        std::vector<std::thread> threads;
+        threads.reserve(thread_count - 1);
+        for (size_t t = 1; t < thread_count; ++t) {
+            try {
+                threads.emplace_back(worker, t);
+            } catch (const std::system_error&) {
+                // Ranges without a thread are drained by stealing
+                break;
+            }
+        }
+        worker(0);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        
+        if (first_error) {
+            std::rethrow_exception(first_error);
+        }
+    }
+}
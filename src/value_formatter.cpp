@@ -0,0 +1,64 @@
+#include "value_formatter.hpp"
+#include <charconv>
+
+namespace permuto {
+    namespace {
+        // Enough for any 64-bit integer
+        const size_t NUMBER_BUFFER_SIZE = 32;
+        
+        template <typename T>
+        void append_integer(std::string& out, T value) {
+            char buffer[NUMBER_BUFFER_SIZE];
+            auto result = std::to_chars(buffer, buffer + NUMBER_BUFFER_SIZE, value);
+            out.append(buffer, result.ptr);
+        }
+    }
+    
+    const std::string& DumpCache::dump(const nlohmann::json& value) {
+        auto it = dumps_.find(&value);
+        if (it == dumps_.end()) {
+            it = dumps_.emplace(&value, value.dump()).first;
+        }
+        return it->second;
+    }
+    
+    std::string json_to_string(const nlohmann::json& value) {
+        std::string result;
+        append_json_string(result, value);
+        return result;
+    }
+    
+    void append_json_string(std::string& out, const nlohmann::json& value, DumpCache* cache) {
+        switch (value.type()) {
+            case nlohmann::json::value_t::string:
+                out += value.get_ref<const std::string&>();
+                break;
+            case nlohmann::json::value_t::number_integer:
+                append_integer(out, value.get<int64_t>());
+                break;
+            case nlohmann::json::value_t::number_unsigned:
+                append_integer(out, value.get<uint64_t>());
+                break;
+            case nlohmann::json::value_t::number_float:
+                // dump()'s own text: std::to_chars picks between fixed and
+                // exponent notation differently and is missing from some
+                // standard libraries, so the result would vary by platform
+                out += value.dump();
+                break;
+            case nlohmann::json::value_t::boolean:
+                out += value.get<bool>() ? "true" : "false";
+                break;
+            case nlohmann::json::value_t::null:
+                out += "null";
+                break;
+            default:
+                // For objects, arrays and binary values, serialize to JSON string
+                if (cache) {
+                    out += cache->dump(value);
+                } else {
+                    out += value.dump();
+                }
+                break;
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include <string>
+#include <unordered_map>
+
+namespace permuto {
+    // Serialized objects and arrays, reused for the duration of one apply
+    //
+    // Keyed by the address of the context value, so a cache must not outlive
+    // the context it was filled from.
+    class DumpCache {
+    public:
+        // Serialized form of an object or array, computed on first use
+        const std::string& dump(const nlohmann::json& value);
+        
+        void clear() { dumps_.clear(); }
+        
+    private:
+        std::unordered_map<const nlohmann::json*, std::string> dumps_;
+    };
+    
+    // Convert JSON value to string for interpolation
+    std::string json_to_string(const nlohmann::json& value);
+    
+    // Append the interpolation text of a JSON value to out
+    // - Strings are appended without quotes
+    // - Numbers are written exactly as dump() writes them
+    // - Objects and arrays are serialized, through cache when one is given
+    void append_json_string(std::string& out, const nlohmann::json& value, DumpCache* cache = nullptr);
+}
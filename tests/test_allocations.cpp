@@ -0,0 +1,162 @@
+// Heap allocation budgets for the interpolation hot path
+//
+// Replaces the global operator new, so this file is built into its own test
+// executable rather than permuto_tests.
+#include <gtest/gtest.h>
+#include <permuto/permuto.hpp>
+#include "../src/placeholder_parser.hpp"
+#include "../src/cycle_detector.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<size_t> allocation_count{0};
+
+    template <typename Fn>
+    size_t count_allocations(Fn&& fn) {
+        size_t before = allocation_count.load(std::memory_order_relaxed);
+        fn();
+        return allocation_count.load(std::memory_order_relaxed) - before;
+    }
+}
+
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+using namespace permuto;
+
+class AllocationTest : public ::testing::Test {
+protected:
+    PlaceholderParser parser;
+
+    // Long enough that none of the pieces fit in a small-string buffer
+    std::string text = "Dear ${/user/name}, your order ${/order/id} from the store "
+                       "${/store/name} has shipped and will arrive ${/order/eta}. "
+                       "Reply to this message if anything looks wrong.";
+
+    nlohmann::json context = R"({
+        "user": {"name": "Alexandra Montgomery-Smith"},
+        "order": {"id": "ORD-2024-0000012345", "eta": "on Thursday afternoon"},
+        "store": {"name": "The Long Named Example Store"}
+    })"_json;
+};
+
+TEST_F(AllocationTest, ForEachPlaceholderDoesNotAllocate) {
+    size_t count = 0;
+    size_t allocations = count_allocations([&]() {
+        parser.for_each_placeholder(text, [&](std::string_view, size_t, size_t) {
+            ++count;
+        });
+    });
+
+    EXPECT_EQ(count, 4);
+    EXPECT_EQ(allocations, 0);
+}
+
+TEST_F(AllocationTest, AppendReplacedIntoReservedBuffer) {
+    std::string out;
+    out.reserve(1024);
+
+    size_t allocations = count_allocations([&]() {
+        parser.append_replaced(text, out, [](std::string_view path, std::string& buffer) {
+            buffer += "value for ";
+            buffer += path;
+        });
+    });
+
+    EXPECT_EQ(allocations, 0);
+    EXPECT_EQ(out.compare(0, 30, "Dear value for /user/name, you"), 0);
+}
+
+TEST_F(AllocationTest, AppendReplacedSizesOutputUpFront) {
+    // Without a caller reservation the output is sized from the template
+    // text, so values somewhat longer than their placeholders regrow it once
+    std::string out;
+
+    size_t allocations = count_allocations([&]() {
+        parser.append_replaced(text, out, [](std::string_view, std::string& buffer) {
+            buffer.append(40, 'x');
+        });
+    });
+
+    EXPECT_GT(out.size(), text.size());
+    EXPECT_LE(allocations, 2);
+}
+
+TEST_F(AllocationTest, CompiledInterpolationAllocatesOnlyTheResult) {
+    Options opts;
+    opts.enable_interpolation = true;
+    CompiledTemplate compiled(nlohmann::json(text), opts);
+
+    nlohmann::json result;
+    size_t allocations = count_allocations([&]() {
+        result = compiled.apply(context);
+    });
+
+    EXPECT_EQ(result, permuto::apply(nlohmann::json(text), context, opts));
+    // The result string buffer, at most one regrowth, and the json string node
+    EXPECT_LE(allocations, 3);
+}
+
+TEST_F(AllocationTest, CycleDetectorTracksPathsWithoutAllocating) {
+    CycleDetector detector;
+    const char* paths[] = {"/user/name", "/order/id", "/store/name", "/order/eta"};
+
+    size_t allocations = count_allocations([&]() {
+        for (const char* path : paths) {
+            EXPECT_FALSE(detector.would_create_cycle(path));
+            detector.push_path(path);
+        }
+        EXPECT_TRUE(detector.would_create_cycle("/order/id"));
+        for (size_t i = 0; i < 4; ++i) {
+            detector.pop_path();
+        }
+    });
+
+    EXPECT_EQ(allocations, 0);
+}
+
+TEST_F(AllocationTest, InterpolationResolvesPathsWithoutCopies) {
+    Options opts;
+    opts.enable_interpolation = true;
+    nlohmann::json template_json(text);
+
+    // Warm the pointer intern table so only per-apply work is counted
+    nlohmann::json expected = permuto::apply(template_json, context, opts);
+
+    nlohmann::json result;
+    size_t allocations = count_allocations([&]() {
+        result = permuto::apply(template_json, context, opts);
+    });
+
+    EXPECT_EQ(result, expected);
+    // Same budget as the compiled path: resolving the four placeholders
+    // through the cycle detector must not add any
+    EXPECT_LE(allocations, 3);
+}
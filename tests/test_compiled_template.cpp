@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <permuto/permuto.hpp>
+
+using namespace permuto;
+
+class CompiledTemplateTest : public ::testing::Test {
+protected:
+    nlohmann::json context = R"({
+        "user": {
+            "id": 123,
+            "name": "Alice"
+        },
+        "preferences": {
+            "theme": "dark",
+            "notifications": true
+        },
+        "items": ["first", "second"]
+    })"_json;
+
+    nlohmann::json llm_template = R"({
+        "model": "gpt-4",
+        "user_id": "${/user/id}",
+        "settings": "${/preferences}",
+        "messages": [
+            {"role": "system", "content": "You are helpful."},
+            {"role": "user", "content": "${/items/1}"}
+        ],
+        "missing": "${/user/missing}",
+        "literal": {"nested": [1, 2, {"deep": true}]}
+    })"_json;
+};
+
+TEST_F(CompiledTemplateTest, MatchesApply) {
+    CompiledTemplate compiled(llm_template);
+
+    EXPECT_EQ(compiled.apply(context), permuto::apply(llm_template, context));
+}
+
+TEST_F(CompiledTemplateTest, ReusableAcrossContexts) {
+    CompiledTemplate compiled(llm_template);
+
+    nlohmann::json other_context = context;
+    other_context["user"]["id"] = 456;
+    other_context["items"][1] = "other";
+
+    auto first = compiled.apply(context);
+    auto second = compiled.apply(other_context);
+
+    EXPECT_EQ(first["user_id"], 123);
+    EXPECT_EQ(first["messages"][1]["content"], "second");
+    EXPECT_EQ(second["user_id"], 456);
+    EXPECT_EQ(second["messages"][1]["content"], "other");
+    EXPECT_EQ(second["literal"], llm_template["literal"]);
+}
+
+TEST_F(CompiledTemplateTest, Interpolation) {
+    Options opts;
+    opts.enable_interpolation = true;
+
+    nlohmann::json template_json = R"({
+        "greeting": "Hello ${/user/name}, id ${/user/id}!",
+        "exact": "${/user/id}",
+        "missing": "Value: ${/user/missing} end",
+        "object": "Prefs: ${/preferences}",
+        "plain": "no placeholders"
+    })"_json;
+
+    CompiledTemplate compiled(template_json, opts);
+    auto result = compiled.apply(context);
+
+    EXPECT_EQ(result, permuto::apply(template_json, context, opts));
+    EXPECT_EQ(result["greeting"], "Hello Alice, id 123!");
+    EXPECT_EQ(result["exact"], 123);
+    EXPECT_EQ(result["missing"], "Value: ${/user/missing} end");
+}
+
+TEST_F(CompiledTemplateTest, RemoveMode) {
+    Options opts;
+    opts.missing_key_behavior = MissingKeyBehavior::Remove;
+
+    nlohmann::json template_json = R"({
+        "name": "${/user/name}",
+        "temperature": "${/config/temperature}",
+        "middleware": ["auth", "${/config/cache}", "${/items/0}"]
+    })"_json;
+
+    CompiledTemplate compiled(template_json, opts);
+    auto result = compiled.apply(context);
+
+    EXPECT_EQ(result, permuto::apply(template_json, context, opts));
+    EXPECT_FALSE(result.contains("temperature"));
+    EXPECT_EQ(result["middleware"].size(), 2);
+}
+
+TEST_F(CompiledTemplateTest, RemoveModeRootLevelError) {
+    Options opts;
+    opts.missing_key_behavior = MissingKeyBehavior::Remove;
+
+    EXPECT_THROW(CompiledTemplate(nlohmann::json("${/user/name}"), opts), std::invalid_argument);
+}
+
+TEST_F(CompiledTemplateTest, MissingKeyError) {
+    Options opts;
+    opts.missing_key_behavior = MissingKeyBehavior::Error;
+
+    CompiledTemplate compiled(llm_template, opts);
+
+    try {
+        compiled.apply(context);
+        FAIL() << "Expected MissingKeyException";
+    } catch (const MissingKeyException& e) {
+        EXPECT_EQ(e.key_path(), "/user/missing");
+    }
+}
+
+TEST_F(CompiledTemplateTest, RecursionLimit) {
+    Options opts;
+    opts.max_recursion_depth = 2;
+
+    nlohmann::json deep_template = R"({"level1": {"level2": {"level3": "literal"}}})"_json;
+    CompiledTemplate compiled(deep_template, opts);
+
+    try {
+        compiled.apply(context);
+        FAIL() << "Expected RecursionLimitException";
+    } catch (const RecursionLimitException& e) {
+        EXPECT_EQ(e.depth(), 2);
+    }
+}
+
+TEST_F(CompiledTemplateTest, VeryDeepTemplateStopsAtTheLimit) {
+    // Far deeper than native recursion over every level could go
+    const size_t depth = 300000;
+    nlohmann::json deep_template = nlohmann::json::parse(std::string(depth, '[') + std::string(depth, ']'));
+    Options opts;
+
+    CompiledTemplate compiled(deep_template, opts);
+
+    try {
+        compiled.apply(context);
+        FAIL() << "Expected RecursionLimitException";
+    } catch (const RecursionLimitException& e) {
+        EXPECT_EQ(e.depth(), opts.max_recursion_depth);
+    }
+    std::string output;
+    StringSink sink(output);
+    EXPECT_THROW(compiled.render(context, sink), RecursionLimitException);
+}
+
+TEST_F(CompiledTemplateTest, InvalidOptions) {
+    Options opts;
+    opts.start_marker = "";
+
+    EXPECT_THROW(CompiledTemplate(llm_template, opts), std::invalid_argument);
+}
+
+TEST_F(CompiledTemplateTest, IterativeEngineRejected) {
+    Options opts;
+    opts.engine = ProcessingEngine::Iterative;
+
+    EXPECT_THROW(CompiledTemplate(llm_template, opts), std::invalid_argument);
+    EXPECT_THROW(TemplateArtifact::serialize(llm_template, opts), std::invalid_argument);
+
+    // Batches of an uncompiled template are processed with the engine instead
+    std::vector<nlohmann::json> contexts(3, context);
+    auto results = permuto::apply_batch(llm_template, contexts, opts);
+    ASSERT_EQ(results.size(), contexts.size());
+    for (const auto& result : results) {
+        ASSERT_TRUE(result.ok());
+        EXPECT_EQ(result.result, permuto::apply(llm_template, context));
+    }
+}
+
+TEST_F(CompiledTemplateTest, RecursiveExpansionMatchesApply) {
+    nlohmann::json layered = R"({
+        "name": "${/user/name}",
+        "user": {"name": "Alice", "label": "User ${/name}"},
+        "loop": "${/loop}"
+    })"_json;
+    nlohmann::json template_json = R"({"user": "${/user}", "text": "Hi ${/name}", "missing": "${/nope}"})"_json;
+
+    Options opts;
+    opts.enable_interpolation = true;
+    opts.recursive_expansion = true;
+    CompiledTemplate compiled(template_json, opts);
+
+    auto result = compiled.apply(layered);
+    EXPECT_EQ(result, permuto::apply(template_json, layered, opts));
+    EXPECT_EQ(result["user"]["label"], "User Alice");
+    EXPECT_EQ(result["text"], "Hi Alice");
+
+    EXPECT_THROW(CompiledTemplate(nlohmann::json("${/loop}"), opts).apply(layered), CycleException);
+}
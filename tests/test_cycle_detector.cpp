@@ -85,4 +85,37 @@ TEST_F(CycleDetectorTest, EmptyPopPath) {
     // Should not crash when popping from empty stack
     detector.pop_path();
     EXPECT_TRUE(detector.get_current_path().empty());
-}
\ No newline at end of file
+}
+
+TEST_F(CycleDetectorTest, ComparesPathContentNotStorage) {
+    std::string pushed = "/user/name";
+    std::string probe = "/user/name";
+    ASSERT_NE(pushed.data(), probe.data());
+    
+    detector.push_path(pushed);
+    EXPECT_TRUE(detector.would_create_cycle(probe));
+    EXPECT_FALSE(detector.would_create_cycle("/user/nam"));
+}
+
+TEST_F(CycleDetectorTest, StackDeeperThanInlineCapacity) {
+    std::vector<std::string> paths;
+    for (int i = 0; i < 40; ++i) {
+        paths.push_back("/level" + std::to_string(i));
+    }
+    for (const auto& path : paths) {
+        EXPECT_FALSE(detector.would_create_cycle(path));
+        detector.push_path(path);
+    }
+    
+    EXPECT_TRUE(detector.would_create_cycle("/level3"));
+    EXPECT_TRUE(detector.would_create_cycle("/level39"));
+    EXPECT_EQ(detector.get_current_path(), paths);
+    
+    for (int i = 0; i < 30; ++i) {
+        detector.pop_path();
+    }
+    EXPECT_TRUE(detector.would_create_cycle("/level9"));
+    EXPECT_FALSE(detector.would_create_cycle("/level10"));
+    EXPECT_FALSE(detector.would_create_cycle("/level39"));
+    ASSERT_EQ(detector.get_current_path().size(), 10);
+}
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include "../cli/file_loader.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace permuto::cli;
+
+namespace {
+    void write_file(const std::filesystem::path& path, const std::string& contents) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << contents;
+    }
+
+    std::string read_file(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+}
+
+class FileLoaderTest : public ::testing::Test {
+protected:
+    std::filesystem::path directory;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        directory = std::filesystem::temp_directory_path() /
+                    (std::string("permuto_file_loader_") + info->name());
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(directory);
+    }
+};
+
+TEST_F(FileLoaderTest, RegularFilesAreMapped) {
+    auto path = directory / "template.json";
+    write_file(path, R"({"a": [1, 2, 3]})");
+
+    FileContents contents(path.string());
+
+    EXPECT_EQ(contents.data(), R"({"a": [1, 2, 3]})");
+#if !defined(_WIN32)
+    EXPECT_TRUE(contents.is_mapped());
+#endif
+    EXPECT_TRUE(is_regular_file(path.string()));
+}
+
+TEST_F(FileLoaderTest, EmptyFilesAreRead) {
+    auto path = directory / "empty.json";
+    write_file(path, "");
+
+    FileContents contents(path.string());
+
+    EXPECT_TRUE(contents.data().empty());
+    EXPECT_FALSE(contents.is_mapped());
+    EXPECT_THROW(load_json_file(path.string()), nlohmann::json::parse_error);
+}
+
+#if defined(__linux__)
+TEST_F(FileLoaderTest, ProcFilesAreReadDespiteTheirSize) {
+    // stat reports 0 bytes, but reading returns the contents
+    FileContents contents("/proc/self/status");
+
+    EXPECT_FALSE(contents.is_mapped());
+    EXPECT_NE(contents.data().find("Name:"), std::string_view::npos);
+}
+#endif
+
+#if !defined(_WIN32)
+TEST_F(FileLoaderTest, StandardInput) {
+    auto path = directory / "input.json";
+    write_file(path, R"({"from": "stdin"})");
+    int saved = ::dup(STDIN_FILENO);
+    int input = ::open(path.c_str(), O_RDONLY);
+    ASSERT_GE(input, 0);
+    ::dup2(input, STDIN_FILENO);
+    ::close(input);
+
+    nlohmann::json loaded;
+    EXPECT_NO_THROW(loaded = load_json_file(STDIN_FILE_NAME));
+    ::dup2(saved, STDIN_FILENO);
+    ::close(saved);
+
+    EXPECT_EQ(loaded, nlohmann::json({{"from", "stdin"}}));
+    EXPECT_FALSE(is_regular_file(STDIN_FILE_NAME));
+}
+#endif
+
+TEST_F(FileLoaderTest, MissingFileThrows) {
+    auto path = directory / "missing.json";
+
+    EXPECT_THROW(FileContents{path.string()}, std::runtime_error);
+    EXPECT_FALSE(is_regular_file(path.string()));
+}
+
+TEST_F(FileLoaderTest, LoadsBinaryFormats) {
+    nlohmann::json value = {{"name", "Ada"}, {"ids", {1, 2}}};
+    auto path = directory / "context.cbor";
+    auto bytes = nlohmann::json::to_cbor(value);
+    write_file(path, std::string(bytes.begin(), bytes.end()));
+
+    EXPECT_EQ(load_json_file(path.string(), permuto::Format::Cbor), value);
+    EXPECT_THROW(load_json_file(path.string()), nlohmann::json::parse_error);
+}
+
+TEST_F(FileLoaderTest, ReplaceFileKeepsMappedContents) {
+    auto path = directory / "template.ptc";
+    write_file(path, "old contents");
+    FileContents old_contents(path.string());
+
+    replace_file(path.string(), "new contents, longer");
+
+    EXPECT_EQ(read_file(path), "new contents, longer");
+    EXPECT_EQ(old_contents.data(), "old contents");
+    EXPECT_FALSE(std::filesystem::exists(path.string() + ".tmp"));
+}
+
+TEST_F(FileLoaderTest, ReplaceFileReportsFailure) {
+    auto path = directory / "missing_directory" / "template.ptc";
+
+    EXPECT_THROW(replace_file(path.string(), "data"), std::runtime_error);
+    EXPECT_FALSE(std::filesystem::exists(path));
+}
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include <permuto/permuto.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace permuto;
+
+class FormatsTest : public ::testing::Test {
+protected:
+    nlohmann::json context = R"({
+        "user": {"id": 123, "name": "Alice", "score": 0.5},
+        "model": "claude-3-sonnet-20240229",
+        "history": [{"role": "user", "content": "Hi"}, {"role": "assistant", "content": "Hello!"}]
+    })"_json;
+
+    nlohmann::json request_template = R"({
+        "model": "${/model}",
+        "max_tokens": 1024,
+        "messages": "${/history}",
+        "metadata": {"user_id": "${/user/id}", "missing": "${/user/missing}"},
+        "system": "You are talking to ${/user/name}."
+    })"_json;
+
+    const std::vector<Format> binary_formats = {
+        Format::Cbor, Format::MessagePack, Format::Bson, Format::Ubjson
+    };
+
+    static std::string to_bytes(const std::vector<std::uint8_t>& bytes) {
+        return std::string(bytes.begin(), bytes.end());
+    }
+
+    // What the nlohmann encoder for format produces
+    static std::string reference_encoding(const nlohmann::json& value, Format format) {
+        switch (format) {
+            case Format::Cbor:
+                return to_bytes(nlohmann::json::to_cbor(value));
+            case Format::MessagePack:
+                return to_bytes(nlohmann::json::to_msgpack(value));
+            case Format::Bson:
+                return to_bytes(nlohmann::json::to_bson(value));
+            case Format::Ubjson:
+                return to_bytes(nlohmann::json::to_ubjson(value));
+            case Format::Json:
+                break;
+        }
+        return value.dump();
+    }
+
+    static std::string encode_to_string(const nlohmann::json& value, Format format, int indent = -1) {
+        std::string output;
+        StringSink sink(output);
+        encode(value, format, sink, indent);
+        return output;
+    }
+};
+
+TEST_F(FormatsTest, EncodeMatchesNlohmannAndDecodes) {
+    for (Format format : binary_formats) {
+        std::string bytes = encode_to_string(request_template, format);
+        EXPECT_EQ(bytes, reference_encoding(request_template, format));
+        EXPECT_EQ(decode(bytes, format), request_template);
+    }
+
+    EXPECT_EQ(encode_to_string(request_template, Format::Json, 2), request_template.dump(2));
+    EXPECT_EQ(decode(request_template.dump(), Format::Json), request_template);
+}
+
+TEST_F(FormatsTest, EncodeLargeValuesInChunks) {
+    nlohmann::json large = {{"blob", std::string(100000, 'x')}, {"items", nlohmann::json::array()}};
+    for (int i = 0; i < 5000; ++i) {
+        large["items"].push_back({{"id", i}, {"name", "item " + std::to_string(i)}});
+    }
+
+    for (Format format : binary_formats) {
+        std::string collected;
+        size_t chunks = 0;
+        CallbackSink sink([&](std::string_view chunk) {
+            collected.append(chunk);
+            ++chunks;
+        });
+        encode(large, format, sink);
+        EXPECT_EQ(collected, reference_encoding(large, format));
+        EXPECT_GT(chunks, 1u);
+    }
+
+    // Errors of the sink reach the caller unchanged
+    CallbackSink failing([](std::string_view) { throw std::length_error("sink full"); });
+    EXPECT_THROW(encode(large, Format::Cbor, failing), std::length_error);
+}
+
+TEST_F(FormatsTest, RenderWritesResultInFormat) {
+    Options opts;
+    opts.enable_interpolation = true;
+    nlohmann::json expected = permuto::apply(request_template, context, opts);
+
+    for (Format format : binary_formats) {
+        std::string output;
+        StringSink sink(output);
+        render(request_template, context, opts, sink, format);
+        EXPECT_EQ(output, reference_encoding(expected, format));
+    }
+
+    std::string text;
+    StringSink text_sink(text);
+    render(request_template, context, opts, text_sink, Format::Json);
+    EXPECT_EQ(text, expected.dump());
+}
+
+TEST_F(FormatsTest, RenderStreamReadsBinaryTemplates) {
+    Options opts;
+    opts.enable_interpolation = true;
+    std::string expected = permuto::apply(request_template, context, opts).dump(2);
+
+    for (Format format : binary_formats) {
+        std::string bytes = reference_encoding(request_template, format);
+
+        std::string output;
+        StringSink sink(output);
+        render_stream(bytes, format, context, opts, sink, 2);
+        EXPECT_EQ(output, expected);
+
+        std::istringstream input(bytes);
+        std::string streamed;
+        StringSink stream_sink(streamed);
+        render_stream(input, format, context, opts, stream_sink, 2);
+        EXPECT_EQ(streamed, expected);
+    }
+}
+
+TEST_F(FormatsTest, BinaryValuesPassThrough) {
+    nlohmann::json template_json = {
+        {"blob", nlohmann::json::binary({0x00, 0xff, 0x10})},
+        {"id", "${/user/id}"}
+    };
+    std::string bytes = reference_encoding(template_json, Format::Cbor);
+
+    std::string output;
+    StringSink sink(output);
+    render(decode(bytes, Format::Cbor), context, Options{}, sink, Format::Cbor);
+    EXPECT_EQ(decode(output, Format::Cbor), permuto::apply(template_json, context));
+}
+
+TEST_F(FormatsTest, Errors) {
+    std::string bytes = reference_encoding(request_template, Format::Cbor);
+    std::string truncated = bytes.substr(0, bytes.size() / 2);
+    EXPECT_THROW(decode(truncated, Format::Cbor), nlohmann::json::parse_error);
+
+    std::string output;
+    StringSink sink(output);
+    EXPECT_THROW(render_stream(truncated, Format::Cbor, context, Options{}, sink),
+                 nlohmann::json::parse_error);
+
+    // BSON documents are objects
+    EXPECT_THROW(encode(nlohmann::json::array({1, 2}), Format::Bson, sink), nlohmann::json::type_error);
+}
@@ -324,4 +324,52 @@ TEST_F(IntegrationTest, MixedModeWorkflow) {
     
     auto step1_incomplete = permuto::apply(workflow_template, incomplete_context, remove_opts);
     EXPECT_THROW(permuto::apply(step1_incomplete, incomplete_context, error_opts), MissingKeyException);
-}
\ No newline at end of file
+}
+
+TEST_F(IntegrationTest, ConsumingOverloads) {
+    auto expected = permuto::apply(api_template, context);
+    
+    nlohmann::json owned_context = context;
+    EXPECT_EQ(permuto::apply(api_template, std::move(owned_context)), expected);
+    
+    nlohmann::json owned_template = api_template;
+    EXPECT_EQ(permuto::apply(std::move(owned_template), context), expected);
+    
+    nlohmann::json both_template = api_template;
+    nlohmann::json both_context = context;
+    EXPECT_EQ(permuto::apply(std::move(both_template), std::move(both_context)), expected);
+    
+    auto reverse_template = permuto::create_reverse_template(api_template);
+    EXPECT_EQ(permuto::apply_reverse(reverse_template, nlohmann::json(expected)), context);
+    
+    Options remove_opts;
+    remove_opts.missing_key_behavior = MissingKeyBehavior::Remove;
+    EXPECT_THROW(permuto::apply(nlohmann::json("${/user_input}"), nlohmann::json(context), remove_opts),
+                 std::invalid_argument);
+}
+
+TEST_F(IntegrationTest, ApplyInplace) {
+    nlohmann::json doc = api_template;
+    permuto::apply_inplace(doc, context);
+    EXPECT_EQ(doc, permuto::apply(api_template, context));
+    
+    // Remove mode erases keys and array elements from the document
+    Options remove_opts;
+    remove_opts.missing_key_behavior = MissingKeyBehavior::Remove;
+    
+    nlohmann::json remove_doc = R"({
+        "model": "${/config/model}",
+        "top_p": "${/config/top_p}",
+        "stop": ["${/config/stop}", "END", "${/user_input}"]
+    })"_json;
+    permuto::apply_inplace(remove_doc, context, remove_opts);
+    
+    EXPECT_EQ(remove_doc["model"], "gpt-4");
+    EXPECT_FALSE(remove_doc.contains("top_p"));
+    ASSERT_EQ(remove_doc["stop"].size(), 2);
+    EXPECT_EQ(remove_doc["stop"][0], "END");
+    EXPECT_EQ(remove_doc["stop"][1], "Hello, world!");
+    
+    nlohmann::json root_doc = "${/config/model}";
+    EXPECT_THROW(permuto::apply_inplace(root_doc, context, remove_opts), std::invalid_argument);
+}
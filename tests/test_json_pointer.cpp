@@ -98,4 +98,60 @@ TEST_F(JsonPointerTest, InvalidArrayIndex) {
 TEST_F(JsonPointerTest, InvalidPath) {
     EXPECT_THROW(JsonPointer("invalid"), std::invalid_argument);
     EXPECT_THROW(JsonPointer("missing_slash"), std::invalid_argument);
-}
\ No newline at end of file
+}
+
+TEST_F(JsonPointerTest, PreParsedIndices) {
+    JsonPointer pointer("/items/1/value");
+    ASSERT_EQ(pointer.indices().size(), 3);
+    EXPECT_EQ(pointer.indices()[0], JsonPointer::NO_INDEX);
+    EXPECT_EQ(pointer.indices()[1], 1);
+    EXPECT_EQ(pointer.indices()[2], JsonPointer::NO_INDEX);
+    
+    // Overflowing indices never resolve
+    JsonPointer overflow("/items/99999999999999999999999");
+    EXPECT_EQ(overflow.indices()[1], JsonPointer::NO_INDEX);
+    EXPECT_FALSE(overflow.resolve(test_data).has_value());
+}
+
+TEST_F(JsonPointerTest, InternedPointersAreShared) {
+    PointerRef first = intern_pointer("/user/settings/theme");
+    PointerRef second = PointerTable::instance().intern("/user/settings/theme");
+    
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(first->path(), "/user/settings/theme");
+    
+    auto result = second->resolve(test_data);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(*result, "dark");
+}
+
+TEST_F(JsonPointerTest, InternTableIsBounded) {
+    PointerRef held = intern_pointer("/user/settings/theme");
+    
+    for (size_t i = 0; i < 2 * PointerTable::CAPACITY; ++i) {
+        intern_pointer("/bounded/" + std::to_string(i));
+        EXPECT_LE(PointerTable::instance().size(), PointerTable::CAPACITY);
+    }
+    
+    // Pointers handed out before the table was emptied stay usable
+    EXPECT_EQ(held->path(), "/user/settings/theme");
+    EXPECT_EQ(*held->find(test_data), "dark");
+    EXPECT_EQ(intern_pointer("/user/settings/theme")->path(), held->path());
+}
+
+TEST_F(JsonPointerTest, InternInvalidPath) {
+    size_t size_before = PointerTable::instance().size();
+    EXPECT_THROW(intern_pointer("invalid"), std::invalid_argument);
+    EXPECT_EQ(PointerTable::instance().size(), size_before);
+}
+
+TEST_F(JsonPointerTest, FindBorrowsFromContext) {
+    JsonPointer pointer("/user/settings");
+    const nlohmann::json* found = pointer.find(test_data);
+    ASSERT_NE(found, nullptr);
+    EXPECT_EQ(found, &test_data["user"]["settings"]);
+    
+    EXPECT_EQ(JsonPointer("").find(test_data), &test_data);
+    EXPECT_EQ(JsonPointer("/user/missing").find(test_data), nullptr);
+    EXPECT_EQ(JsonPointer("/items/5").find(test_data), nullptr);
+}
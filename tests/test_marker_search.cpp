@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include "../src/marker_search.hpp"
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace permuto;
+
+namespace {
+    using FindMarkerFn = size_t (*)(std::string_view, size_t, std::string_view);
+
+    const size_t RANDOM_TEXT_COUNT = 200;
+    const size_t MAX_RANDOM_TEXT_LENGTH = 300;
+}
+
+class MarkerSearchTest : public ::testing::Test {
+protected:
+    // Every implementation this CPU can run
+    std::vector<std::pair<std::string, FindMarkerFn>> implementations() const {
+        std::vector<std::pair<std::string, FindMarkerFn>> result;
+        result.emplace_back("scalar", find_marker_scalar);
+#if PERMUTO_HAS_X86_SIMD
+        result.emplace_back("sse2", find_marker_sse2);
+        if (cpu_supports_avx2()) {
+            result.emplace_back("avx2", find_marker_avx2);
+        }
+#endif
+        result.emplace_back("dispatched", find_marker);
+        return result;
+    }
+
+    void expect_like_find(const std::string& text, size_t from, const std::string& marker) const {
+        size_t expected = std::string_view(text).find(marker, from);
+        for (const auto& [name, fn] : implementations()) {
+            EXPECT_EQ(fn(text, from, marker), expected)
+                << name << " text='" << text << "' from=" << from << " marker='" << marker << "'";
+        }
+    }
+};
+
+TEST_F(MarkerSearchTest, BasicMatches) {
+    expect_like_find("Hello ${/user/name}!", 0, "${");
+    expect_like_find("Hello ${/user/name}!", 0, "}");
+    expect_like_find("Hello ${/user/name}!", 7, "${");
+    expect_like_find("no markers here", 0, "${");
+    expect_like_find("${", 0, "${");
+    expect_like_find("$", 0, "${");
+    expect_like_find("", 0, "${");
+}
+
+TEST_F(MarkerSearchTest, FromPastEnd) {
+    expect_like_find("abc", 3, "c");
+    expect_like_find("abc", 4, "c");
+}
+
+TEST_F(MarkerSearchTest, MatchesAcrossBlockBoundaries) {
+    // Place the marker at every offset around the 16 and 32 byte block sizes
+    for (const std::string marker : {"${", "}", "{{", "<<<", "[[placeholder:"}) {
+        for (size_t pos = 0; pos < 70; ++pos) {
+            std::string text(pos, 'x');
+            text += marker;
+            text += std::string(40, 'y');
+            expect_like_find(text, 0, marker);
+            expect_like_find(text, pos, marker);
+            expect_like_find(text, pos + 1, marker);
+        }
+    }
+}
+
+TEST_F(MarkerSearchTest, MarkerAtEndOfText) {
+    for (size_t length = 0; length < 70; ++length) {
+        std::string text(length, 'a');
+        text += "}}";
+        expect_like_find(text, 0, "}}");
+        expect_like_find(text, 0, "}}}");
+    }
+}
+
+TEST_F(MarkerSearchTest, FirstAndLastByteDecoys) {
+    // Candidates matching the first and last byte but not the middle
+    std::string text;
+    for (int i = 0; i < 20; ++i) {
+        text += "<%x%> <%%> <%%%> ";
+    }
+    expect_like_find(text, 0, "<%%%>");
+    expect_like_find(text, 0, "<%y%>");
+    text += "<%y%>";
+    expect_like_find(text, 0, "<%y%>");
+}
+
+TEST_F(MarkerSearchTest, RepeatedMarkerBytes) {
+    expect_like_find(std::string(100, '$') + "{", 0, "${");
+    expect_like_find(std::string(100, '{'), 0, "{{");
+    expect_like_find(std::string(100, '{'), 37, "{{");
+}
+
+TEST_F(MarkerSearchTest, RandomTextsMatchFind) {
+    // Small alphabet so markers occur often
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> length_dist(0, MAX_RANDOM_TEXT_LENGTH);
+    std::uniform_int_distribution<int> char_dist(0, 3);
+    const char alphabet[] = {'$', '{', '}', 'a'};
+
+    for (size_t n = 0; n < RANDOM_TEXT_COUNT; ++n) {
+        std::string text(length_dist(rng), ' ');
+        for (char& c : text) {
+            c = alphabet[char_dist(rng)];
+        }
+        for (const std::string marker : {"${", "}", "{{", "${a", "a}}$"}) {
+            expect_like_find(text, 0, marker);
+            expect_like_find(text, text.size() / 2, marker);
+        }
+    }
+}
+
+TEST_F(MarkerSearchTest, NonAsciiBytes) {
+    std::string text = "caf\xc3\xa9 \xe2\x80\x9c\xc2\xab\xc2\xbb";
+    expect_like_find(text, 0, "\xc2\xab");
+    expect_like_find(text, 0, "\xc2\xbb");
+}
+
+TEST_F(MarkerSearchTest, ActiveImplementation) {
+#if PERMUTO_HAS_X86_SIMD
+    auto expected = cpu_supports_avx2() ? MarkerSearchImpl::AVX2 : MarkerSearchImpl::SSE2;
+    EXPECT_EQ(active_marker_search(), expected);
+#else
+    EXPECT_EQ(active_marker_search(), MarkerSearchImpl::Scalar);
+#endif
+}
@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include "../include/permuto/permuto.hpp"
+#include "../src/multi_marker_parser.hpp"
+#include "../src/placeholder_parser.hpp"
+#include <algorithm>
+#include <random>
+
+using namespace permuto;
+
+namespace {
+    // Placeholders as (marker set, path, start, end) for easy comparison
+    using Found = std::tuple<size_t, std::string, size_t, size_t>;
+    
+    std::vector<Found> scan(const MultiMarkerParser& parser, std::string_view text) {
+        std::vector<Found> found;
+        for (const auto& placeholder : parser.find_placeholders(text)) {
+            found.emplace_back(placeholder.marker_set, placeholder.path,
+                               placeholder.start_pos, placeholder.end_pos);
+        }
+        return found;
+    }
+    
+    std::vector<Found> scan_each_set(const std::vector<MarkerPair>& pairs, std::string_view text) {
+        std::vector<Found> found;
+        for (size_t set = 0; set < pairs.size(); ++set) {
+            PlaceholderParser parser(pairs[set].start_marker, pairs[set].end_marker);
+            for (const auto& placeholder : parser.find_placeholders(text)) {
+                found.emplace_back(set, placeholder.path, placeholder.start_pos, placeholder.end_pos);
+            }
+        }
+        std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) {
+            return std::get<2>(a) < std::get<2>(b);
+        });
+        return found;
+    }
+}
+
+TEST(MultiMarkerParserTest, SingleSetMatchesPlaceholderParser) {
+    std::vector<MarkerPair> pairs = {{"${", "}"}};
+    MultiMarkerParser parser(pairs);
+    
+    for (std::string text : {"", "plain", "${/a}", "x ${/a} y ${/b/c}", "${a} ${/ok}", "${/open",
+                             "${/a}${/b}", "${${/x}}", "$${/x}", "${}", "end ${"}) {
+        EXPECT_EQ(scan(parser, text), scan_each_set(pairs, text)) << text;
+    }
+}
+
+TEST(MultiMarkerParserTest, MixedMarkersInOneScan) {
+    MultiMarkerParser parser({{"${", "}"}, {"#{", "}"}, {"<<", ">>"}});
+    
+    auto found = scan(parser, "Hi ${/user/name}, model #{/model} at <</time>> and #{/bad");
+    ASSERT_EQ(found.size(), 3);
+    EXPECT_EQ(found[0], Found(0, "/user/name", 3, 16));
+    EXPECT_EQ(found[1], Found(1, "/model", 24, 33));
+    EXPECT_EQ(found[2], Found(2, "/time", 37, 46));
+}
+
+TEST(MultiMarkerParserTest, UnionOfPerSetScans) {
+    std::vector<MarkerPair> pairs = {{"${", "}"}, {"#{", "}"}, {"@<", ">@"}, {"{{", "}}"}};
+    MultiMarkerParser parser(pairs);
+    
+    // Random text assembled from non-overlapping placeholders and filler
+    std::mt19937 rng(7);
+    std::vector<std::string> pieces = {"${/a}", "#{/b/0}", "@</c>@", "{{/d}}", "text ", "$ ", "# ", "{ ", "@ "};
+    for (int round = 0; round < 200; ++round) {
+        std::string text;
+        for (int i = 0; i < 60; ++i) {
+            text += pieces[rng() % pieces.size()];
+        }
+        EXPECT_EQ(scan(parser, text), scan_each_set(pairs, text)) << text;
+    }
+}
+
+TEST(MultiMarkerParserTest, LeftmostThenLongestStartMarker) {
+    // "{{" and "{" both start at 0; the longer marker wins
+    MultiMarkerParser nested({{"{", "}"}, {"{{", "}}"}});
+    EXPECT_EQ(scan(nested, "{{/a}}"), (std::vector<Found>{{1, "/a", 0, 6}}));
+    
+    // "c" is seen first while scanning, but "abc" starts earlier
+    MultiMarkerParser overlapping({{"c", "!"}, {"abc", "!"}});
+    EXPECT_EQ(scan(overlapping, "xabc/p! c/q!"), (std::vector<Found>{{1, "/p", 1, 7}, {0, "/q", 8, 12}}));
+}
+
+TEST(MultiMarkerParserTest, UnclosedPairDoesNotHideOthers) {
+    MultiMarkerParser parser({{"#{", "]"}, {"${", "}"}});
+    
+    // PlaceholderParser stops at an unclosed start marker; other pairs go on
+    EXPECT_EQ(scan(parser, "#{/never ${/a} #{/again ${/b}"),
+              (std::vector<Found>{{1, "/a", 9, 14}, {1, "/b", 24, 29}}));
+}
+
+TEST(MultiMarkerParserTest, AppendReplacedMapsSetsToContexts) {
+    MultiMarkerParser parser({{"${", "}"}, {"#{", "}"}});
+    std::vector<nlohmann::json> contexts = {
+        R"({"user": "Alice"})"_json,
+        R"({"user": "model-7"})"_json
+    };
+    
+    std::string out;
+    size_t count = parser.append_replaced("${/user} asks #{/user}", out,
+        [&](size_t set, std::string_view path, std::string& buffer) {
+            buffer += contexts[set][nlohmann::json::json_pointer(std::string(path))].get<std::string>();
+        });
+    
+    EXPECT_EQ(count, 2);
+    EXPECT_EQ(out, "Alice asks model-7");
+}
+
+TEST(MultiMarkerParserTest, InvalidMarkerSets) {
+    EXPECT_THROW(MultiMarkerParser(std::vector<MarkerPair>{}), std::invalid_argument);
+    EXPECT_THROW(MultiMarkerParser(std::vector<MarkerPair>{{"", "}"}}), std::invalid_argument);
+    EXPECT_THROW(MultiMarkerParser(std::vector<MarkerPair>{{"${", "${"}}), std::invalid_argument);
+    EXPECT_THROW(MultiMarkerParser({{"${", "}"}, {"${", "]"}}), std::invalid_argument);
+    EXPECT_THROW(MultiMarkerParser(std::vector<MarkerPair>(65, {"${", "}"})), std::invalid_argument);
+}
+
+TEST(MultiMarkerParserTest, ExactPlaceholderPicksLongestStartMarker) {
+    MultiMarkerParser parser({{"{", "}"}, {"{{", "}}"}, {"#{", "]"}});
+    size_t set = 0;
+    
+    EXPECT_EQ(parser.extract_exact_placeholder("{{/a}}", set), std::string_view("/a"));
+    EXPECT_EQ(set, 1);
+    EXPECT_EQ(parser.extract_exact_placeholder("{/a}", set), std::string_view("/a"));
+    EXPECT_EQ(set, 0);
+    // Like PlaceholderParser, the path may contain the end marker
+    EXPECT_EQ(parser.extract_exact_placeholder("#{/a]b]", set), std::string_view("/a]b"));
+    EXPECT_EQ(set, 2);
+    EXPECT_FALSE(parser.extract_exact_placeholder("x{/a}", set));
+    EXPECT_FALSE(parser.extract_exact_placeholder("{a}", set));
+}
+
+class ApplyMultiTest : public ::testing::Test {
+protected:
+    nlohmann::json request = R"({"user": {"name": "Alice"}, "tags": ["a", "b"]})"_json;
+    nlohmann::json config = R"({"model": "m-7", "limits": {"tokens": 256}})"_json;
+    
+    std::vector<permuto::MarkerContext> contexts() const {
+        return {{"${", "}", &request}, {"#{", "}", &config}};
+    }
+};
+
+TEST_F(ApplyMultiTest, EachPairResolvesAgainstItsOwnContext) {
+    auto template_json = R"({
+        "user": "${/user/name}",
+        "model": "#{/model}",
+        "limits": "#{/limits}",
+        "tags": ["${/tags/1}", "#{/limits/tokens}", 3],
+        "prompt": "Hi ${/user/name} on #{/model}, max #{/limits/tokens}"
+    })"_json;
+    permuto::Options options;
+    options.enable_interpolation = true;
+    
+    auto result = permuto::apply_multi(template_json, contexts(), options);
+    
+    EXPECT_EQ(result, R"({
+        "user": "Alice",
+        "model": "m-7",
+        "limits": {"tokens": 256},
+        "tags": ["b", 256, 3],
+        "prompt": "Hi Alice on m-7, max 256"
+    })"_json);
+}
+
+TEST_F(ApplyMultiTest, MatchesOneApplyPerPair) {
+    auto template_json = R"({
+        "a": "${/user/name}",
+        "b": ["#{/model}", "${/missing}", "#{/missing}"],
+        "c": "x ${/tags/0} #{/limits/tokens} ${/nope} y",
+        "d": {"e": true}
+    })"_json;
+    permuto::Options options;
+    options.enable_interpolation = true;
+    permuto::Options hash_options = options;
+    hash_options.start_marker = "#{";
+    
+    auto expected = permuto::apply(permuto::apply(template_json, request, options), config, hash_options);
+    
+    EXPECT_EQ(permuto::apply_multi(template_json, contexts(), options), expected);
+}
+
+TEST_F(ApplyMultiTest, MissingKeyBehaviors) {
+    auto template_json = R"({"kept": "#{/model}", "gone": "${/missing}", "list": ["#{/missing}", "${/user/name}"]})"_json;
+    permuto::Options options;
+    
+    options.missing_key_behavior = permuto::MissingKeyBehavior::Remove;
+    EXPECT_EQ(permuto::apply_multi(template_json, contexts(), options),
+              R"({"kept": "m-7", "list": ["Alice"]})"_json);
+    EXPECT_THROW(permuto::apply_multi("#{/model}", contexts(), options), std::invalid_argument);
+    
+    options.missing_key_behavior = permuto::MissingKeyBehavior::Error;
+    try {
+        permuto::apply_multi(template_json, contexts(), options);
+        FAIL() << "Expected MissingKeyException";
+    } catch (const permuto::MissingKeyException& e) {
+        EXPECT_EQ(e.key_path(), "/missing");
+    }
+}
+
+TEST_F(ApplyMultiTest, RecursionLimit) {
+    permuto::Options options;
+    options.max_recursion_depth = 2;
+    
+    EXPECT_NO_THROW(permuto::apply_multi(R"({"a": "${/user}"})"_json, contexts(), options));
+    EXPECT_THROW(permuto::apply_multi(R"({"a": {"b": ["#{/model}"]}})"_json, contexts(), options),
+                 permuto::RecursionLimitException);
+}
+
+TEST_F(ApplyMultiTest, InvalidArguments) {
+    permuto::Options options;
+    EXPECT_THROW(permuto::apply_multi("x", {{"${", "}", nullptr}}, options), std::invalid_argument);
+    EXPECT_THROW(permuto::apply_multi("x", {{"${", "}", &request}, {"${", "]", &config}}, options),
+                 std::invalid_argument);
+    EXPECT_THROW(permuto::apply_multi("x", {}, options), std::invalid_argument);
+    
+    options.recursive_expansion = true;
+    EXPECT_THROW(permuto::apply_multi("x", contexts(), options), std::invalid_argument);
+    options.recursive_expansion = false;
+    options.engine = permuto::ProcessingEngine::Iterative;
+    EXPECT_THROW(permuto::apply_multi("x", contexts(), options), std::invalid_argument);
+}
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include "../cli/ndjson_stream.hpp"
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace permuto::cli;
+
+namespace {
+    const int RECORD_COUNT = 60;
+    const int FAILING_EVERY = 7;
+
+    std::vector<std::string> split_lines(const std::string& text) {
+        std::vector<std::string> lines;
+        std::istringstream stream(text);
+        std::string line;
+        while (std::getline(stream, line)) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    // Input with one {"n": i} record per line
+    std::string numbered_records(int count) {
+        std::string input;
+        for (int i = 0; i < count; ++i) {
+            input += "{\"n\": " + std::to_string(i) + "}\n";
+        }
+        return input;
+    }
+
+    // Records finish out of order: later ones are faster, every
+    // FAILING_EVERY-th one throws
+    void uneven_transform(const nlohmann::json& record, std::string& out) {
+        int n = record["n"].get<int>();
+        std::this_thread::sleep_for(std::chrono::microseconds((RECORD_COUNT - n) % 5 * 200));
+        if (n % FAILING_EVERY == 0) {
+            throw std::runtime_error("record " + std::to_string(n) + " failed");
+        }
+        out += nlohmann::json{{"m", n * 2}}.dump();
+    }
+
+    // Refuses every write
+    class FailingBuffer : public std::streambuf {
+    protected:
+        int_type overflow(int_type) override {
+            return traits_type::eof();
+        }
+
+        std::streamsize xsputn(const char*, std::streamsize) override {
+            return 0;
+        }
+    };
+}
+
+class NdjsonStreamTest : public ::testing::TestWithParam<NdjsonSettings> {
+protected:
+    void expect_in_order_with_failures(const std::string& output, const std::string& errors) {
+        auto lines = split_lines(output);
+        ASSERT_EQ(lines.size(), static_cast<size_t>(RECORD_COUNT));
+        std::vector<std::string> expected_errors;
+        for (int n = 0; n < RECORD_COUNT; ++n) {
+            if (n % FAILING_EVERY == 0) {
+                EXPECT_EQ(lines[n], "null") << "record " << n;
+                expected_errors.push_back("line " + std::to_string(n + 1) + ": record " +
+                                          std::to_string(n) + " failed");
+            } else {
+                EXPECT_EQ(lines[n], nlohmann::json({{"m", n * 2}}).dump()) << "record " << n;
+            }
+        }
+        EXPECT_EQ(split_lines(errors), expected_errors);
+    }
+};
+
+TEST_P(NdjsonStreamTest, OutOfOrderCompletionIsWrittenInInputOrder) {
+    std::istringstream in(numbered_records(RECORD_COUNT));
+    std::ostringstream out;
+    std::ostringstream errors;
+
+    auto summary = run_ndjson(in, out, errors, uneven_transform, GetParam());
+
+    EXPECT_EQ(summary.records, static_cast<size_t>(RECORD_COUNT));
+    EXPECT_EQ(summary.failures, static_cast<size_t>((RECORD_COUNT + FAILING_EVERY - 1) / FAILING_EVERY));
+    expect_in_order_with_failures(out.str(), errors.str());
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Settings, NdjsonStreamTest,
+    ::testing::Values(
+        NdjsonSettings{1, 0},   // One worker, default limit
+        NdjsonSettings{4, 0},   // Default limit, more than the input
+        NdjsonSettings{4, 3},   // Slot ring wraps many times
+        NdjsonSettings{3, 1}    // One record at a time
+    ),
+    [](const ::testing::TestParamInfo<NdjsonSettings>& info) {
+        return "Jobs" + std::to_string(info.param.jobs) + "InFlight" + std::to_string(info.param.max_in_flight);
+    });
+
+TEST(NdjsonStreamSingleTest, BlankAndInvalidLinesKeepLineNumbers) {
+    std::istringstream in("{\"n\": 1}\n\n   \n{not json\n{\"n\": 3}\n");
+    std::ostringstream out;
+    std::ostringstream errors;
+
+    auto summary = run_ndjson(in, out, errors, [](const nlohmann::json& record, std::string& text) {
+        text += record["n"].dump();
+    }, NdjsonSettings{2, 2});
+
+    EXPECT_EQ(summary.records, 3u);
+    EXPECT_EQ(summary.failures, 1u);
+    EXPECT_EQ(out.str(), "1\nnull\n3\n");
+    auto error_lines = split_lines(errors.str());
+    ASSERT_EQ(error_lines.size(), 1u);
+    EXPECT_EQ(error_lines[0].rfind("line 4: ", 0), 0u);
+}
+
+TEST(NdjsonStreamSingleTest, EmptyInput) {
+    std::istringstream in("");
+    std::ostringstream out;
+    std::ostringstream errors;
+
+    auto summary = run_ndjson(in, out, errors, uneven_transform, NdjsonSettings{2, 0});
+
+    EXPECT_EQ(summary.records, 0u);
+    EXPECT_EQ(summary.failures, 0u);
+    EXPECT_TRUE(out.str().empty());
+}
+
+TEST(NdjsonStreamSingleTest, WriteFailureStopsEveryThread) {
+    // Enough records to leave the reader blocked on the in-flight limit and
+    // the workers on a full output queue when the first write throws
+    std::istringstream in(numbered_records(1000));
+    FailingBuffer buffer;
+    std::ostream out(&buffer);
+    out.exceptions(std::ios::badbit);
+    std::ostringstream errors;
+
+    EXPECT_ANY_THROW(run_ndjson(in, out, errors, [](const nlohmann::json& record, std::string& text) {
+        text += record.dump();
+    }, NdjsonSettings{2, 4}));
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include <permuto/permuto.hpp>
+
+using namespace permuto;
+
+class PipelineTest : public ::testing::Test {
+protected:
+    nlohmann::json context = R"({
+        "the_model": "claude-3-sonnet-20240229",
+        "prompt": "What are the key benefits of declarative programming?",
+        "user": {"name": "Alice", "tags": ["admin", "beta"]},
+        "preferences": {"theme": "dark", "notifications": true}
+    })"_json;
+    
+    Options dollar_options;
+    Options hash_options;
+    
+    void SetUp() override {
+        hash_options.start_marker = "#{";
+    }
+    
+    // Reference result: every stage applied to the full output of the last
+    static nlohmann::json apply_sequentially(const std::vector<PipelineStage>& stages,
+                                             const nlohmann::json& context) {
+        nlohmann::json current = context;
+        for (const auto& stage : stages) {
+            current = permuto::apply(stage.template_json, current, stage.options);
+        }
+        return current;
+    }
+};
+
+TEST_F(PipelineTest, SingleStageMatchesApply) {
+    nlohmann::json template_json = R"({"model": "${/the_model}", "tags": "${/user/tags}"})"_json;
+    Pipeline pipeline({{template_json, dollar_options}});
+    
+    EXPECT_EQ(pipeline.size(), 1);
+    EXPECT_EQ(pipeline.apply(context), permuto::apply(template_json, context));
+}
+
+TEST_F(PipelineTest, MultiStageExample) {
+    Options error_options;
+    error_options.missing_key_behavior = MissingKeyBehavior::Error;
+    Options remove_options = hash_options;
+    remove_options.missing_key_behavior = MissingKeyBehavior::Remove;
+    
+    std::vector<PipelineStage> stages = {
+        {R"({"model_name": "${/the_model}", "prompt": "${/prompt}"})"_json, error_options},
+        {R"({
+            "model": "#{/model_name}",
+            "messages": [{"role": "user", "content": "#{/prompt}"}],
+            "temperature": "#{/temp}",
+            "max_tokens": 1000,
+            "stream": false
+        })"_json, remove_options}
+    };
+    
+    auto result = Pipeline(stages).apply(context);
+    EXPECT_EQ(result, apply_sequentially(stages, context));
+    EXPECT_EQ(result["model"], "claude-3-sonnet-20240229");
+    EXPECT_FALSE(result.contains("temperature"));
+}
+
+TEST_F(PipelineTest, PathsCrossEarlierPlaceholders) {
+    Options interpolation = hash_options;
+    interpolation.enable_interpolation = true;
+    
+    std::vector<PipelineStage> stages = {
+        {R"({
+            "settings": "${/preferences}",
+            "people": [{"name": "${/user/name}", "roles": "${/user/tags}"}],
+            "greeting": "${/missing}",
+            "literal": {"nested": [1, 2, 3]}
+        })"_json, dollar_options},
+        {R"json({
+            "theme": "#{/settings/theme}",
+            "first_role": "#{/people/0/roles/1}",
+            "person": "#{/people/0}",
+            "text": "#{/people/0/name} prefers #{/settings/theme} (#{/settings/missing})",
+            "kept": "#{/greeting}",
+            "literal": "#{/literal/nested/2}",
+            "past_string": "#{/greeting/x}"
+        })json"_json, interpolation}
+    };
+    
+    auto result = Pipeline(stages).apply(context);
+    EXPECT_EQ(result, apply_sequentially(stages, context));
+    EXPECT_EQ(result["first_role"], "beta");
+    EXPECT_EQ(result["kept"], "${/missing}");
+    EXPECT_EQ(result["text"], "Alice prefers dark (#{/settings/missing})");
+}
+
+TEST_F(PipelineTest, RemoveModeShiftsArrayIndices) {
+    Options remove_options;
+    remove_options.missing_key_behavior = MissingKeyBehavior::Remove;
+    
+    std::vector<PipelineStage> stages = {
+        {R"({"list": ["${/gone}", "${/user/name}", "literal", "${/also/gone}", "${/user/tags}"],
+             "dropped": "${/nope}"})"_json, remove_options},
+        {R"({
+            "a": "#{/list/0}",
+            "b": "#{/list/1}",
+            "c": "#{/list/2/1}",
+            "d": "#{/list/3}",
+            "e": "#{/dropped}",
+            "list": "#{/list}"
+        })"_json, hash_options}
+    };
+    
+    auto result = Pipeline(stages).apply(context);
+    EXPECT_EQ(result, apply_sequentially(stages, context));
+    EXPECT_EQ(result["a"], "Alice");
+    EXPECT_EQ(result["c"], "beta");
+    EXPECT_EQ(result["d"], "#{/list/3}");
+    EXPECT_EQ(result["e"], "#{/dropped}");
+}
+
+TEST_F(PipelineTest, ThreeStagesWithDistinctMarkers) {
+    Options at_options;
+    at_options.start_marker = "@{";
+    at_options.enable_interpolation = true;
+    
+    std::vector<PipelineStage> stages = {
+        {R"({"who": "${/user}", "mode": "${/preferences/theme}"})"_json, dollar_options},
+        {R"({"profile": {"name": "#{/who/name}", "mode": "#{/mode}"}, "all": "#{/who}"})"_json, hash_options},
+        {R"(["Hi @{/profile/name}, you use @{/profile/mode}", "@{/all/tags/0}", "@{/profile}"])"_json, at_options}
+    };
+    
+    auto result = Pipeline(stages).apply(context);
+    EXPECT_EQ(result, apply_sequentially(stages, context));
+    EXPECT_EQ(result[0], "Hi Alice, you use dark");
+}
+
+TEST_F(PipelineTest, RecursiveExpansionStage) {
+    Options recursive = dollar_options;
+    recursive.recursive_expansion = true;
+    
+    nlohmann::json layered = R"({"a": "${/b}", "b": {"c": "${/d}"}, "d": 5})"_json;
+    std::vector<PipelineStage> stages = {
+        {R"({"x": "${/a}"})"_json, recursive},
+        {R"({"y": "#{/x/c}", "z": "#{/x}"})"_json, hash_options}
+    };
+    
+    auto result = Pipeline(stages).apply(layered);
+    EXPECT_EQ(result, apply_sequentially(stages, layered));
+    EXPECT_EQ(result["y"], 5);
+}
+
+TEST_F(PipelineTest, ErrorsOnlyForReferencedParts) {
+    Options error_options;
+    error_options.missing_key_behavior = MissingKeyBehavior::Error;
+    
+    std::vector<PipelineStage> stages = {
+        {R"({"used": "${/user/name}", "unused": "${/missing}"})"_json, error_options},
+        {R"({"name": "#{/used}"})"_json, hash_options}
+    };
+    
+    // Sequential application fails on the unused member; the pipeline never evaluates it
+    EXPECT_THROW(apply_sequentially(stages, context), MissingKeyException);
+    EXPECT_EQ(Pipeline(stages).apply(context), R"({"name": "Alice"})"_json);
+    
+    stages[1].template_json = R"({"name": "#{/unused}"})"_json;
+    try {
+        Pipeline(stages).apply(context);
+        FAIL() << "Expected MissingKeyException";
+    } catch (const MissingKeyException& e) {
+        EXPECT_EQ(e.key_path(), "/missing");
+    }
+}
+
+TEST_F(PipelineTest, RecursionLimitAlongReferencedPath) {
+    Options shallow;
+    shallow.max_recursion_depth = 2;
+    
+    std::vector<PipelineStage> stages = {
+        {R"({"a": {"b": {"c": "${/user/name}"}}})"_json, shallow},
+        {R"({"v": "#{/a/b/c}"})"_json, hash_options}
+    };
+    
+    EXPECT_THROW(Pipeline(stages).apply(context), RecursionLimitException);
+    EXPECT_THROW(apply_sequentially(stages, context), RecursionLimitException);
+}
+
+TEST_F(PipelineTest, InvalidStages) {
+    EXPECT_THROW(Pipeline({}), std::invalid_argument);
+    
+    Options bad;
+    bad.start_marker = "";
+    EXPECT_THROW(Pipeline({{"x", bad}}), std::invalid_argument);
+    
+    Options remove_options;
+    remove_options.missing_key_behavior = MissingKeyBehavior::Remove;
+    EXPECT_THROW(Pipeline({{"${/x}", remove_options}}), std::invalid_argument);
+}
@@ -64,6 +64,19 @@ TEST_F(PlaceholderParserTest, ReplacePlaceholders) {
     EXPECT_EQ(result, "Hello Alice! Your ID is 123.");
 }
 
+TEST_F(PlaceholderParserTest, AppendReplaced) {
+    std::string out = "prefix: ";
+    size_t count = custom_parser.append_replaced("Hi </a>, <invalid> and </b>!", out,
+        [](std::string_view path, std::string& buffer) {
+            buffer += '[';
+            buffer += path;
+            buffer += ']';
+        });
+    
+    EXPECT_EQ(count, 2);
+    EXPECT_EQ(out, "prefix: Hi [/a], <invalid> and [/b]!");
+}
+
 TEST_F(PlaceholderParserTest, NoPlaceholders) {
     auto placeholders = parser.find_placeholders("Just plain text");
     EXPECT_TRUE(placeholders.empty());
@@ -93,4 +106,27 @@ TEST_F(PlaceholderParserTest, InvalidPaths) {
     
     auto result = parser.extract_exact_placeholder("${invalid_path}");
     EXPECT_FALSE(result.has_value());
-}
\ No newline at end of file
+}
+
+TEST_F(PlaceholderParserTest, UnclosedStartMarkers) {
+    // Long runs of start markers without an end marker are scanned once
+    std::string adversarial;
+    for (int i = 0; i < 100000; ++i) {
+        adversarial += "${";
+    }
+    EXPECT_TRUE(parser.find_placeholders(adversarial).empty());
+    
+    auto placeholders = parser.find_placeholders("Hi ${/user/name}, ${ is never closed ${/x");
+    ASSERT_EQ(placeholders.size(), 1);
+    EXPECT_EQ(placeholders[0].path, "/user/name");
+    EXPECT_EQ(placeholders[0].start_pos, 3);
+    EXPECT_EQ(placeholders[0].end_pos, 16);
+}
+
+TEST_F(PlaceholderParserTest, NestedStartMarker) {
+    // The first end marker closes the first start marker
+    auto placeholders = parser.find_placeholders("${/a ${/b} tail");
+    ASSERT_EQ(placeholders.size(), 1);
+    EXPECT_EQ(placeholders[0].path, "/a ${/b");
+    EXPECT_EQ(placeholders[0].end_pos, 10);
+}
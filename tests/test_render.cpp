@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+#include <permuto/permuto.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace permuto;
+
+class RenderTest : public ::testing::Test {
+protected:
+    nlohmann::json context = R"({
+        "user": {"id": 123, "name": "Al\"ice\n", "score": 0.1, "big": 1e300},
+        "preferences": {"theme": "dark", "notifications": true, "empty": {}, "list": []},
+        "items": ["first", "second", null, -7],
+        "unicode": "héllo ☃"
+    })"_json;
+
+    nlohmann::json llm_template = R"json({
+        "model": "gpt-4",
+        "user_id": "${/user/id}",
+        "settings": "${/preferences}",
+        "messages": [
+            {"role": "system", "content": "You are helpful to ${/user/name}."},
+            {"role": "user", "content": "${/items/1}"},
+            {"role": "user", "content": "${/unicode}", "score": "${/user/score}"}
+        ],
+        "missing": "${/user/missing}",
+        "summary": "${/user/name} scored ${/user/score} (${/items})",
+        "literal": {"nested": [1, 2.5, {"deep": true, "empty": []}], "none": {}},
+        "esc\\aped \"key\"": "${/user/big}"
+    })json"_json;
+
+    std::string render_to_string(const nlohmann::json& template_json, const Options& options,
+                                 int indent) {
+        std::string output;
+        StringSink sink(output);
+        render(template_json, context, options, sink, indent);
+        return output;
+    }
+
+    void expect_same_as_dump(const nlohmann::json& template_json, const Options& options) {
+        auto expected = permuto::apply(template_json, context, options);
+        for (int indent : {-1, 0, 2, 4}) {
+            EXPECT_EQ(render_to_string(template_json, options, indent), expected.dump(indent))
+                << "indent " << indent;
+        }
+    }
+};
+
+TEST_F(RenderTest, MatchesDumpOfApply) {
+    expect_same_as_dump(llm_template, Options{});
+}
+
+TEST_F(RenderTest, MatchesDumpWithInterpolation) {
+    Options opts;
+    opts.enable_interpolation = true;
+    expect_same_as_dump(llm_template, opts);
+}
+
+TEST_F(RenderTest, RemoveModePlacesCommasCorrectly) {
+    Options opts;
+    opts.missing_key_behavior = MissingKeyBehavior::Remove;
+
+    // Removed elements first, in the middle, last, and all of them
+    nlohmann::json template_json = R"({
+        "a_first": {"gone": "${/nope}", "kept": "${/user/id}", "other": 1},
+        "b_middle": ["${/items/0}", "${/nope}", "${/items/1}"],
+        "c_last": ["${/items/0}", "${/nope}", "${/nope/deeper}"],
+        "d_all": {"x": "${/nope}", "y": "${/missing}"},
+        "e_all_array": ["${/nope}"],
+        "z": "${/nope}"
+    })"_json;
+
+    expect_same_as_dump(template_json, opts);
+    EXPECT_EQ(render_to_string(template_json, opts, -1),
+              R"({"a_first":{"kept":123,"other":1},"b_middle":["first","second"],)"
+              R"("c_last":["first"],"d_all":{},"e_all_array":[]})");
+}
+
+TEST_F(RenderTest, ScalarAndPlaceholderRoots) {
+    Options interpolating;
+    interpolating.enable_interpolation = true;
+
+    expect_same_as_dump(nlohmann::json("${/user}"), Options{});
+    expect_same_as_dump(nlohmann::json("${/nope}"), Options{});
+    expect_same_as_dump(nlohmann::json("plain"), Options{});
+    expect_same_as_dump(nlohmann::json("Hi ${/user/name}"), interpolating);
+    expect_same_as_dump(42, Options{});
+    expect_same_as_dump(nlohmann::json::object(), Options{});
+}
+
+TEST_F(RenderTest, ErrorsMatchApply) {
+    Options opts;
+    opts.missing_key_behavior = MissingKeyBehavior::Error;
+    std::string output;
+    StringSink sink(output);
+
+    EXPECT_THROW(render(llm_template, context, opts, sink), MissingKeyException);
+
+    Options shallow;
+    shallow.max_recursion_depth = 2;
+    EXPECT_THROW(render(llm_template, context, shallow, sink), RecursionLimitException);
+
+    Options remove;
+    remove.missing_key_behavior = MissingKeyBehavior::Remove;
+    EXPECT_THROW(render(nlohmann::json("${/user}"), context, remove, sink), std::invalid_argument);
+}
+
+TEST_F(RenderTest, ValuesOfEveryKindMatchDump) {
+    context["kinds"] = {
+        {"integers", {0, -1, INT64_MIN, INT64_MAX, UINT64_MAX}},
+        {"floats", {0.0, -0.5, 1e-7, 1.2345678901234568e17}},
+        {"strings", {"", "plain", "tab\there", "ctrl\x01\x1f", "quote\" back\\ slash", "del\x7f", "ünï"}},
+        {"nested", {{"a", {{"b", {1, {{"c", "line\nbreak"}}}}}}}},
+        {"flags", {true, false, nullptr}}
+    };
+    nlohmann::json template_json = {
+        {"root", "${/kinds}"},
+        {"deeper", {{"list", {"${/kinds/nested}", "${/kinds/strings/3}", "${/kinds/floats/3}"}}}}
+    };
+
+    expect_same_as_dump(template_json, Options{});
+}
+
+TEST_F(RenderTest, InvalidUtf8KeyThrowsLikeDump) {
+    nlohmann::json template_json = {{std::string("bad\xff"), "${/user/id}"}};
+    std::string output;
+    StringSink sink(output);
+
+    EXPECT_THROW(permuto::apply(template_json, context).dump(), nlohmann::json::type_error);
+    EXPECT_THROW(render(template_json, context, Options{}, sink), nlohmann::json::type_error);
+}
+
+TEST_F(RenderTest, CompiledTemplateReusesStringCapacity) {
+    CompiledTemplate compiled(llm_template);
+    std::string output;
+    StringSink sink(output);
+
+    compiled.render(context, sink, 2);
+    EXPECT_EQ(output, compiled.apply(context).dump(2));
+
+    const char* buffer = output.data();
+    output.clear();
+    compiled.render(context, sink, 2);
+    EXPECT_EQ(output, compiled.apply(context).dump(2));
+    EXPECT_EQ(output.data(), buffer);
+}
+
+TEST_F(RenderTest, StreamAndCallbackSinks) {
+    // Large enough to be delivered in several chunks
+    nlohmann::json template_json = nlohmann::json::array();
+    for (int i = 0; i < 5000; ++i) {
+        template_json.push_back({{"id", i}, {"user", "${/user}"}, {"items", "${/items}"}});
+    }
+    std::string expected = permuto::apply(template_json, context).dump(2);
+
+    std::ostringstream stream;
+    StreamSink stream_sink(stream);
+    render(template_json, context, Options{}, stream_sink, 2);
+    EXPECT_EQ(stream.str(), expected);
+
+    std::string collected;
+    size_t chunks = 0;
+    CallbackSink callback_sink([&](std::string_view chunk) {
+        collected.append(chunk);
+        ++chunks;
+    });
+    render(template_json, context, Options{}, callback_sink, 2);
+    EXPECT_EQ(collected, expected);
+    EXPECT_GT(chunks, 1u);
+}
+
+TEST_F(RenderTest, DeepTemplatesWithoutRecursion) {
+    const size_t depth = 10000;
+    nlohmann::json template_json = "${/user/id}";
+    for (size_t i = 0; i < depth; ++i) {
+        template_json = (i % 2 == 0) ? nlohmann::json{{"k", std::move(template_json)}}
+                                     : nlohmann::json::array({std::move(template_json)});
+    }
+    // Outermost level first
+    std::string expected;
+    std::string closing;
+    for (size_t i = depth; i > 0; --i) {
+        expected += ((i - 1) % 2 == 0) ? "{\"k\":" : "[";
+        closing += ((i - 1) % 2 == 0) ? '}' : ']';
+    }
+    std::reverse(closing.begin(), closing.end());
+    expected += "123" + closing;
+
+    Options opts;
+    opts.max_recursion_depth = depth + 1;
+    for (auto engine : {ProcessingEngine::Recursive, ProcessingEngine::Iterative}) {
+        opts.engine = engine;
+        EXPECT_EQ(render_to_string(template_json, opts, -1), expected);
+    }
+
+    opts.max_recursion_depth = depth;
+    std::string output;
+    StringSink sink(output);
+    EXPECT_THROW(render(template_json, context, opts, sink), RecursionLimitException);
+}
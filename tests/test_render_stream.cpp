@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include <permuto/permuto.hpp>
+#include <sstream>
+#include <string>
+
+using namespace permuto;
+
+class RenderStreamTest : public ::testing::Test {
+protected:
+    nlohmann::json context = R"({
+        "user": {"id": 123, "name": "Al\"ice\n", "score": 0.1},
+        "preferences": {"theme": "dark", "notifications": true, "empty": {}},
+        "items": ["first", "second", null, -7],
+        "unicode": "héllo ☃"
+    })"_json;
+
+    nlohmann::json llm_template = R"json({
+        "model": "gpt-4",
+        "user_id": "${/user/id}",
+        "settings": "${/preferences}",
+        "messages": [
+            {"role": "system", "content": "You are helpful to ${/user/name}."},
+            {"role": "user", "content": "${/items/1}"},
+            {"role": "user", "content": "${/unicode}", "score": "${/user/score}"}
+        ],
+        "missing": "${/user/missing}",
+        "summary": "${/user/name} scored ${/user/score} (${/items})",
+        "literal": {"nested": [1, 2.5, 1e300, {"deep": true, "empty": []}], "none": {}}
+    })json"_json;
+
+    std::string stream_to_string(const std::string& template_text, const Options& options,
+                                 int indent = -1) {
+        std::string output;
+        StringSink sink(output);
+        render_stream(template_text, context, options, sink, indent);
+        return output;
+    }
+
+    std::string render_to_string(const nlohmann::json& template_json, const Options& options,
+                                 int indent = -1) {
+        std::string output;
+        StringSink sink(output);
+        render(template_json, context, options, sink, indent);
+        return output;
+    }
+
+    // dump() sorts keys, so the streamed template has the order render() uses
+    void expect_same_as_render(const nlohmann::json& template_json, const Options& options) {
+        for (int indent : {-1, 0, 2}) {
+            EXPECT_EQ(stream_to_string(template_json.dump(3), options, indent),
+                      render_to_string(template_json, options, indent))
+                << "indent " << indent;
+        }
+    }
+};
+
+TEST_F(RenderStreamTest, MatchesRender) {
+    expect_same_as_render(llm_template, Options{});
+
+    Options interpolating;
+    interpolating.enable_interpolation = true;
+    expect_same_as_render(llm_template, interpolating);
+}
+
+TEST_F(RenderStreamTest, RemoveModeMatchesRender) {
+    Options opts;
+    opts.missing_key_behavior = MissingKeyBehavior::Remove;
+
+    nlohmann::json template_json = R"({
+        "a_first": {"gone": "${/nope}", "kept": "${/user/id}", "other": 1},
+        "b_middle": ["${/items/0}", "${/nope}", "${/items/1}"],
+        "c_last": ["${/items/0}", "${/nope}"],
+        "d_all": {"x": "${/nope}"},
+        "e_all_array": ["${/nope}"],
+        "z": "${/nope}"
+    })"_json;
+
+    expect_same_as_render(template_json, opts);
+}
+
+TEST_F(RenderStreamTest, KeepsTemplateKeyOrder) {
+    std::string template_text = R"({"zebra": "${/user/id}", "apple": 1, "apple": "${/items/0}"})";
+
+    EXPECT_EQ(stream_to_string(template_text, Options{}),
+              R"({"zebra":123,"apple":1,"apple":"first"})");
+}
+
+TEST_F(RenderStreamTest, ReadsFromStream) {
+    std::istringstream input(llm_template.dump());
+    std::ostringstream output;
+    StreamSink sink(output);
+
+    render_stream(input, context, Options{}, sink, 2);
+
+    EXPECT_EQ(output.str(), permuto::apply(llm_template, context).dump(2));
+}
+
+TEST_F(RenderStreamTest, ManyDistinctPaths) {
+    // More distinct paths than the pointer cache holds
+    nlohmann::json big_context;
+    nlohmann::json template_json = nlohmann::json::array();
+    for (int i = 0; i < 10000; ++i) {
+        big_context["values"].push_back(i * 2);
+        template_json.push_back("${/values/" + std::to_string(i) + "}");
+    }
+    template_json.push_back("${/values/10000}");
+
+    std::string output;
+    StringSink sink(output);
+    render_stream(template_json.dump(), big_context, Options{}, sink);
+
+    EXPECT_EQ(output, permuto::apply(template_json, big_context).dump());
+}
+
+TEST_F(RenderStreamTest, RecursiveExpansion) {
+    Options opts;
+    opts.recursive_expansion = true;
+    opts.enable_interpolation = true;
+    nlohmann::json layered = R"({
+        "name": "Alice",
+        "greeting": "Hello ${/name}",
+        "banner": "${/greeting}!"
+    })"_json;
+    nlohmann::json template_json = R"({"text": "${/banner}", "raw": "${/greeting}"})"_json;
+
+    std::string output;
+    StringSink sink(output);
+    render_stream(template_json.dump(), layered, opts, sink);
+
+    EXPECT_EQ(output, permuto::apply(template_json, layered, opts).dump());
+    EXPECT_EQ(output, R"({"raw":"Hello Alice","text":"Hello Alice!"})");
+}
+
+TEST_F(RenderStreamTest, Errors) {
+    std::string output;
+    StringSink sink(output);
+
+    EXPECT_THROW(render_stream(std::string_view(R"({"a": [1, 2)"), context, Options{}, sink),
+                 nlohmann::json::parse_error);
+
+    Options error_mode;
+    error_mode.missing_key_behavior = MissingKeyBehavior::Error;
+    EXPECT_THROW(render_stream(llm_template.dump(), context, error_mode, sink), MissingKeyException);
+
+    Options shallow;
+    shallow.max_recursion_depth = 2;
+    EXPECT_THROW(render_stream(llm_template.dump(), context, shallow, sink), RecursionLimitException);
+
+    Options remove;
+    remove.missing_key_behavior = MissingKeyBehavior::Remove;
+    EXPECT_THROW(render_stream(std::string_view(R"("${/user}")"), context, remove, sink),
+                 std::invalid_argument);
+}
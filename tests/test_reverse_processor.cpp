@@ -162,4 +162,17 @@ TEST_F(ReverseProcessorTest, MissingDataInResult) {
     EXPECT_EQ(reconstructed["user"]["name"], "Alice");
     EXPECT_FALSE(reconstructed["user"].contains("email"));
     EXPECT_FALSE(reconstructed.contains("preferences"));
-}
\ No newline at end of file
+}
+
+TEST_F(ReverseProcessorTest, RvalueResultRoundTrip) {
+    ReverseProcessor processor(default_options);
+    auto reverse_template = processor.create_reverse_template(template_json);
+    
+    TemplateProcessor forward_processor(default_options);
+    auto forward_result = forward_processor.process(template_json, context);
+    auto expected = processor.apply_reverse(reverse_template, forward_result);
+    
+    auto reconstructed = processor.apply_reverse(reverse_template, std::move(forward_result));
+    EXPECT_EQ(reconstructed, expected);
+    EXPECT_EQ(reconstructed, context);
+}
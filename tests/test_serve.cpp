@@ -0,0 +1,365 @@
+#include <gtest/gtest.h>
+#include "../cli/serve.hpp"
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace permuto::cli;
+
+namespace {
+    const size_t LARGE_CONTEXT_SIZE = 8 << 20;
+
+    void write_file(const std::filesystem::path& path, const std::string& contents) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << contents;
+    }
+
+    // Connected socket to path, or -1
+    int raw_connect(const std::string& path) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+        if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    std::string frame(const std::string& payload) {
+        uint32_t size = static_cast<uint32_t>(payload.size());
+        std::string out;
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            out += static_cast<char>((size >> shift) & 0xff);
+        }
+        return out + payload;
+    }
+}
+
+class ServeTest : public ::testing::Test {
+protected:
+    std::filesystem::path directory;
+    std::string socket_path;
+    std::filesystem::path template_path;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        directory = std::filesystem::temp_directory_path() /
+                    ("permuto_serve_" + std::to_string(::getpid()) + "_" + info->name());
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        socket_path = (directory / "s.sock").string();
+        template_path = directory / "template.json";
+        write_file(template_path, R"({"greeting": "Hello ${/name}", "name": "${/name}"})");
+    }
+
+    void TearDown() override {
+        stop_server();
+        std::filesystem::remove_all(directory);
+    }
+
+    void start_server(size_t jobs = 2, std::chrono::milliseconds idle_timeout = ServeSettings{}.idle_timeout) {
+        server = std::make_unique<Server>(socket_path, ServeSettings{jobs, idle_timeout});
+        server_thread = std::thread([this] { server->run(); });
+    }
+
+    void stop_server() {
+        if (server) {
+            server->stop();
+            server_thread.join();
+            server.reset();
+        }
+    }
+
+    ServeRequest request() const {
+        ServeRequest request;
+        request.template_path = template_path.string();
+        request.options.enable_interpolation = true;
+        return request;
+    }
+
+    std::unique_ptr<Server> server;
+    std::thread server_thread;
+};
+
+TEST_F(ServeTest, RoundTrip) {
+    start_server();
+    Client client(socket_path);
+
+    EXPECT_EQ(client.apply(request(), R"({"name": "Ada"})"), R"({"greeting":"Hello Ada","name":"Ada"})");
+}
+
+TEST_F(ServeTest, ManyRequestsOnOneConnection) {
+    start_server();
+    Client client(socket_path);
+    ServeRequest pretty = request();
+    pretty.indent = 2;
+
+    for (int i = 0; i < 20; ++i) {
+        std::string name = "user" + std::to_string(i);
+        auto result = nlohmann::json::parse(client.apply(pretty, nlohmann::json{{"name", name}}.dump()));
+        EXPECT_EQ(result["greeting"], "Hello " + name);
+    }
+}
+
+TEST_F(ServeTest, BinaryContext) {
+    start_server();
+    Client client(socket_path);
+    ServeRequest cbor = request();
+    cbor.context_format = permuto::Format::Cbor;
+    auto bytes = nlohmann::json::to_cbor(nlohmann::json{{"name", "Bo"}});
+
+    EXPECT_EQ(client.apply(cbor, std::string(bytes.begin(), bytes.end())),
+              R"({"greeting":"Hello Bo","name":"Bo"})");
+}
+
+TEST_F(ServeTest, ErrorsAreAnsweredAndTheConnectionKept) {
+    start_server();
+    Client client(socket_path);
+    ServeRequest strict = request();
+    strict.options.missing_key_behavior = permuto::MissingKeyBehavior::Error;
+
+    EXPECT_THROW(client.apply(strict, "{}"), std::runtime_error);
+    EXPECT_THROW(client.apply(request(), "{not json"), std::runtime_error);
+    ServeRequest missing = request();
+    missing.template_path = (directory / "missing.json").string();
+    try {
+        client.apply(missing, "{}");
+        FAIL() << "Expected an error";
+    } catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find("Cannot open file"), std::string::npos);
+    }
+
+    EXPECT_EQ(client.apply(request(), R"({"name": "Ada"})"), R"({"greeting":"Hello Ada","name":"Ada"})");
+}
+
+TEST_F(ServeTest, LargeContext) {
+    start_server();
+    Client client(socket_path);
+    std::string name(LARGE_CONTEXT_SIZE, 'x');
+
+    auto result = nlohmann::json::parse(client.apply(request(), nlohmann::json{{"name", name}}.dump()));
+
+    EXPECT_EQ(result["name"], name);
+}
+
+TEST_F(ServeTest, FramesSplitAcrossWrites) {
+    start_server();
+    int fd = raw_connect(socket_path);
+    ASSERT_GE(fd, 0);
+    std::string header = nlohmann::json{{"template", template_path.string()},
+                                        {"options", {{"enable_interpolation", true}}}}.dump();
+    std::string message = frame(header) + frame(R"({"name": "Ada"})");
+
+    // One byte at a time, so every frame arrives in pieces
+    for (char byte : message) {
+        ASSERT_EQ(::write(fd, &byte, 1), 1);
+    }
+    std::string response;
+    char buffer[256];
+    ssize_t count;
+    while ((count = ::read(fd, buffer, sizeof(buffer))) > 0) {
+        response.append(buffer, static_cast<size_t>(count));
+        if (response.size() >= 4 && response.size() == 4 + static_cast<unsigned char>(response[3])) {
+            break;
+        }
+    }
+    ::close(fd);
+
+    EXPECT_EQ(response, frame(std::string(1, '\0') + R"({"greeting":"Hello Ada","name":"Ada"})"));
+}
+
+TEST_F(ServeTest, OversizedFrameDropsOnlyThatConnection) {
+    start_server();
+    int fd = raw_connect(socket_path);
+    ASSERT_GE(fd, 0);
+    const char oversized[] = {'\x7f', '\xff', '\xff', '\xff'};
+    ASSERT_EQ(::write(fd, oversized, sizeof(oversized)), static_cast<ssize_t>(sizeof(oversized)));
+    char byte;
+    EXPECT_EQ(::read(fd, &byte, 1), 0);
+    ::close(fd);
+
+    Client client(socket_path);
+    EXPECT_EQ(client.apply(request(), R"({"name": "Ada"})"), R"({"greeting":"Hello Ada","name":"Ada"})");
+}
+
+TEST_F(ServeTest, EditedTemplateIsRecompiled) {
+    start_server();
+    Client client(socket_path);
+    EXPECT_EQ(client.apply(request(), R"({"name": "Ada"})"), R"({"greeting":"Hello Ada","name":"Ada"})");
+
+    write_file(template_path, R"({"farewell": "Bye ${/name}"})");
+
+    EXPECT_EQ(client.apply(request(), R"({"name": "Ada"})"), R"({"farewell":"Bye Ada"})");
+}
+
+TEST_F(ServeTest, StaleSocketIsReplaced) {
+    // Bound, then closed without removing the file, as a crashed server leaves it
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    socket_path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+    ASSERT_EQ(::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)), 0);
+    ::close(fd);
+    ASSERT_TRUE(std::filesystem::is_socket(socket_path));
+
+    start_server();
+    Client client(socket_path);
+
+    EXPECT_EQ(client.apply(request(), R"({"name": "Ada"})"), R"({"greeting":"Hello Ada","name":"Ada"})");
+}
+
+TEST_F(ServeTest, RefusesWhileAnotherServerListens) {
+    start_server();
+
+    EXPECT_THROW(Server{socket_path}, std::runtime_error);
+
+    // The running server keeps its socket
+    Client client(socket_path);
+    EXPECT_EQ(client.apply(request(), R"({"name": "Ada"})"), R"({"greeting":"Hello Ada","name":"Ada"})");
+}
+
+TEST_F(ServeTest, RefusesToReplaceOtherFiles) {
+    write_file(socket_path, "not a socket");
+
+    EXPECT_THROW(Server{socket_path}, std::runtime_error);
+    EXPECT_TRUE(std::filesystem::is_regular_file(socket_path));
+}
+
+TEST_F(ServeTest, StopEndsOpenConnectionsAndRemovesTheSocket) {
+    start_server(1);
+    Client idle(socket_path);
+    EXPECT_NO_THROW(idle.apply(request(), R"({"name": "Ada"})"));
+    // Queued behind the idle connection on the only worker
+    Client queued(socket_path);
+
+    stop_server();
+
+    EXPECT_FALSE(std::filesystem::exists(socket_path));
+    EXPECT_THROW(idle.apply(request(), R"({"name": "Ada"})"), std::runtime_error);
+    EXPECT_THROW(queued.apply(request(), R"({"name": "Ada"})"), std::runtime_error);
+    EXPECT_THROW(Client{socket_path}, std::runtime_error);
+}
+
+TEST_F(ServeTest, StopIsNotHeldUpByAFullQueue) {
+    // One connection being served, more than the queue holds waiting
+    const int idle_clients = 7;
+    start_server(1);
+    std::vector<std::unique_ptr<Client>> clients;
+    for (int i = 0; i < idle_clients; ++i) {
+        clients.push_back(std::make_unique<Client>(socket_path));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    auto started = std::chrono::steady_clock::now();
+    stop_server();
+
+    EXPECT_LT(std::chrono::steady_clock::now() - started, std::chrono::seconds(2));
+    EXPECT_FALSE(std::filesystem::exists(socket_path));
+}
+
+TEST_F(ServeTest, IdleConnectionsAreClosed) {
+    start_server(1, std::chrono::milliseconds(100));
+    Client idle(socket_path);
+    EXPECT_NO_THROW(idle.apply(request(), R"({"name": "Ada"})"));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+
+    EXPECT_THROW(idle.apply(request(), R"({"name": "Ada"})"), std::runtime_error);
+    // The only worker is free again
+    Client next(socket_path);
+    EXPECT_EQ(next.apply(request(), R"({"name": "Ada"})"), R"({"greeting":"Hello Ada","name":"Ada"})");
+}
+
+class TemplateCacheTest : public ServeTest {
+protected:
+    ServeRequest request_for(const std::string& name) {
+        auto path = directory / (name + ".json");
+        if (!std::filesystem::exists(path)) {
+            write_file(path, R"({"name": ")" + name + R"("})");
+        }
+        ServeRequest request;
+        request.template_path = path.string();
+        return request;
+    }
+};
+
+TEST_F(TemplateCacheTest, ReusesUnchangedTemplates) {
+    TemplateCache cache;
+
+    auto first = cache.get(request_for("a"));
+    EXPECT_EQ(cache.get(request_for("a")), first);
+
+    // Options are part of the key
+    ServeRequest other = request_for("a");
+    other.options.enable_interpolation = true;
+    EXPECT_NE(cache.get(other), first);
+    EXPECT_EQ(cache.size(), 2u);
+}
+
+TEST_F(TemplateCacheTest, ChangedSizeInvalidates) {
+    TemplateCache cache;
+    auto first = cache.get(request_for("a"));
+
+    write_file(directory / "a.json", R"({"name": "a longer template"})");
+    auto second = cache.get(request_for("a"));
+
+    EXPECT_NE(second, first);
+    EXPECT_EQ(second->apply(nlohmann::json::object()), nlohmann::json({{"name", "a longer template"}}));
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST_F(TemplateCacheTest, ChangedModificationTimeInvalidates) {
+    TemplateCache cache;
+    auto first = cache.get(request_for("a"));
+
+    // Same size, different contents and time
+    write_file(directory / "a.json", R"({"name": "b"})");
+    auto path = directory / "a.json";
+    std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::seconds(5));
+    auto second = cache.get(request_for("a"));
+
+    EXPECT_NE(second, first);
+    EXPECT_EQ(second->apply(nlohmann::json::object()), nlohmann::json({{"name", "b"}}));
+}
+
+TEST_F(TemplateCacheTest, DeletedTemplatesAreDropped) {
+    TemplateCache cache;
+    cache.get(request_for("a"));
+    cache.get(request_for("b"));
+
+    std::filesystem::remove(directory / "a.json");
+
+    ServeRequest never_cached;
+    never_cached.template_path = (directory / "missing.json").string();
+    EXPECT_THROW(cache.get(never_cached), std::runtime_error);
+    EXPECT_EQ(cache.size(), 2u);
+    ServeRequest deleted;
+    deleted.template_path = (directory / "a.json").string();
+    EXPECT_THROW(cache.get(deleted), std::runtime_error);
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST_F(TemplateCacheTest, CapacityDropsLeastRecentlyUsed) {
+    TemplateCache cache(2);
+    auto a = cache.get(request_for("a"));
+    auto b = cache.get(request_for("b"));
+    EXPECT_EQ(cache.get(request_for("a")), a);
+
+    cache.get(request_for("c"));
+
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_EQ(cache.get(request_for("a")), a);
+    EXPECT_NE(cache.get(request_for("b")), b);
+    EXPECT_EQ(cache.size(), 2u);
+}
@@ -0,0 +1,294 @@
+#include <gtest/gtest.h>
+#include <permuto/permuto.hpp>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace permuto;
+
+class TemplateArtifactTest : public ::testing::Test {
+protected:
+    nlohmann::json context = R"({
+        "user": {"id": 123, "name": "Alice", "tags": ["a", "b"]},
+        "model": "claude-3-sonnet-20240229",
+        "items": [{"x": 1}, {"x": 2}],
+        "a/b": "slash",
+        "empty": {}
+    })"_json;
+
+    nlohmann::json request_template = R"({
+        "model": "${/model}",
+        "max_tokens": 1024,
+        "temperature": 0.7,
+        "offset": -5,
+        "stream": false,
+        "stop": null,
+        "user": "${/user}",
+        "second_x": "${/items/1/x}",
+        "escaped": "${/a~1b}",
+        "system": "You are talking to ${/user/name} (${/user/id}).",
+        "missing": "${/user/missing}",
+        "note": "Hi ${/user/missing}",
+        "list": ["${/user/tags/0}", "${/user/nope}", [], {}],
+        "literal": {"nested": [1, 2, {"deep": true}]}
+    })"_json;
+
+    static std::string render_to_string(const TemplateArtifact& artifact,
+                                        const nlohmann::json& context, int indent = -1) {
+        std::string out;
+        StringSink sink(out);
+        artifact.render(context, sink, indent);
+        return out;
+    }
+
+    // Same template and options through TemplateArtifact and CompiledTemplate
+    void expect_same_as_compiled(const nlohmann::json& template_json, const Options& options) {
+        std::string bytes = TemplateArtifact::serialize(template_json, options);
+        TemplateArtifact artifact = TemplateArtifact::view(bytes);
+        CompiledTemplate compiled(template_json, options);
+
+        EXPECT_EQ(artifact.apply(context), compiled.apply(context));
+        for (int indent : {-1, 0, 2}) {
+            std::string expected;
+            StringSink sink(expected);
+            compiled.render(context, sink, indent);
+            EXPECT_EQ(render_to_string(artifact, context, indent), expected);
+        }
+    }
+
+    std::string write_file(const std::string& name, const std::string& bytes) {
+        std::string path = ::testing::TempDir() + name;
+        std::ofstream file(path, std::ios::binary);
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        return path;
+    }
+};
+
+TEST_F(TemplateArtifactTest, MatchesCompiledTemplate) {
+    Options opts;
+    expect_same_as_compiled(request_template, opts);
+
+    opts.enable_interpolation = true;
+    expect_same_as_compiled(request_template, opts);
+
+    opts.enable_interpolation = false;
+    opts.missing_key_behavior = MissingKeyBehavior::Remove;
+    expect_same_as_compiled(request_template, opts);
+
+    Options markers;
+    markers.start_marker = "{{";
+    markers.end_marker = "}}";
+    markers.enable_interpolation = true;
+    expect_same_as_compiled(R"({"greeting": "Hello {{/user/name}}", "id": "{{/user/id}}", "raw": "${/user/id}"})"_json,
+                            markers);
+}
+
+TEST_F(TemplateArtifactTest, ScalarAndPlaceholderRoots) {
+    Options opts;
+    for (const auto& root : {R"("${/user/name}")"_json, R"("${/missing}")"_json, R"("plain")"_json,
+                             R"(42)"_json, R"(18446744073709551615)"_json, R"(1.5e300)"_json,
+                             R"(true)"_json, R"(null)"_json, R"([])"_json}) {
+        expect_same_as_compiled(root, opts);
+    }
+
+    opts.missing_key_behavior = MissingKeyBehavior::Remove;
+    EXPECT_THROW(TemplateArtifact::serialize("${/user/name}", opts), std::invalid_argument);
+}
+
+TEST_F(TemplateArtifactTest, OptionsAreStored) {
+    Options opts;
+    opts.start_marker = "<<";
+    opts.end_marker = ">>";
+    opts.enable_interpolation = true;
+    opts.missing_key_behavior = MissingKeyBehavior::Error;
+    opts.max_recursion_depth = 7;
+
+    std::string bytes = TemplateArtifact::serialize(R"({"name": "<<{/user/name}>>"})"_json, opts);
+    TemplateArtifact artifact = TemplateArtifact::view(bytes);
+
+    EXPECT_EQ(artifact.options().start_marker, "<<");
+    EXPECT_EQ(artifact.options().end_marker, ">>");
+    EXPECT_TRUE(artifact.options().enable_interpolation);
+    EXPECT_EQ(artifact.options().missing_key_behavior, MissingKeyBehavior::Error);
+    EXPECT_EQ(artifact.options().max_recursion_depth, 7u);
+    EXPECT_FALSE(artifact.options().recursive_expansion);
+}
+
+TEST_F(TemplateArtifactTest, ErrorsMatchCompiledTemplate) {
+    Options opts;
+    opts.missing_key_behavior = MissingKeyBehavior::Error;
+    std::string bytes = TemplateArtifact::serialize(request_template, opts);
+    TemplateArtifact artifact = TemplateArtifact::view(bytes);
+
+    // Members are visited in key order, so "list" is reached before "missing"
+    try {
+        artifact.apply(context);
+        FAIL() << "Expected MissingKeyException";
+    } catch (const MissingKeyException& e) {
+        EXPECT_EQ(e.key_path(), "/user/nope");
+    }
+    std::string out;
+    StringSink sink(out);
+    EXPECT_THROW(artifact.render(context, sink), MissingKeyException);
+
+    Options shallow;
+    shallow.max_recursion_depth = 2;
+    nlohmann::json deep = R"({"a": {"b": {"c": 1}}})"_json;
+    std::string deep_bytes = TemplateArtifact::serialize(deep, shallow);
+    TemplateArtifact deep_artifact = TemplateArtifact::view(deep_bytes);
+    EXPECT_THROW(deep_artifact.apply(context), RecursionLimitException);
+    EXPECT_THROW(deep_artifact.render(context, sink), RecursionLimitException);
+}
+
+TEST_F(TemplateArtifactTest, VeryDeepTemplateStopsAtTheLimit) {
+    // Far deeper than native recursion over every level could go
+    const size_t depth = 300000;
+    nlohmann::json deep = nlohmann::json::parse(std::string(depth, '[') + std::string(depth, ']'));
+    Options options;
+
+    std::string bytes = TemplateArtifact::serialize(deep, options);
+    TemplateArtifact artifact = TemplateArtifact::view(bytes);
+
+    try {
+        artifact.apply(context);
+        FAIL() << "Expected RecursionLimitException";
+    } catch (const RecursionLimitException& e) {
+        EXPECT_EQ(e.depth(), options.max_recursion_depth);
+    }
+    std::string out;
+    StringSink sink(out);
+    EXPECT_THROW(artifact.render(context, sink), RecursionLimitException);
+}
+
+TEST_F(TemplateArtifactTest, RecursiveExpansion) {
+    Options opts;
+    opts.recursive_expansion = true;
+    opts.enable_interpolation = true;
+    context["greeting"] = "Hello ${/user/name}";
+    context["loop"] = "${/loop}";
+
+    expect_same_as_compiled(R"({"text": "${/greeting}", "inline": "<${/greeting}>"})"_json, opts);
+
+    std::string bytes = TemplateArtifact::serialize(R"({"value": "${/loop}"})"_json, opts);
+    TemplateArtifact artifact = TemplateArtifact::view(bytes);
+    EXPECT_THROW(artifact.apply(context), CycleException);
+}
+
+TEST_F(TemplateArtifactTest, InvalidUtf8ThrowsLikeDump) {
+    nlohmann::json template_json = {{"bad", std::string("\xff")}};
+    std::string bytes = TemplateArtifact::serialize(template_json);
+    TemplateArtifact artifact = TemplateArtifact::view(bytes);
+
+    EXPECT_EQ(artifact.apply(context), template_json);
+    std::string out;
+    StringSink sink(out);
+    EXPECT_THROW(artifact.render(context, sink), nlohmann::json::type_error);
+
+    nlohmann::json bad_key = {{std::string("\xff"), 1}};
+    std::string key_bytes = TemplateArtifact::serialize(bad_key);
+    TemplateArtifact key_artifact = TemplateArtifact::view(key_bytes);
+    EXPECT_THROW(key_artifact.render(context, sink), nlohmann::json::type_error);
+}
+
+TEST_F(TemplateArtifactTest, BinaryValuesRejected) {
+    nlohmann::json template_json = {{"blob", nlohmann::json::binary({1, 2, 3})}};
+    EXPECT_THROW(TemplateArtifact::serialize(template_json), std::invalid_argument);
+}
+
+TEST_F(TemplateArtifactTest, OpenFile) {
+    std::string path = write_file("permuto_artifact_test.ptc", TemplateArtifact::serialize(request_template));
+    TemplateArtifact artifact = TemplateArtifact::open(path);
+
+    EXPECT_EQ(artifact.apply(context), permuto::apply(request_template, context));
+    std::remove(path.c_str());
+
+    EXPECT_THROW(TemplateArtifact::open(path), std::runtime_error);
+}
+
+TEST_F(TemplateArtifactTest, MisalignedView) {
+    std::string bytes = TemplateArtifact::serialize(request_template);
+    std::string shifted = "x" + bytes;
+
+    TemplateArtifact artifact = TemplateArtifact::view(std::string_view(shifted).substr(1));
+    EXPECT_EQ(artifact.apply(context), permuto::apply(request_template, context));
+}
+
+TEST_F(TemplateArtifactTest, CorruptionDetected) {
+    const std::string bytes = TemplateArtifact::serialize(request_template);
+
+    // Every single flipped byte, header included, is caught
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        std::string corrupt = bytes;
+        corrupt[i] = static_cast<char>(corrupt[i] ^ 0x40);
+        EXPECT_THROW(TemplateArtifact::view(corrupt), InvalidTemplateException) << "byte " << i;
+    }
+
+    EXPECT_THROW(TemplateArtifact::view(bytes.substr(0, bytes.size() - 8)), InvalidTemplateException);
+    EXPECT_THROW(TemplateArtifact::view(bytes.substr(0, 16)), InvalidTemplateException);
+    EXPECT_THROW(TemplateArtifact::view(""), InvalidTemplateException);
+    EXPECT_THROW(TemplateArtifact::view(std::string(bytes.size(), '\0')), InvalidTemplateException);
+
+    std::string path = write_file("permuto_artifact_truncated.ptc", bytes.substr(0, 10));
+    EXPECT_THROW(TemplateArtifact::open(path), InvalidTemplateException);
+    std::remove(path.c_str());
+}
+
+TEST_F(TemplateArtifactTest, WrongVersionRejected) {
+    std::string bytes = TemplateArtifact::serialize(request_template);
+    bytes[8] = static_cast<char>(bytes[8] + 1);  // Version follows the 8-byte magic
+
+    try {
+        TemplateArtifact::view(bytes);
+        FAIL() << "Expected InvalidTemplateException";
+    } catch (const InvalidTemplateException& e) {
+        EXPECT_NE(std::string(e.what()).find("version"), std::string::npos);
+    }
+}
+
+TEST_F(TemplateArtifactTest, LiteralSubtreesAreCopiedPerApply) {
+    nlohmann::json template_json = R"({
+        "literal": {"nested": [1, 2, {"deep": true}], "empty": {}},
+        "mixed": [{"fixed": "x"}, "${/model}", []]
+    })"_json;
+    std::string bytes = TemplateArtifact::serialize(template_json);
+    TemplateArtifact artifact = TemplateArtifact::view(bytes);
+    nlohmann::json expected = permuto::apply(template_json, context);
+
+    nlohmann::json first = artifact.apply(context);
+    first["literal"]["nested"].push_back(3);
+    first["mixed"][0]["fixed"] = "changed";
+
+    EXPECT_EQ(artifact.apply(context), expected);
+
+    // A template without placeholders is one literal
+    nlohmann::json constant = R"({"a": [1, {"b": null}], "c": "text"})"_json;
+    std::string constant_bytes = TemplateArtifact::serialize(constant);
+    TemplateArtifact constant_artifact = TemplateArtifact::view(constant_bytes);
+    EXPECT_EQ(constant_artifact.apply(context), constant);
+    EXPECT_EQ(constant_artifact.apply(context), constant);
+}
+
+TEST_F(TemplateArtifactTest, ConcurrentApply) {
+    std::string bytes = TemplateArtifact::serialize(request_template);
+    TemplateArtifact artifact = TemplateArtifact::view(bytes);
+    nlohmann::json expected = permuto::apply(request_template, context);
+
+    std::vector<nlohmann::json> contexts(64, context);
+    std::vector<nlohmann::json> results(contexts.size());
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (size_t i = t; i < contexts.size(); i += 4) {
+                results[i] = artifact.apply(contexts[i]);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto& result : results) {
+        EXPECT_EQ(result, expected);
+    }
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "../src/template_processor.hpp"
+#include <functional>
 
 using namespace permuto;
 
@@ -296,4 +297,447 @@ TEST_F(TemplateProcessorTest, RemoveModeValidationInProcess) {
         TemplateProcessor processor(remove_options);
         auto result = processor.process(valid_template, context);
     });
-}
\ No newline at end of file
+}
+
+TEST_F(TemplateProcessorTest, RvalueContextMovesLastUse) {
+    TemplateProcessor processor(default_options);
+    
+    nlohmann::json template_json = R"({
+        "first": "${/preferences}",
+        "second": "${/preferences}",
+        "name": "${/user/name}"
+    })"_json;
+    
+    nlohmann::json owned_context = context;
+    auto result = processor.process(template_json, std::move(owned_context));
+    
+    EXPECT_EQ(result["first"], context["preferences"]);
+    EXPECT_EQ(result["second"], context["preferences"]);
+    EXPECT_EQ(result["name"], "Alice");
+    
+    // Single-use values are moved rather than copied
+    EXPECT_TRUE(owned_context["user"]["name"].is_null());
+}
+
+TEST_F(TemplateProcessorTest, RvalueContextCopiesOverlappingValues) {
+    TemplateProcessor processor(interpolation_options);
+    
+    // /user contains /user/name, and /user/id is also read by interpolation
+    nlohmann::json template_json = R"({
+        "a_name": "${/user/name}",
+        "b_user": "${/user}",
+        "c_id": "${/user/id}",
+        "d_text": "id=${/user/id}"
+    })"_json;
+    
+    auto expected = processor.process(template_json, context);
+    nlohmann::json owned_context = context;
+    auto result = processor.process(template_json, std::move(owned_context));
+    
+    EXPECT_EQ(result, expected);
+    EXPECT_EQ(result["b_user"], context["user"]);
+    EXPECT_EQ(result["d_text"], "id=123");
+}
+
+TEST_F(TemplateProcessorTest, InplaceMatchesProcess) {
+    Options remove_options;
+    remove_options.missing_key_behavior = MissingKeyBehavior::Remove;
+    TemplateProcessor processor(remove_options);
+    
+    nlohmann::json template_json = R"({
+        "name": "${/user/name}",
+        "missing": "${/user/missing}",
+        "list": ["${/missing/a}", "keep", "${/user/id}", "${/missing/b}", {"theme": "${/preferences/theme}"}],
+        "literal": [1, 2, 3]
+    })"_json;
+    
+    auto expected = processor.process(template_json, context);
+    
+    nlohmann::json doc = template_json;
+    processor.process_inplace(doc, context);
+    EXPECT_EQ(doc, expected);
+    
+    nlohmann::json owned_doc = template_json;
+    processor.process_inplace(owned_doc, nlohmann::json(context));
+    EXPECT_EQ(owned_doc, expected);
+}
+
+TEST_F(TemplateProcessorTest, RemoveModeDecidesBeforeDepthCheck) {
+    Options remove_options;
+    remove_options.missing_key_behavior = MissingKeyBehavior::Remove;
+    remove_options.max_recursion_depth = 2;
+    TemplateProcessor processor(remove_options);
+    
+    // Missing placeholders at the depth limit are removed without being processed
+    nlohmann::json removable = R"({"outer": {"gone": "${/missing}"}})"_json;
+    auto result = processor.process(removable, context);
+    EXPECT_EQ(result, R"({"outer": {}})"_json);
+    
+    nlohmann::json doc = removable;
+    processor.process_inplace(doc, context);
+    EXPECT_EQ(doc, result);
+    
+    // Present placeholders at the same depth still hit the limit
+    nlohmann::json present = R"({"outer": {"name": "${/user/name}"}})"_json;
+    EXPECT_THROW(processor.process(present, context), RecursionLimitException);
+    EXPECT_THROW(processor.process_inplace(present, context), RecursionLimitException);
+}
+
+TEST_F(TemplateProcessorTest, InterpolatedNumbersMatchDump) {
+    TemplateProcessor processor(interpolation_options);
+    
+    nlohmann::json numbers = nlohmann::json::array({
+        0.7, 0.1, 1.0, -2.0, 1e20, 1e-7, 123456789.123, 3.141592653589793, 5e-324,
+        0, -42, int64_t{-9223372036854775807LL - 1}, uint64_t{18446744073709551615ULL}
+    });
+    
+    for (const auto& number : numbers) {
+        nlohmann::json number_context = {{"n", number}};
+        auto result = processor.process("value=${/n}", number_context);
+        EXPECT_EQ(result, "value=" + number.dump());
+        
+        // Shortest text still parses back to the same value
+        EXPECT_EQ(nlohmann::json::parse(result.get<std::string>().substr(6)), number);
+    }
+    
+    nlohmann::json nan_context = {{"n", std::nan("")}};
+    EXPECT_EQ(processor.process("value=${/n}", nan_context), "value=null");
+}
+
+TEST_F(TemplateProcessorTest, InterpolatedFloatsUseDumpNotation) {
+    TemplateProcessor processor(interpolation_options);
+    
+    // Around the switches between fixed and exponent notation, where
+    // shortest-digit formatters choose differently from dump()
+    for (double number : {1.2345678901234568e17, -1.2345678901234568e17, 1e15, 1e16, 1.5e16,
+                          123456789012345.6, 1e-4, 1.5e-4, 1e-5, 1.2345678901234568e-17, 1e300}) {
+        nlohmann::json number_context = {{"n", number}};
+        EXPECT_EQ(processor.process("x${/n}", number_context), "x" + nlohmann::json(number).dump());
+    }
+    
+    nlohmann::json large = {{"n", 1.2345678901234568e17}};
+    EXPECT_EQ(processor.process("x${/n}", large), "x1.2345678901234568e+17");
+}
+
+TEST_F(TemplateProcessorTest, RepeatedObjectInterpolation) {
+    TemplateProcessor processor(interpolation_options);
+    
+    nlohmann::json template_json = R"({
+        "first": "Prefs: ${/preferences}",
+        "second": ["Both: ${/preferences} and ${/preferences}", "User ${/user}"]
+    })"_json;
+    
+    auto result = processor.process(template_json, context);
+    std::string prefs = context["preferences"].dump();
+    EXPECT_EQ(result["first"], "Prefs: " + prefs);
+    EXPECT_EQ(result["second"][0], "Both: " + prefs + " and " + prefs);
+    EXPECT_EQ(result["second"][1], "User " + context["user"].dump());
+    
+    // A later call with a different context does not reuse earlier dumps
+    nlohmann::json other = context;
+    other["preferences"]["theme"] = "light";
+    EXPECT_EQ(processor.process(template_json, other)["first"], "Prefs: " + other["preferences"].dump());
+}
+
+TEST_F(TemplateProcessorTest, ParallelMatchesSerial) {
+    nlohmann::json items = nlohmann::json::array();
+    nlohmann::json lookup = nlohmann::json::object();
+    for (int i = 0; i < 2000; ++i) {
+        items.push_back({{"id", "${/user/id}"}, {"text", "Item " + std::to_string(i) + " for ${/user/name}"}});
+        lookup["key_" + std::to_string(i)] = i % 3 == 0 ? "${/preferences/theme}" : "literal";
+    }
+    nlohmann::json template_json = {{"items", items}, {"lookup", lookup}};
+    
+    Options parallel_options = interpolation_options;
+    parallel_options.parallel_threshold = 100;
+    parallel_options.parallel_threads = 4;
+    
+    auto serial = TemplateProcessor(interpolation_options).process(template_json, context);
+    auto parallel = TemplateProcessor(parallel_options).process(template_json, context);
+    EXPECT_EQ(parallel, serial);
+}
+
+TEST_F(TemplateProcessorTest, ParallelRemoveMode) {
+    nlohmann::json template_json = nlohmann::json::array();
+    for (int i = 0; i < 1000; ++i) {
+        template_json.push_back(i % 2 == 0 ? "${/user/name}" : "${/user/missing}");
+    }
+    
+    Options remove_options;
+    remove_options.missing_key_behavior = MissingKeyBehavior::Remove;
+    Options parallel_options = remove_options;
+    parallel_options.parallel_threshold = 10;
+    parallel_options.parallel_threads = 4;
+    
+    auto result = TemplateProcessor(parallel_options).process(template_json, context);
+    EXPECT_EQ(result.size(), 500);
+    EXPECT_EQ(result, TemplateProcessor(remove_options).process(template_json, context));
+}
+
+TEST_F(TemplateProcessorTest, ParallelErrorsMatchSerial) {
+    // Several elements fail; the parallel engine must report the first one
+    nlohmann::json template_json = nlohmann::json::array();
+    for (int i = 0; i < 1000; ++i) {
+        template_json.push_back("${/user/name}");
+    }
+    template_json[371] = "${/missing/first}";
+    template_json[372] = "${/missing/second}";
+    template_json[900] = "${/missing/third}";
+    
+    Options parallel_options = error_options;
+    parallel_options.parallel_threshold = 10;
+    parallel_options.parallel_threads = 4;
+    
+    for (int run = 0; run < 10; ++run) {
+        try {
+            TemplateProcessor(parallel_options).process(template_json, context);
+            FAIL() << "Expected MissingKeyException";
+        } catch (const MissingKeyException& e) {
+            EXPECT_EQ(e.key_path(), "/missing/first");
+        }
+    }
+}
+
+TEST_F(TemplateProcessorTest, ParallelKeepsRecursionDepth) {
+    // Elements of a parallel array continue at the array's depth
+    nlohmann::json template_json = nlohmann::json::array();
+    for (int i = 0; i < 100; ++i) {
+        template_json.push_back(R"({"a": {"b": "${/user/name}"}})"_json);
+    }
+    
+    Options parallel_options;
+    parallel_options.max_recursion_depth = 3;
+    parallel_options.parallel_threshold = 10;
+    parallel_options.parallel_threads = 4;
+    
+    try {
+        TemplateProcessor(parallel_options).process({{"wrapper", template_json}}, context);
+        FAIL() << "Expected RecursionLimitException";
+    } catch (const RecursionLimitException& e) {
+        EXPECT_EQ(e.depth(), 3);
+    }
+    
+    parallel_options.max_recursion_depth = 5;
+    auto result = TemplateProcessor(parallel_options).process({{"wrapper", template_json}}, context);
+    EXPECT_EQ(result["wrapper"][99]["a"]["b"], "Alice");
+}
+
+namespace {
+    // Result of processing, or a description of the exception thrown
+    std::string outcome(const std::function<nlohmann::json()>& fn) {
+        try {
+            return fn().dump();
+        } catch (const MissingKeyException& e) {
+            return std::string("MissingKeyException ") + e.what() + " " + e.key_path();
+        } catch (const RecursionLimitException& e) {
+            return std::string("RecursionLimitException ") + e.what() + " " + std::to_string(e.depth());
+        } catch (const std::exception& e) {
+            return std::string("exception ") + e.what();
+        }
+    }
+    
+    nlohmann::json nested_template(size_t depth, const nlohmann::json& leaf) {
+        nlohmann::json node = leaf;
+        for (size_t i = 0; i < depth; ++i) {
+            node = (i % 2 == 0) ? nlohmann::json{{"child", std::move(node)}, {"id", "${/user/id}"}}
+                                : nlohmann::json::array({"${/user/name}", std::move(node), "${/missing}"});
+        }
+        return node;
+    }
+}
+
+TEST_F(TemplateProcessorTest, IterativeEngineMatchesRecursive) {
+    std::vector<nlohmann::json> templates = {
+        "${/user/name}",
+        "plain",
+        42,
+        R"({"a": "${/user/id}", "b": ["${/preferences}", "${/missing}", {"c": "Hi ${/user/name}"}], "d": {}})"_json,
+        R"([[], {}, [[["${/user/email}"]]], "${/missing/key}", null, true])"_json,
+        nested_template(12, "${/preferences/theme}")
+    };
+    
+    for (auto behavior : {MissingKeyBehavior::Ignore, MissingKeyBehavior::Error, MissingKeyBehavior::Remove}) {
+        for (bool interpolation : {false, true}) {
+            for (size_t max_depth : {3, 8, 64}) {
+                if (behavior == MissingKeyBehavior::Remove && interpolation) {
+                    continue;
+                }
+                Options recursive_options;
+                recursive_options.missing_key_behavior = behavior;
+                recursive_options.enable_interpolation = interpolation;
+                recursive_options.max_recursion_depth = max_depth;
+                Options iterative_options = recursive_options;
+                iterative_options.engine = ProcessingEngine::Iterative;
+                
+                TemplateProcessor recursive(recursive_options);
+                TemplateProcessor iterative(iterative_options);
+                
+                for (const auto& template_json : templates) {
+                    EXPECT_EQ(outcome([&] { return iterative.process(template_json, context); }),
+                              outcome([&] { return recursive.process(template_json, context); }))
+                        << template_json.dump();
+                    
+                    EXPECT_EQ(outcome([&] { return iterative.process(template_json, nlohmann::json(context)); }),
+                              outcome([&] { return recursive.process(template_json, nlohmann::json(context)); }))
+                        << template_json.dump();
+                    
+                    EXPECT_EQ(outcome([&] { auto doc = template_json; iterative.process_inplace(doc, context); return doc; }),
+                              outcome([&] { auto doc = template_json; recursive.process_inplace(doc, context); return doc; }))
+                        << template_json.dump();
+                }
+            }
+        }
+    }
+}
+
+TEST_F(TemplateProcessorTest, IterativeEngineHandlesDeepTemplates) {
+    const size_t depth = 10000;
+    nlohmann::json template_json = nested_template(depth, "${/user/name}");
+    
+    Options options;
+    options.engine = ProcessingEngine::Iterative;
+    options.max_recursion_depth = depth + 1;
+    TemplateProcessor processor(options);
+    
+    auto result = processor.process(template_json, context);
+    // Built again rather than copied, and compared level by level below:
+    // copying or comparing whole documents this deep recurses natively
+    auto doc = nested_template(depth, "${/user/name}");
+    processor.process_inplace(doc, context);
+    
+    // Walk both down to the leaf without recursion
+    const nlohmann::json* node = &result;
+    const nlohmann::json* inplace_node = &doc;
+    for (size_t i = depth; i > 0; --i) {
+        ASSERT_EQ(node->size(), inplace_node->size()) << "level " << i;
+        if ((i - 1) % 2 == 0) {
+            EXPECT_EQ((*node)["id"], 123);
+            EXPECT_EQ((*inplace_node)["id"], 123);
+            node = &(*node)["child"];
+            inplace_node = &(*inplace_node)["child"];
+        } else {
+            EXPECT_EQ((*node)[0], "Alice");
+            EXPECT_EQ((*inplace_node)[0], "Alice");
+            EXPECT_EQ((*inplace_node)[2], (*node)[2]);
+            node = &(*node)[1];
+            inplace_node = &(*inplace_node)[1];
+        }
+    }
+    EXPECT_EQ(*node, "Alice");
+    EXPECT_EQ(*inplace_node, "Alice");
+    
+    options.max_recursion_depth = depth;
+    EXPECT_THROW(TemplateProcessor(options).process(template_json, context), RecursionLimitException);
+}
+
+namespace {
+    // Context whose values refer to each other
+    nlohmann::json layered_context() {
+        return R"({
+            "model": "${/defaults/model}",
+            "defaults": {"model": "${/models/1}", "temperature": 0.5},
+            "models": ["small", "large"],
+            "greeting": "Hello ${/user/name}, using ${/model}",
+            "user": {"name": "Alice"},
+            "request": {"model": "${/model}", "settings": "${/defaults}", "text": "${/greeting}"}
+        })"_json;
+    }
+}
+
+TEST_F(TemplateProcessorTest, RecursiveExpansionResolvesNestedPlaceholders) {
+    nlohmann::json template_json = R"({"request": "${/request}", "model": "${/model}"})"_json;
+    
+    Options options = interpolation_options;
+    options.recursive_expansion = true;
+    auto result = TemplateProcessor(options).process(template_json, layered_context());
+    
+    EXPECT_EQ(result, R"({
+        "request": {
+            "model": "large",
+            "settings": {"model": "large", "temperature": 0.5},
+            "text": "Hello Alice, using large"
+        },
+        "model": "large"
+    })"_json);
+    
+    // Off by default: resolved values are inserted as they are
+    auto single = TemplateProcessor(interpolation_options).process(template_json, layered_context());
+    EXPECT_EQ(single["model"], "${/defaults/model}");
+}
+
+TEST_F(TemplateProcessorTest, RecursiveExpansionMatchesRepeatedApply) {
+    nlohmann::json template_json = R"(["${/request}", "Text: ${/greeting}", "${/missing}"])"_json;
+    nlohmann::json context = layered_context();
+    
+    Options options = interpolation_options;
+    TemplateProcessor single(options);
+    // Apply until nothing changes, as multi-stage callers do today
+    nlohmann::json expected = template_json;
+    for (nlohmann::json previous; expected != previous;) {
+        previous = expected;
+        expected = single.process(expected, context);
+    }
+    
+    options.recursive_expansion = true;
+    for (auto engine : {ProcessingEngine::Recursive, ProcessingEngine::Iterative}) {
+        options.engine = engine;
+        TemplateProcessor processor(options);
+        EXPECT_EQ(processor.process(template_json, context), expected);
+        EXPECT_EQ(processor.process(template_json, nlohmann::json(context)), expected);
+        
+        auto doc = template_json;
+        processor.process_inplace(doc, context);
+        EXPECT_EQ(doc, expected);
+    }
+}
+
+TEST_F(TemplateProcessorTest, RecursiveExpansionReportsCycleChain) {
+    nlohmann::json context = R"({"a": "${/b}", "b": {"next": "${/c}"}, "c": ["x ${/a}"]})"_json;
+    
+    Options options = interpolation_options;
+    options.recursive_expansion = true;
+    for (auto engine : {ProcessingEngine::Recursive, ProcessingEngine::Iterative}) {
+        options.engine = engine;
+        try {
+            TemplateProcessor(options).process(R"({"value": "${/a}"})"_json, context);
+            FAIL() << "Expected CycleException";
+        } catch (const CycleException& e) {
+            EXPECT_EQ(e.cycle_path(), (std::vector<std::string>{"/a", "/b", "/c", "/a"}));
+        }
+    }
+    
+    // A value referring to itself
+    EXPECT_THROW(TemplateProcessor(options).process("${/self}", R"({"self": "${/self}"})"_json),
+                 CycleException);
+}
+
+TEST_F(TemplateProcessorTest, RecursiveExpansionSharedPathsAreNotCycles) {
+    // Both branches expand /leaf; the second use comes from the memo
+    nlohmann::json context = R"({
+        "leaf": "${/value}",
+        "value": 7,
+        "left": ["${/leaf}"],
+        "right": {"l": "${/leaf}", "both": "${/left}"}
+    })"_json;
+    
+    Options options;
+    options.recursive_expansion = true;
+    auto result = TemplateProcessor(options).process(R"(["${/left}", "${/right}", "${/leaf}"])"_json, context);
+    EXPECT_EQ(result, R"([[7], {"l": 7, "both": [7]}, 7])"_json);
+}
+
+TEST_F(TemplateProcessorTest, RecursiveExpansionCountsTowardsDepthLimit) {
+    nlohmann::json context = nlohmann::json::object();
+    for (int i = 0; i < 10; ++i) {
+        context["p" + std::to_string(i)] = "${/p" + std::to_string(i + 1) + "}";
+    }
+    context["p10"] = "end";
+    
+    Options options;
+    options.recursive_expansion = true;
+    options.max_recursion_depth = 12;
+    EXPECT_EQ(TemplateProcessor(options).process("${/p0}", context), "end");
+    
+    options.max_recursion_depth = 8;
+    EXPECT_THROW(TemplateProcessor(options).process("${/p0}", context), RecursionLimitException);
+}
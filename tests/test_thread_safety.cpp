@@ -0,0 +1,239 @@
+#include <gtest/gtest.h>
+#include <permuto/permuto.hpp>
+#include "../src/template_processor.hpp"
+#include "../src/thread_pool.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace permuto;
+
+namespace {
+    const int THREAD_COUNT = 8;
+    const int ITERATIONS_PER_THREAD = 200;
+}
+
+class ThreadSafetyTest : public ::testing::Test {
+protected:
+    nlohmann::json template_json = R"({
+        "model": "${/config/model}",
+        "user": "${/user/name}",
+        "tokens": "${/config/max_tokens}",
+        "nested": {"id": "${/user/id}"}
+    })"_json;
+
+    nlohmann::json make_context(int id) const {
+        nlohmann::json context;
+        context["config"]["model"] = "model-" + std::to_string(id);
+        context["config"]["max_tokens"] = id * 10;
+        context["user"]["name"] = "user-" + std::to_string(id);
+        context["user"]["id"] = id;
+        return context;
+    }
+
+    bool matches(const nlohmann::json& result, int id) const {
+        return result["model"] == "model-" + std::to_string(id) &&
+               result["user"] == "user-" + std::to_string(id) &&
+               result["tokens"] == id * 10 &&
+               result["nested"]["id"] == id;
+    }
+
+    // Run fn(thread_index, iteration) on THREAD_COUNT threads, counting failed checks
+    template <typename Fn>
+    int run_concurrently(Fn fn) {
+        std::atomic<int> failures{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREAD_COUNT; ++t) {
+            threads.emplace_back([&, t]() {
+                for (int i = 0; i < ITERATIONS_PER_THREAD; ++i) {
+                    if (!fn(t, i)) {
+                        ++failures;
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        return failures.load();
+    }
+};
+
+TEST_F(ThreadSafetyTest, ConcurrentApply) {
+    int failures = run_concurrently([this](int t, int i) {
+        int id = t * ITERATIONS_PER_THREAD + i;
+        return matches(permuto::apply(template_json, make_context(id)), id);
+    });
+
+    EXPECT_EQ(failures, 0);
+}
+
+TEST_F(ThreadSafetyTest, DifferentTemplatesPerThread) {
+    Options interp_opts;
+    interp_opts.enable_interpolation = true;
+
+    int failures = run_concurrently([this, &interp_opts](int t, int i) {
+        nlohmann::json per_thread_template;
+        per_thread_template["thread"] = t;
+        per_thread_template["text"] = "Thread " + std::to_string(t) + " sees ${/user/name}";
+
+        auto result = permuto::apply(per_thread_template, make_context(i), interp_opts);
+        return result["thread"] == t &&
+               result["text"] == "Thread " + std::to_string(t) + " sees user-" + std::to_string(i);
+    });
+
+    EXPECT_EQ(failures, 0);
+}
+
+TEST_F(ThreadSafetyTest, SharedProcessorInstance) {
+    const TemplateProcessor processor;
+
+    int failures = run_concurrently([this, &processor](int t, int i) {
+        int id = t * ITERATIONS_PER_THREAD + i;
+        return matches(processor.process(template_json, make_context(id)), id);
+    });
+
+    EXPECT_EQ(failures, 0);
+}
+
+TEST_F(ThreadSafetyTest, SharedCompiledTemplate) {
+    const CompiledTemplate compiled(template_json);
+
+    int failures = run_concurrently([this, &compiled](int t, int i) {
+        int id = t * ITERATIONS_PER_THREAD + i;
+        return matches(compiled.apply(make_context(id)), id);
+    });
+
+    EXPECT_EQ(failures, 0);
+}
+
+TEST_F(ThreadSafetyTest, ConcurrentReverseOperations) {
+    int failures = run_concurrently([this](int t, int i) {
+        int id = t * ITERATIONS_PER_THREAD + i;
+        auto context = make_context(id);
+        auto result = permuto::apply(template_json, context);
+        auto reverse_template = permuto::create_reverse_template(template_json);
+        return permuto::apply_reverse(reverse_template, result) == context;
+    });
+
+    EXPECT_EQ(failures, 0);
+}
+
+TEST_F(ThreadSafetyTest, ThreadLocalStateIsolation) {
+    // Errors on some threads must not leak processing state into others
+    Options error_opts;
+    error_opts.missing_key_behavior = MissingKeyBehavior::Error;
+
+    int failures = run_concurrently([this, &error_opts](int t, int i) {
+        int id = t * ITERATIONS_PER_THREAD + i;
+        if (t % 2 == 0) {
+            try {
+                permuto::apply(template_json, nlohmann::json::object(), error_opts);
+                return false;
+            } catch (const MissingKeyException&) {
+                return true;
+            }
+        }
+        return matches(permuto::apply(template_json, make_context(id), error_opts), id);
+    });
+
+    EXPECT_EQ(failures, 0);
+}
+
+TEST_F(ThreadSafetyTest, ApplyBatchMatchesApply) {
+    std::vector<nlohmann::json> contexts;
+    for (int id = 0; id < 500; ++id) {
+        contexts.push_back(make_context(id));
+    }
+
+    BatchOptions batch_opts;
+    batch_opts.threads = THREAD_COUNT;
+    auto results = permuto::apply_batch(template_json, contexts, {}, batch_opts);
+
+    ASSERT_EQ(results.size(), contexts.size());
+    for (int id = 0; id < 500; ++id) {
+        ASSERT_TRUE(results[id].ok());
+        EXPECT_TRUE(matches(results[id].result, id)) << "context " << id;
+    }
+}
+
+TEST_F(ThreadSafetyTest, ApplyBatchCapturesPerItemErrors) {
+    Options error_opts;
+    error_opts.missing_key_behavior = MissingKeyBehavior::Error;
+
+    std::vector<nlohmann::json> contexts;
+    for (int id = 0; id < 100; ++id) {
+        contexts.push_back(id % 3 == 0 ? nlohmann::json::object() : make_context(id));
+    }
+
+    BatchOptions batch_opts;
+    batch_opts.threads = 4;
+    auto results = permuto::apply_batch(template_json, contexts, error_opts, batch_opts);
+
+    ASSERT_EQ(results.size(), contexts.size());
+    for (int id = 0; id < 100; ++id) {
+        if (id % 3 == 0) {
+            ASSERT_FALSE(results[id].ok());
+            EXPECT_THROW(std::rethrow_exception(results[id].error), MissingKeyException);
+        } else {
+            ASSERT_TRUE(results[id].ok());
+            EXPECT_TRUE(matches(results[id].result, id));
+        }
+    }
+}
+
+TEST_F(ThreadSafetyTest, ApplyBatchInvalidOptionsThrowUpFront) {
+    Options bad_opts;
+    bad_opts.start_marker = "";
+
+    std::vector<nlohmann::json> contexts(3, make_context(1));
+    EXPECT_THROW(permuto::apply_batch(template_json, contexts, bad_opts), std::invalid_argument);
+    EXPECT_TRUE(permuto::apply_batch(template_json, {}).empty());
+}
+
+TEST_F(ThreadSafetyTest, ParallelForVisitsEachIndexOnce) {
+    const size_t count = 10007;
+    std::vector<std::atomic<int>> visits(count);
+
+    parallel_for(count, THREAD_COUNT, [&](size_t index) {
+        ++visits[index];
+    });
+
+    for (size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(visits[i].load(), 1) << "index " << i;
+    }
+}
+
+TEST_F(ThreadSafetyTest, ParallelForRethrowsLowestFailingIndex) {
+    for (int run = 0; run < 20; ++run) {
+        try {
+            parallel_for(1000, THREAD_COUNT, [](size_t index) {
+                if (index % 97 == 13) {
+                    throw std::runtime_error(std::to_string(index));
+                }
+            });
+            FAIL() << "Expected an exception";
+        } catch (const std::runtime_error& e) {
+            EXPECT_STREQ(e.what(), "13");
+        }
+    }
+}
+
+TEST_F(ThreadSafetyTest, ParallelForSingleThreadRunsInline) {
+    const auto caller = std::this_thread::get_id();
+    std::vector<size_t> order;
+
+    parallel_for(100, 1, [&](size_t index, size_t worker) {
+        EXPECT_EQ(std::this_thread::get_id(), caller);
+        EXPECT_EQ(worker, 0u);
+        order.push_back(index);
+    });
+
+    ASSERT_EQ(order.size(), 100u);
+    for (size_t i = 0; i < order.size(); ++i) {
+        EXPECT_EQ(order[i], i);
+    }
+
+    EXPECT_THROW(parallel_for(1, THREAD_COUNT, [](size_t) { throw std::runtime_error("0"); }),
+                 std::runtime_error);
+}